@@ -0,0 +1,83 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniDebugDrawSubsystem.h"
+#include "OmniToolbox.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include <atomic>
+
+/**Measures what a debug draw costs the thread that submits it.
+ * Every draw is timed on its own, so the ParallelFor overhead isn't counted.
+ * QueueShape is called directly, DrawAndLog* would add the shape right away
+ * for the iterations ParallelFor runs on the game thread.
+ * The task graph path that DrawAndLog* used before is measured as well,
+ * with an empty task that captures the same data, for comparison.*/
+static FAutoConsoleCommandWithWorldAndArgs DrawQueueBenchmarkCommand(
+	TEXT("OmniToolbox.Debug.DrawQueueBenchmark"),
+	TEXT("Submit debug lines from worker threads and log the producer cost per draw call, ")
+	TEXT("for the debug draw queue and for a task graph task per draw. Arguments: [NumDraws=10000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		//Resolved here, the producers run on worker threads
+		UOmniDebugDrawSubsystem* DrawSubsystem = World ? World->GetSubsystem<UOmniDebugDrawSubsystem>() : nullptr;
+		if(!DrawSubsystem)
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("DrawQueueBenchmark: No world with a debug draw subsystem"));
+			return;
+		}
+
+		const int32 NumDraws = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+
+		auto GetLine = [](int32 DrawIndex, FVector& OutStart, FVector& OutEnd)
+		{
+			OutStart = FVector(DrawIndex % 100 * 50.0, DrawIndex / 100 * 50.0, 100);
+			OutEnd = OutStart + FVector(0, 0, 100);
+		};
+
+		std::atomic<uint64> QueueCycles = 0;
+		const double QueueStartTime = FPlatformTime::Seconds();
+		ParallelFor(TEXT("OmniDebugDrawBenchmark::Queue"), NumDraws, 64, [&](int32 DrawIndex)
+		{
+			FVector Start, End;
+			GetLine(DrawIndex, Start, End);
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			FOmniDebugDrawCommand DrawCommand;
+			DrawCommand.Owner = World;
+			DrawCommand.Type = EOmniDebugDrawType::Line;
+			DrawCommand.Location = Start;
+			DrawCommand.End = End;
+			DrawCommand.Color = FLinearColor::Green;
+			DrawCommand.LogCategory = TEXT("VisLog");
+			DrawCommand.Lifetime = 1;
+			DrawSubsystem->QueueShape(MoveTemp(DrawCommand), NAME_None);
+			QueueCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+		});
+		const double QueueWallTime = FPlatformTime::Seconds() - QueueStartTime;
+
+		std::atomic<uint64> TaskCycles = 0;
+		const double TaskStartTime = FPlatformTime::Seconds();
+		ParallelFor(TEXT("OmniDebugDrawBenchmark::Task"), NumDraws, 64, [&](int32 DrawIndex)
+		{
+			FVector Start, End;
+			GetLine(DrawIndex, Start, End);
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			FOmniDebugDrawCommand DrawCommand;
+			DrawCommand.Type = EOmniDebugDrawType::Line;
+			DrawCommand.Location = Start;
+			DrawCommand.End = End;
+			DrawCommand.Color = FLinearColor::Green;
+			DrawCommand.LogCategory = TEXT("VisLog");
+			AsyncTask(ENamedThreads::GameThread, [DrawCommand = MoveTemp(DrawCommand), Key = FString()]() {});
+			TaskCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+		});
+		const double TaskWallTime = FPlatformTime::Seconds() - TaskStartTime;
+
+		const double QueueNs = FPlatformTime::ToMilliseconds64(QueueCycles.load()) * 1000000.0 / NumDraws;
+		const double TaskNs = FPlatformTime::ToMilliseconds64(TaskCycles.load()) * 1000000.0 / NumDraws;
+		UE_LOG(LogOmniToolbox, Log, TEXT("DrawQueueBenchmark: %d draws from worker threads"), NumDraws);
+		UE_LOG(LogOmniToolbox, Log, TEXT("    Draw queue:      %.0fns per draw, %.2fms wall time"), QueueNs, QueueWallTime * 1000.0);
+		UE_LOG(LogOmniToolbox, Log, TEXT("    Task per draw:   %.0fns per draw, %.2fms wall time"), TaskNs, TaskWallTime * 1000.0);
+		UE_LOG(LogOmniToolbox, Log, TEXT("    The queued lines are added during the next tick of the debug draw subsystem"));
+	}));
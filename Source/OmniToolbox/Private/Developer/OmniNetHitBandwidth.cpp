@@ -0,0 +1,187 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "OmniToolbox.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerController.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/CoreNet.h"
+
+namespace OmniNetHitBandwidth
+{
+	struct FMeasurement
+	{
+		int64 Bits = 0;
+		bool bRoundTripSucceeded = false;
+		double MaxPositionError = 0;
+		double MaxNormalError = 0;
+		int32 NumLostComponents = 0;
+	};
+
+	/**Write @HitResults as a FOmniNetHitArray and read it back, to find out how many bits
+	 * they take and how much precision was lost. @PackageMap may only be null when none
+	 * of the hits reference a component or actor.*/
+	FMeasurement Measure(const TArray<FHitResult>& HitResults, UPackageMap* PackageMap)
+	{
+		FMeasurement Measurement;
+
+		FOmniNetHitArray NetHits = UOmniTraceLibrary::MakeNetHits(HitResults);
+		FNetBitWriter Writer(PackageMap, 0);
+		bool bWriteSuccess = true;
+		NetHits.NetSerialize(Writer, PackageMap, bWriteSuccess);
+		Measurement.Bits = Writer.GetNumBits();
+
+		FNetBitReader Reader(PackageMap, Writer.GetData(), Writer.GetNumBits());
+		FOmniNetHitArray ReceivedHits;
+		bool bReadSuccess = true;
+		ReceivedHits.NetSerialize(Reader, PackageMap, bReadSuccess);
+		Measurement.bRoundTripSucceeded = bWriteSuccess && bReadSuccess && !Reader.IsError()
+			&& ReceivedHits.Hits.Num() == HitResults.Num();
+
+		TArray<FHitResult> ReceivedHitResults;
+		UOmniTraceLibrary::FromNetHits(ReceivedHits.Hits, ReceivedHitResults);
+		for(int32 HitIndex = 0; HitIndex < FMath::Min(ReceivedHitResults.Num(), HitResults.Num()); ++HitIndex)
+		{
+			Measurement.MaxPositionError = FMath::Max(Measurement.MaxPositionError, FVector::Dist(ReceivedHitResults[HitIndex].ImpactPoint, HitResults[HitIndex].ImpactPoint));
+			Measurement.MaxNormalError = FMath::Max(Measurement.MaxNormalError, FVector::Dist(ReceivedHitResults[HitIndex].ImpactNormal, HitResults[HitIndex].ImpactNormal));
+			Measurement.NumLostComponents += ReceivedHitResults[HitIndex].GetComponent() != HitResults[HitIndex].GetComponent() ? 1 : 0;
+		}
+
+		return Measurement;
+	}
+}
+
+/**Compares the size of FOmniNetHit against FHitResult, using real hits and the
+ * package map of an actual connection. Run it in PIE with a listen server and
+ * at least one client, either on the server or on a client.
+ * The OmniToolbox.Trace.NetHitBandwidth automation test covers the size without a connection.*/
+static FAutoConsoleCommandWithWorldAndArgs NetHitBandwidthCommand(
+	TEXT("OmniToolbox.Trace.NetHitBandwidth"),
+	TEXT("Trace a hemisphere of rays from the local player's view and log how many bits the hits take as FHitResult and as FOmniNetHit. ")
+	TEXT("Requires a net connection. Arguments: [NumRays=64]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if(!PlayerController || !NetDriver)
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("NetHitBandwidth: Needs a local player and a net driver, run it in PIE with a listen server"));
+			return;
+		}
+
+		const UNetConnection* Connection = NetDriver->ServerConnection ? NetDriver->ServerConnection.Get()
+			: NetDriver->ClientConnections.IsEmpty() ? nullptr : NetDriver->ClientConnections[0].Get();
+		UPackageMap* PackageMap = Connection ? Connection->PackageMap.Get() : nullptr;
+		if(!PackageMap)
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("NetHitBandwidth: No connection found, connect at least one client"));
+			return;
+		}
+
+		FOmniFanTraceSettings Settings;
+		Settings.Pattern = EOmniFanTracePattern::Hemisphere;
+		Settings.NumRays = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 64;
+		Settings.Range = 10000;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		TArray<FVector> Directions;
+		UOmniTraceLibrary::GenerateFanTraceDirections(FQuat(ViewRotation), Settings, Directions);
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(OmniNetHitBandwidth), false, PlayerController->GetPawn());
+		TArray<FHitResult> HitResults;
+		for(const FVector& Direction : Directions)
+		{
+			FHitResult HitResult;
+			if(World->LineTraceSingleByChannel(HitResult, ViewLocation, ViewLocation + Direction * Settings.Range, ECC_Visibility, QueryParams))
+			{
+				HitResults.Add(HitResult);
+			}
+		}
+
+		if(HitResults.IsEmpty())
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("NetHitBandwidth: Nothing was hit"));
+			return;
+		}
+
+		//Plain FHitResult array, the same way a replicated TArray<FHitResult> RPC parameter would be written
+		FNetBitWriter FullWriter(PackageMap, 0);
+		uint32 NumHits = HitResults.Num();
+		FullWriter.SerializeIntPacked(NumHits);
+		for(FHitResult& HitResult : HitResults)
+		{
+			bool bSuccess = true;
+			HitResult.NetSerialize(FullWriter, PackageMap, bSuccess);
+		}
+
+		const OmniNetHitBandwidth::FMeasurement Compact = OmniNetHitBandwidth::Measure(HitResults, PackageMap);
+
+		const int64 FullBits = FullWriter.GetNumBits();
+		UE_LOG(LogOmniToolbox, Log, TEXT("NetHitBandwidth: %d hits on the %s"), HitResults.Num(), NetDriver->ServerConnection ? TEXT("client") : TEXT("server"));
+		UE_LOG(LogOmniToolbox, Log, TEXT("    FHitResult:  %lld bits (%.1f bytes per hit)"), FullBits, FullBits / 8.0 / HitResults.Num());
+		UE_LOG(LogOmniToolbox, Log, TEXT("    FOmniNetHit: %lld bits (%.1f bytes per hit), %.1f%% of FHitResult"), Compact.Bits, Compact.Bits / 8.0 / HitResults.Num(),
+			FullBits > 0 ? Compact.Bits * 100.0 / FullBits : 0.0);
+		UE_LOG(LogOmniToolbox, Log, TEXT("    Round trip: %s, max impact point error %.3fcm, max normal error %.4f, %d components not referenceable"),
+			Compact.bRoundTripSucceeded ? TEXT("succeeded") : TEXT("FAILED"), Compact.MaxPositionError, Compact.MaxNormalError, Compact.NumLostComponents);
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniNetHitBandwidthTest, "OmniToolbox.Trace.NetHitBandwidth",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FOmniNetHitBandwidthTest::RunTest(const FString& Parameters)
+{
+	/**Budgets for a hit without a component or actor, inside of a 100m cube.
+	 * The same hit as FHitResult takes several times as much.*/
+	constexpr int32 MaxBitsPerLineHit = 192;
+	constexpr int32 MaxBitsPerSweepHit = 256;
+	constexpr int32 NumHits = 256;
+
+	//Component and actor references need a real connection, so these hits don't have any
+	FRandomStream Random(0x4F4E4854);
+	TArray<FHitResult> LineHits;
+	TArray<FHitResult> SweepHits;
+	for(int32 HitIndex = 0; HitIndex < NumHits; ++HitIndex)
+	{
+		FHitResult HitResult;
+		HitResult.bBlockingHit = Random.FRand() < 0.75f;
+		HitResult.ImpactPoint = FVector(Random.FRandRange(-5000, 5000), Random.FRandRange(-5000, 5000), Random.FRandRange(-5000, 5000));
+		HitResult.Location = HitResult.ImpactPoint;
+		HitResult.ImpactNormal = Random.GetUnitVector();
+		HitResult.Distance = Random.FRandRange(0, 10000);
+		LineHits.Add(HitResult);
+
+		//Sweeps end up short of the impact point, so their location is sent as well
+		HitResult.Location = HitResult.ImpactPoint + HitResult.ImpactNormal * Random.FRandRange(1, 50);
+		SweepHits.Add(HitResult);
+	}
+
+	auto TestHits = [this](const TCHAR* Name, const TArray<FHitResult>& HitResults, int32 MaxBitsPerHit)
+	{
+		const OmniNetHitBandwidth::FMeasurement Measurement = OmniNetHitBandwidth::Measure(HitResults, nullptr);
+		const double BitsPerHit = static_cast<double>(Measurement.Bits) / HitResults.Num();
+		AddInfo(FString::Printf(TEXT("%s hits take %.1f bits per hit"), Name, BitsPerHit));
+
+		TestTrue(FString::Printf(TEXT("%s hits survive the round trip"), Name), Measurement.bRoundTripSucceeded);
+		TestTrue(FString::Printf(TEXT("%s hits take %.1f bits per hit, the budget is %d"), Name, BitsPerHit, MaxBitsPerHit),
+			BitsPerHit <= MaxBitsPerHit);
+		//Impact points are quantized to 0.1cm, normals to 16 bits per axis
+		TestTrue(FString::Printf(TEXT("%s impact point error of %.3fcm"), Name, Measurement.MaxPositionError), Measurement.MaxPositionError <= 0.1);
+		TestTrue(FString::Printf(TEXT("%s normal error of %.5f"), Name, Measurement.MaxNormalError), Measurement.MaxNormalError <= 0.001);
+	};
+
+	TestHits(TEXT("Line"), LineHits, MaxBitsPerLineHit);
+	TestHits(TEXT("Sweep"), SweepHits, MaxBitsPerSweepHit);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,440 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Developer/OmniTraceHeatmap.h"
+#include "OmniToolbox.h"
+#include "OmniRuntimeMacros.h"
+#include "Engine/HitResult.h"
+#include "Engine/World.h"
+#include "FunctionLibraries/OmniEditorLibrary.h"
+#include "HAL/PlatformProcess.h"
+#include "ImageUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <atomic>
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, RecordTraceHeatmap, false,
+	"OmniToolbox.Trace.Heatmap",
+	"Bin the start, end and hit points of every OmniTraceLibrary trace into a heatmap per TraceTag");
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, float, TraceHeatmapCellSize, 200.f,
+	"OmniToolbox.Trace.HeatmapCellSize",
+	"Size of a single heatmap cell in centimeters");
+
+namespace OmniTraceHeatmap
+{
+	/**Must be a power of two*/
+	constexpr int32 NumSlots = 1 << 16;
+	constexpr int32 MaxProbes = 64;
+
+	/**6 bits of the key are used for the tag*/
+	constexpr int32 MaxTags = 64;
+
+	/**19 bits per axis, which covers ±262144 cells*/
+	constexpr int32 CellBits = 19;
+	constexpr int32 CellBias = 1 << (CellBits - 1);
+	constexpr uint64 CellMask = (1ull << CellBits) - 1;
+	constexpr uint64 OccupiedBit = 1ull << 63;
+
+	struct FSlot
+	{
+		/**0 while the slot is empty*/
+		std::atomic<uint64> Key { 0 };
+		std::atomic<uint32> Counts[static_cast<int32>(EOmniTraceHeatmapChannel::Num)] = {};
+	};
+
+	struct FTagSlot
+	{
+		/**0 is empty, 1 is being written, 2 is ready to be read*/
+		std::atomic<uint8> State { 0 };
+		FName Tag;
+	};
+
+	/**Only allocated once the heatmap is used for the first time*/
+	FSlot* GetSlots()
+	{
+		static TUniquePtr<FSlot[]> Slots = MakeUnique<FSlot[]>(NumSlots);
+		return Slots.Get();
+	}
+
+	FTagSlot TagSlots[MaxTags];
+	std::atomic<int64> DroppedPoints { 0 };
+
+	int32 FindOrAddTag(FName Tag)
+	{
+		for(int32 TagIndex = 0; TagIndex < MaxTags; ++TagIndex)
+		{
+			FTagSlot& Slot = TagSlots[TagIndex];
+			uint8 State = Slot.State.load(std::memory_order_acquire);
+			if(State == 0)
+			{
+				uint8 Expected = 0;
+				if(Slot.State.compare_exchange_strong(Expected, 1, std::memory_order_acq_rel))
+				{
+					Slot.Tag = Tag;
+					Slot.State.store(2, std::memory_order_release);
+					return TagIndex;
+				}
+				State = Expected;
+			}
+
+			//Another thread is claiming this slot, which only takes a few instructions
+			while(State == 1)
+			{
+				FPlatformProcess::Yield();
+				State = Slot.State.load(std::memory_order_acquire);
+			}
+
+			if(Slot.Tag == Tag)
+			{
+				return TagIndex;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	uint64 MakeKey(int32 TagIndex, const FIntVector& Cell)
+	{
+		return OccupiedBit
+			| static_cast<uint64>(TagIndex) << (CellBits * 3)
+			| (static_cast<uint64>(Cell.X + CellBias) & CellMask) << (CellBits * 2)
+			| (static_cast<uint64>(Cell.Y + CellBias) & CellMask) << CellBits
+			| (static_cast<uint64>(Cell.Z + CellBias) & CellMask);
+	}
+
+	void BreakKey(uint64 Key, int32& OutTagIndex, FIntVector& OutCell)
+	{
+		OutTagIndex = static_cast<int32>((Key >> (CellBits * 3)) & (MaxTags - 1));
+		OutCell.X = static_cast<int32>((Key >> (CellBits * 2)) & CellMask) - CellBias;
+		OutCell.Y = static_cast<int32>((Key >> CellBits) & CellMask) - CellBias;
+		OutCell.Z = static_cast<int32>(Key & CellMask) - CellBias;
+	}
+
+	FIntVector ToCell(const FVector& Location)
+	{
+		const double CellSize = FMath::Max(static_cast<double>(TraceHeatmapCellSize), 1.0);
+		return FIntVector(
+			FMath::Clamp(FMath::FloorToInt32(Location.X / CellSize), -CellBias, CellBias - 1),
+			FMath::Clamp(FMath::FloorToInt32(Location.Y / CellSize), -CellBias, CellBias - 1),
+			FMath::Clamp(FMath::FloorToInt32(Location.Z / CellSize), -CellBias, CellBias - 1));
+	}
+
+	FString MakeFilePath(const TCHAR* Prefix, const TCHAR* Extension)
+	{
+		const FString Directory = FPaths::ProjectSavedDir() / TEXT("OmniTrace");
+		IFileManager::Get().MakeDirectory(*Directory, true);
+
+		const FDateTime Now = FDateTime::Now();
+		return Directory / FString::Printf(TEXT("%s_%02d-%02d-%04d_%02d-%02d-%02d.%s"), Prefix,
+			Now.GetDay(), Now.GetMonth(), Now.GetYear(),
+			Now.GetHour(), Now.GetMinute(), Now.GetSecond(), Extension);
+	}
+
+	/**Blue for the quietest cells, red for the busiest*/
+	FLinearColor GetHeatColor(float Alpha)
+	{
+		return FLinearColor::LerpUsingHSV(FLinearColor::Blue, FLinearColor::Red, FMath::Clamp(Alpha, 0.f, 1.f));
+	}
+
+	TOptional<FName> ParseTag(const TArray<FString>& Args, int32 Index)
+	{
+		if(!Args.IsValidIndex(Index) || Args[Index] == TEXT("*"))
+		{
+			return TOptional<FName>();
+		}
+
+		return FName(*Args[Index]);
+	}
+}
+
+bool FOmniTraceHeatmap::IsEnabled()
+{
+	return RecordTraceHeatmap;
+}
+
+void FOmniTraceHeatmap::RecordTrace(FName TraceTag, const FVector& Start, const FVector& End,
+	TConstArrayView<FHitResult> HitResults)
+{
+	RecordPoint(TraceTag, Start, EOmniTraceHeatmapChannel::Start);
+	RecordPoint(TraceTag, End, EOmniTraceHeatmapChannel::End);
+	for(const FHitResult& HitResult : HitResults)
+	{
+		//Test traces return empty hit results, those don't have a location
+		if(HitResult.bBlockingHit || HitResult.GetComponent())
+		{
+			RecordPoint(TraceTag, HitResult.ImpactPoint, EOmniTraceHeatmapChannel::Hit);
+		}
+	}
+}
+
+void FOmniTraceHeatmap::RecordPoint(FName TraceTag, const FVector& Location, EOmniTraceHeatmapChannel Channel)
+{
+	using namespace OmniTraceHeatmap;
+
+	const int32 TagIndex = FindOrAddTag(TraceTag);
+	if(TagIndex == INDEX_NONE)
+	{
+		DroppedPoints.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const uint64 Key = MakeKey(TagIndex, ToCell(Location));
+	FSlot* Slots = GetSlots();
+
+	uint32 SlotIndex = static_cast<uint32>(GetTypeHash(Key)) & (NumSlots - 1);
+	for(int32 Probe = 0; Probe < MaxProbes; ++Probe, SlotIndex = (SlotIndex + 1) & (NumSlots - 1))
+	{
+		FSlot& Slot = Slots[SlotIndex];
+		uint64 SlotKey = Slot.Key.load(std::memory_order_relaxed);
+		if(SlotKey == 0)
+		{
+			//Claim the slot, if another thread beat us to it we check whether it claimed it for the same cell
+			uint64 Expected = 0;
+			if(Slot.Key.compare_exchange_strong(Expected, Key, std::memory_order_relaxed))
+			{
+				SlotKey = Key;
+			}
+			else
+			{
+				SlotKey = Expected;
+			}
+		}
+
+		if(SlotKey == Key)
+		{
+			Slot.Counts[static_cast<int32>(Channel)].fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+
+	DroppedPoints.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FOmniTraceHeatmap::GatherCells(TArray<FOmniTraceHeatmapCell>& OutCells, TOptional<FName> TraceTag)
+{
+	using namespace OmniTraceHeatmap;
+
+	OutCells.Reset();
+	const FSlot* Slots = GetSlots();
+	for(int32 SlotIndex = 0; SlotIndex < NumSlots; ++SlotIndex)
+	{
+		const uint64 Key = Slots[SlotIndex].Key.load(std::memory_order_relaxed);
+		if(Key == 0)
+		{
+			continue;
+		}
+
+		int32 TagIndex;
+		FIntVector Cell;
+		BreakKey(Key, TagIndex, Cell);
+		if(TagSlots[TagIndex].State.load(std::memory_order_acquire) != 2)
+		{
+			continue;
+		}
+
+		const FName CellTag = TagSlots[TagIndex].Tag;
+		if(TraceTag.IsSet() && TraceTag.GetValue() != CellTag)
+		{
+			continue;
+		}
+
+		FOmniTraceHeatmapCell& OutCell = OutCells.AddDefaulted_GetRef();
+		OutCell.TraceTag = CellTag;
+		OutCell.Cell = Cell;
+		for(int32 Channel = 0; Channel < static_cast<int32>(EOmniTraceHeatmapChannel::Num); ++Channel)
+		{
+			OutCell.Counts[Channel] = Slots[SlotIndex].Counts[Channel].load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void FOmniTraceHeatmap::Clear()
+{
+	using namespace OmniTraceHeatmap;
+
+	FSlot* Slots = GetSlots();
+	for(int32 SlotIndex = 0; SlotIndex < NumSlots; ++SlotIndex)
+	{
+		for(std::atomic<uint32>& Count : Slots[SlotIndex].Counts)
+		{
+			Count.store(0, std::memory_order_relaxed);
+		}
+		Slots[SlotIndex].Key.store(0, std::memory_order_relaxed);
+	}
+
+	//Tags are kept, since clearing them could race with a thread that is about to use them
+	DroppedPoints.store(0, std::memory_order_relaxed);
+}
+
+int64 FOmniTraceHeatmap::GetNumDroppedPoints()
+{
+	return OmniTraceHeatmap::DroppedPoints.load(std::memory_order_relaxed);
+}
+
+float FOmniTraceHeatmap::GetCellSize()
+{
+	return FMath::Max(TraceHeatmapCellSize, 1.f);
+}
+
+FString FOmniTraceHeatmap::ExportCsv(TOptional<FName> TraceTag)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniTraceHeatmap::ExportCsv);
+
+	TArray<FOmniTraceHeatmapCell> Cells;
+	GatherCells(Cells, TraceTag);
+
+	const float CellSize = GetCellSize();
+	FString Csv = TEXT("TraceTag,CellX,CellY,CellZ,CenterX,CenterY,CenterZ,Starts,Ends,Hits,Total\n");
+	for(const FOmniTraceHeatmapCell& Cell : Cells)
+	{
+		const FVector Center = (FVector(Cell.Cell) + 0.5) * CellSize;
+		Csv += FString::Printf(TEXT("%s,%d,%d,%d,%.0f,%.0f,%.0f,%u,%u,%u,%u\n"), *Cell.TraceTag.ToString(),
+			Cell.Cell.X, Cell.Cell.Y, Cell.Cell.Z, Center.X, Center.Y, Center.Z,
+			Cell.Counts[0], Cell.Counts[1], Cell.Counts[2], Cell.GetTotal());
+	}
+
+	const FString FilePath = OmniTraceHeatmap::MakeFilePath(TEXT("TraceHeatmap"), TEXT("csv"));
+	return FFileHelper::SaveStringToFile(Csv, *FilePath) ? FilePath : FString();
+}
+
+FString FOmniTraceHeatmap::ExportPng(TOptional<FName> TraceTag, int32 MinCellZ, int32 MaxCellZ)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniTraceHeatmap::ExportPng);
+
+	TArray<FOmniTraceHeatmapCell> Cells;
+	GatherCells(Cells, TraceTag);
+	Cells.RemoveAllSwap([MinCellZ, MaxCellZ](const FOmniTraceHeatmapCell& Cell)
+	{
+		return Cell.Cell.Z < MinCellZ || Cell.Cell.Z > MaxCellZ;
+	});
+
+	if(Cells.IsEmpty())
+	{
+		return FString();
+	}
+
+	FIntPoint Min(MAX_int32, MAX_int32);
+	FIntPoint Max(MIN_int32, MIN_int32);
+	for(const FOmniTraceHeatmapCell& Cell : Cells)
+	{
+		Min = FIntPoint(FMath::Min(Min.X, Cell.Cell.X), FMath::Min(Min.Y, Cell.Cell.Y));
+		Max = FIntPoint(FMath::Max(Max.X, Cell.Cell.X), FMath::Max(Max.Y, Cell.Cell.Y));
+	}
+
+	//One pixel per cell, anything past 4096 pixels is cut off
+	const int32 Width = FMath::Min(Max.X - Min.X + 1, 4096);
+	const int32 Height = FMath::Min(Max.Y - Min.Y + 1, 4096);
+
+	TArray<uint32> Totals;
+	Totals.SetNumZeroed(Width * Height);
+	uint32 MaxTotal = 0;
+	for(const FOmniTraceHeatmapCell& Cell : Cells)
+	{
+		const int32 X = Cell.Cell.X - Min.X;
+		const int32 Y = Max.Y - Cell.Cell.Y;
+		if(X < Width && Y < Height)
+		{
+			uint32& Total = Totals[Y * Width + X];
+			Total += Cell.GetTotal();
+			MaxTotal = FMath::Max(MaxTotal, Total);
+		}
+	}
+
+	//Logarithmic, otherwise a handful of busy cells hide everything else
+	TArray64<FColor> Pixels;
+	Pixels.SetNumUninitialized(Width * Height);
+	const float MaxLog = FMath::Loge(1.f + MaxTotal);
+	for(int32 PixelIndex = 0; PixelIndex < Totals.Num(); ++PixelIndex)
+	{
+		Pixels[PixelIndex] = Totals[PixelIndex] == 0 ? FColor::Black
+			: OmniTraceHeatmap::GetHeatColor(FMath::Loge(1.f + Totals[PixelIndex]) / MaxLog).ToFColor(true);
+	}
+
+	TArray64<uint8> Png;
+	FImageUtils::PNGCompressImageArray(Width, Height, Pixels, Png);
+
+	const FString FilePath = OmniTraceHeatmap::MakeFilePath(TEXT("TraceHeatmap"), TEXT("png"));
+	return FFileHelper::SaveArrayToFile(Png, *FilePath) ? FilePath : FString();
+}
+
+void FOmniTraceHeatmap::DrawCells(UWorld* World, TOptional<FName> TraceTag, int32 MaxCells, float Lifetime)
+{
+	if(!World)
+	{
+		return;
+	}
+
+	TArray<FOmniTraceHeatmapCell> Cells;
+	GatherCells(Cells, TraceTag);
+	if(Cells.IsEmpty())
+	{
+		return;
+	}
+
+	Cells.Sort([](const FOmniTraceHeatmapCell& A, const FOmniTraceHeatmapCell& B)
+	{
+		return A.GetTotal() > B.GetTotal();
+	});
+
+	const int32 NumCells = FMath::Min(Cells.Num(), MaxCells);
+	const float CellSize = GetCellSize();
+	const float MaxLog = FMath::Loge(1.f + Cells[0].GetTotal());
+	for(int32 CellIndex = 0; CellIndex < NumCells; ++CellIndex)
+	{
+		const FOmniTraceHeatmapCell& Cell = Cells[CellIndex];
+		const FVector Center = (FVector(Cell.Cell) + 0.5) * CellSize;
+		UOmniEditorLibrary::DrawAndLogBox(World, Center, FVector(CellSize * 0.5f), FName(TEXT("TraceHeatmap"), CellIndex + 1).ToString(),
+			FString::Printf(TEXT("%s: %u starts, %u ends, %u hits"), *Cell.TraceTag.ToString(), Cell.Counts[0], Cell.Counts[1], Cell.Counts[2]),
+			OmniTraceHeatmap::GetHeatColor(FMath::Loge(1.f + Cell.GetTotal()) / MaxLog), TEXT("TraceHeatmap"), Lifetime);
+	}
+}
+
+static FAutoConsoleCommand ExportTraceHeatmapCommand(
+	TEXT("OmniToolbox.Trace.HeatmapExport"),
+	TEXT("Write the trace heatmap to Saved/OmniTrace. Arguments: [csv|png] [TraceTag or * for every tag] [MinZ] [MaxZ]. ")
+	TEXT("PNGs are a top down slice that sums every cell between MinZ and MaxZ, in world units."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const bool bPng = Args.IsValidIndex(0) && Args[0] == TEXT("png");
+		const TOptional<FName> TraceTag = OmniTraceHeatmap::ParseTag(Args, 1);
+
+		FString FilePath;
+		if(bPng)
+		{
+			const float CellSize = FOmniTraceHeatmap::GetCellSize();
+			const int32 MinCellZ = Args.IsValidIndex(2) ? FMath::FloorToInt32(FCString::Atof(*Args[2]) / CellSize) : MIN_int32;
+			const int32 MaxCellZ = Args.IsValidIndex(3) ? FMath::FloorToInt32(FCString::Atof(*Args[3]) / CellSize) : MAX_int32;
+			FilePath = FOmniTraceHeatmap::ExportPng(TraceTag, MinCellZ, MaxCellZ);
+		}
+		else
+		{
+			FilePath = FOmniTraceHeatmap::ExportCsv(TraceTag);
+		}
+
+		if(FilePath.IsEmpty())
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceHeatmap: Nothing was written, the heatmap is empty or the file could not be saved"));
+			return;
+		}
+
+		UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceHeatmap: Wrote the heatmap to %s (%lld points dropped)"), *FilePath,
+			FOmniTraceHeatmap::GetNumDroppedPoints());
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs DrawTraceHeatmapCommand(
+	TEXT("OmniToolbox.Trace.HeatmapDraw"),
+	TEXT("Draw the busiest cells of the trace heatmap. Arguments: [TraceTag or * for every tag] [MaxCells=256] [Lifetime=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 MaxCells = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 256;
+		const float Lifetime = Args.IsValidIndex(2) ? FCString::Atof(*Args[2]) : 10.f;
+		FOmniTraceHeatmap::DrawCells(World, OmniTraceHeatmap::ParseTag(Args, 0), MaxCells, Lifetime);
+	}));
+
+static FAutoConsoleCommand ClearTraceHeatmapCommand(
+	TEXT("OmniToolbox.Trace.HeatmapClear"),
+	TEXT("Reset every counter of the trace heatmap"),
+	FConsoleCommandDelegate::CreateStatic(&FOmniTraceHeatmap::Clear));
@@ -0,0 +1,300 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Developer/OmniTraceRecorder.h"
+#include "OmniToolbox.h"
+#include "HAL/FileManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+#include <atomic>
+
+namespace OmniTraceRecorder
+{
+	static constexpr uint32 FileMagic = 0x4352544F; //"OTRC"
+	static constexpr uint32 FileVersion = 1;
+
+	enum class EChunk : uint8
+	{
+		Query,
+		Trace,
+		EndFrame
+	};
+
+	std::atomic<bool> bIsRecording = false;
+
+	FCriticalSection Lock;
+	TUniquePtr<FArchive> Writer;
+	FString FilePath;
+	TMap<FOmniRecordedQuery, uint16> QueryIndices;
+	bool bTracedThisFrame = false;
+	FDelegateHandle EndFrameHandle;
+
+	void SerializeQuery(FArchive& Ar, FOmniRecordedQuery& Query)
+	{
+		uint8 Channel = Query.Channel;
+		uint8 bTraceComplex = Query.bTraceComplex;
+		FString TraceTag = Query.TraceTag.ToString();
+
+		Ar << Channel;
+		Ar.Serialize(Query.Responses.EnumArray, sizeof(Query.Responses.EnumArray));
+		Ar << bTraceComplex;
+		Ar << TraceTag;
+
+		if(Ar.IsLoading())
+		{
+			Query.Channel = static_cast<ECollisionChannel>(Channel);
+			Query.bTraceComplex = bTraceComplex != 0;
+			Query.TraceTag = TraceTag == TEXT("None") ? NAME_None : FName(*TraceTag);
+		}
+	}
+
+	void SerializeTrace(FArchive& Ar, FOmniRecordedTrace& Trace)
+	{
+		uint8 Path = static_cast<uint8>(Trace.Path);
+		uint8 Shape = static_cast<uint8>(Trace.Shape);
+		uint8 ResultType = static_cast<uint8>(Trace.ResultType);
+
+		Ar << Path;
+		Ar << Shape;
+		Ar << ResultType;
+		Ar << Trace.QueryIndex;
+		Ar << Trace.Start;
+		Ar << Trace.End;
+		Ar << Trace.Rotation;
+		Ar << Trace.ShapeParams;
+
+		if(Ar.IsLoading())
+		{
+			Trace.Path = static_cast<EOmniRecordedTracePath>(Path);
+			Trace.Shape = static_cast<EOmniTraceShape>(Shape);
+			Trace.ResultType = static_cast<EAsyncTraceResultType>(ResultType);
+		}
+	}
+}
+
+FCollisionShape FOmniRecordedTrace::MakeCollisionShape() const
+{
+	switch(Shape)
+	{
+	case EOmniTraceShape::Sphere:
+		return FCollisionShape::MakeSphere(ShapeParams.X);
+	case EOmniTraceShape::Capsule:
+		return FCollisionShape::MakeCapsule(ShapeParams.X, ShapeParams.Y);
+	case EOmniTraceShape::Box:
+		return FCollisionShape::MakeBox(ShapeParams);
+	default:
+		return FCollisionShape();
+	}
+}
+
+bool FOmniTraceRecorder::IsRecording()
+{
+	return OmniTraceRecorder::bIsRecording.load(std::memory_order_relaxed);
+}
+
+bool FOmniTraceRecorder::StartRecording(const FString& FilePath)
+{
+	StopRecording();
+
+	FString RecordingPath = FilePath;
+	if(RecordingPath.IsEmpty())
+	{
+		const FDateTime Now = FDateTime::Now();
+		RecordingPath = FPaths::ProjectSavedDir() / TEXT("OmniTrace") / FString::Printf(TEXT("TraceRecording_%02d-%02d-%04d_%02d-%02d-%02d.omnitrace"),
+			Now.GetDay(), Now.GetMonth(), Now.GetYear(),
+			Now.GetHour(), Now.GetMinute(), Now.GetSecond());
+	}
+
+	FScopeLock ScopeLock(&OmniTraceRecorder::Lock);
+
+	OmniTraceRecorder::Writer.Reset(IFileManager::Get().CreateFileWriter(*RecordingPath));
+	if(!OmniTraceRecorder::Writer)
+	{
+		UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceRecorder: Failed to create %s"), *RecordingPath);
+		return false;
+	}
+
+	uint32 Magic = OmniTraceRecorder::FileMagic;
+	uint32 Version = OmniTraceRecorder::FileVersion;
+	*OmniTraceRecorder::Writer << Magic;
+	*OmniTraceRecorder::Writer << Version;
+
+	OmniTraceRecorder::FilePath = RecordingPath;
+	OmniTraceRecorder::QueryIndices.Reset();
+	OmniTraceRecorder::bTracedThisFrame = false;
+	OmniTraceRecorder::EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FOmniTraceRecorder::OnEndFrame);
+	OmniTraceRecorder::bIsRecording = true;
+
+	UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceRecorder: Recording traces to %s"), *RecordingPath);
+	return true;
+}
+
+FString FOmniTraceRecorder::StopRecording()
+{
+	FScopeLock ScopeLock(&OmniTraceRecorder::Lock);
+
+	if(!OmniTraceRecorder::Writer)
+	{
+		return FString();
+	}
+
+	OmniTraceRecorder::bIsRecording = false;
+	FCoreDelegates::OnEndFrame.Remove(OmniTraceRecorder::EndFrameHandle);
+
+	OmniTraceRecorder::Writer->Close();
+	OmniTraceRecorder::Writer.Reset();
+
+	UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceRecorder: Recorded %d unique queries to %s"),
+		OmniTraceRecorder::QueryIndices.Num(), *OmniTraceRecorder::FilePath);
+
+	return MoveTemp(OmniTraceRecorder::FilePath);
+}
+
+void FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath Path, EOmniTraceShape Shape, const FVector& Start,
+	const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+	ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams)
+{
+	FOmniRecordedQuery Query;
+	Query.Channel = Channel;
+	Query.Responses = ResponseParams.CollisionResponse;
+	Query.bTraceComplex = QueryParams.bTraceComplex;
+	Query.TraceTag = QueryParams.TraceTag;
+
+	FOmniRecordedTrace Trace;
+	Trace.Path = Path;
+	Trace.Shape = Shape;
+	Trace.ResultType = ResultType;
+	Trace.Start = FVector3f(Start);
+	Trace.End = FVector3f(End);
+	Trace.Rotation = FQuat4f(Rotation);
+
+	switch(Shape)
+	{
+	case EOmniTraceShape::Sphere:
+		Trace.ShapeParams.X = CollisionShape.GetSphereRadius();
+		break;
+	case EOmniTraceShape::Capsule:
+		Trace.ShapeParams.X = CollisionShape.GetCapsuleRadius();
+		Trace.ShapeParams.Y = CollisionShape.GetCapsuleHalfHeight();
+		break;
+	case EOmniTraceShape::Box:
+		Trace.ShapeParams = FVector3f(CollisionShape.GetExtent());
+		break;
+	default:
+		break;
+	}
+
+	FScopeLock ScopeLock(&OmniTraceRecorder::Lock);
+
+	FArchive* Writer = OmniTraceRecorder::Writer.Get();
+	if(!Writer)
+	{
+		return;
+	}
+
+	const uint16* ExistingIndex = OmniTraceRecorder::QueryIndices.Find(Query);
+	if(ExistingIndex)
+	{
+		Trace.QueryIndex = *ExistingIndex;
+	}
+	else
+	{
+		Trace.QueryIndex = static_cast<uint16>(OmniTraceRecorder::QueryIndices.Num());
+		OmniTraceRecorder::QueryIndices.Add(Query, Trace.QueryIndex);
+
+		uint8 Chunk = static_cast<uint8>(OmniTraceRecorder::EChunk::Query);
+		*Writer << Chunk;
+		OmniTraceRecorder::SerializeQuery(*Writer, Query);
+	}
+
+	uint8 Chunk = static_cast<uint8>(OmniTraceRecorder::EChunk::Trace);
+	*Writer << Chunk;
+	OmniTraceRecorder::SerializeTrace(*Writer, Trace);
+	OmniTraceRecorder::bTracedThisFrame = true;
+}
+
+bool FOmniTraceRecorder::LoadRecording(const FString& FilePath, FOmniTraceRecording& OutRecording)
+{
+	OutRecording = FOmniTraceRecording();
+
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if(!Reader)
+	{
+		UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceRecorder: Failed to open %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	if(Magic != OmniTraceRecorder::FileMagic || Version != OmniTraceRecorder::FileVersion)
+	{
+		UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceRecorder: %s is not a trace recording or was made by a different version"), *FilePath);
+		return false;
+	}
+
+	while(!Reader->AtEnd() && !Reader->IsError())
+	{
+		uint8 Chunk = 0;
+		*Reader << Chunk;
+
+		switch(static_cast<OmniTraceRecorder::EChunk>(Chunk))
+		{
+		case OmniTraceRecorder::EChunk::Query:
+			OmniTraceRecorder::SerializeQuery(*Reader, OutRecording.Queries.AddDefaulted_GetRef());
+			break;
+		case OmniTraceRecorder::EChunk::Trace:
+			{
+				FOmniRecordedTrace& Trace = OutRecording.Traces.AddDefaulted_GetRef();
+				OmniTraceRecorder::SerializeTrace(*Reader, Trace);
+				Trace.Frame = OutRecording.NumFrames;
+				break;
+			}
+		case OmniTraceRecorder::EChunk::EndFrame:
+			OutRecording.NumFrames++;
+			break;
+		default:
+			UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceRecorder: %s is corrupted"), *FilePath);
+			return false;
+		}
+	}
+
+	//The last frame is usually cut off by the recording being stopped
+	if(!OutRecording.Traces.IsEmpty() && OutRecording.Traces.Last().Frame == OutRecording.NumFrames)
+	{
+		OutRecording.NumFrames++;
+	}
+
+	return !Reader->IsError();
+}
+
+void FOmniTraceRecorder::OnEndFrame()
+{
+	FScopeLock ScopeLock(&OmniTraceRecorder::Lock);
+
+	//Frames without any traces are skipped, they'd only slow down the replay
+	if(OmniTraceRecorder::Writer && OmniTraceRecorder::bTracedThisFrame)
+	{
+		uint8 Chunk = static_cast<uint8>(OmniTraceRecorder::EChunk::EndFrame);
+		*OmniTraceRecorder::Writer << Chunk;
+		OmniTraceRecorder::bTracedThisFrame = false;
+	}
+}
+
+static FAutoConsoleCommand StartTraceRecordingCommand(
+	TEXT("OmniToolbox.Trace.StartRecording"),
+	TEXT("Record every OmniTraceLibrary trace to a file. Optionally pass the path of the file, otherwise it is written to Saved/OmniTrace."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FOmniTraceRecorder::StartRecording(Args.IsEmpty() ? FString() : Args[0]);
+	}));
+
+static FAutoConsoleCommand StopTraceRecordingCommand(
+	TEXT("OmniToolbox.Trace.StopRecording"),
+	TEXT("Stop recording traces and close the recording file"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FOmniTraceRecorder::StopRecording();
+	}));
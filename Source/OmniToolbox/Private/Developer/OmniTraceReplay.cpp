@@ -0,0 +1,281 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Developer/OmniTraceReplay.h"
+#include "OmniToolbox.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+void FOmniTraceReplayReport::SetLatencies(TArray<double>& LatenciesMs)
+{
+	if(LatenciesMs.IsEmpty())
+	{
+		return;
+	}
+
+	LatenciesMs.Sort();
+
+	auto GetPercentile = [&LatenciesMs](double Percentile)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * LatenciesMs.Num()) - 1, 0, LatenciesMs.Num() - 1);
+		return LatenciesMs[Index];
+	};
+
+	P50Ms = GetPercentile(0.5);
+	P90Ms = GetPercentile(0.9);
+	P99Ms = GetPercentile(0.99);
+	MaxMs = LatenciesMs.Last();
+}
+
+FString FOmniTraceReplayReport::ToString() const
+{
+	return FString::Printf(TEXT("%s: %d traces, %d results in %.3f ms (%.0f traces/s) | p50 %.4f ms, p90 %.4f ms, p99 %.4f ms, max %.4f ms | %d lost"),
+		*Path, NumTraces, NumResults, TotalSeconds * 1000.0, GetTracesPerSecond(), P50Ms, P90Ms, P99Ms, MaxMs, NumLost);
+}
+
+void UOmniTraceReplayListener::AddFrame(int32 NumTraces)
+{
+	FPendingFrame& Frame = PendingFrames.AddDefaulted_GetRef();
+	Frame.QueueTime = FPlatformTime::Seconds();
+	Frame.NumRemaining = NumTraces;
+	NumPending += NumTraces;
+}
+
+void UOmniTraceReplayListener::OnTraceCompleted(const TArray<FHitResult>& HitResults)
+{
+	while(PendingFrames.IsValidIndex(OldestFrame) && PendingFrames[OldestFrame].NumRemaining == 0)
+	{
+		OldestFrame++;
+	}
+
+	if(!PendingFrames.IsValidIndex(OldestFrame))
+	{
+		return;
+	}
+
+	FPendingFrame& Frame = PendingFrames[OldestFrame];
+	Frame.NumRemaining--;
+	NumPending--;
+	NumResults += HitResults.Num();
+	LatenciesMs.Add((FPlatformTime::Seconds() - Frame.QueueTime) * 1000.0);
+}
+
+FOmniTraceReplay::FOmniTraceReplay(const FOmniTraceRecording& InRecording)
+	: Recording(InRecording)
+{
+	Queries.Reserve(Recording.Queries.Num());
+	for(const FOmniRecordedQuery& RecordedQuery : Recording.Queries)
+	{
+		FCollisionQueryParams QueryParams;
+		QueryParams.bTraceComplex = RecordedQuery.bTraceComplex;
+		QueryParams.TraceTag = RecordedQuery.TraceTag;
+
+		Queries.AddDefaulted_GetRef().CompileFrom(RecordedQuery.Channel, QueryParams, FCollisionResponseParams(RecordedQuery.Responses));
+	}
+
+	FrameStarts.Reserve(Recording.NumFrames + 1);
+	for(int32 TraceIndex = 0; TraceIndex < Recording.Traces.Num(); ++TraceIndex)
+	{
+		if(TraceIndex == 0 || Recording.Traces[TraceIndex].Frame != Recording.Traces[TraceIndex - 1].Frame)
+		{
+			FrameStarts.Add(TraceIndex);
+		}
+	}
+	FrameStarts.Add(Recording.Traces.Num());
+}
+
+FOmniTraceReplayReport FOmniTraceReplay::RunSync(UWorld* World) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniTraceReplay::RunSync);
+
+	FOmniTraceReplayReport Report;
+	Report.Path = TEXT("Sync");
+
+	TArray<double> LatenciesMs;
+	LatenciesMs.Reserve(Recording.Traces.Num());
+
+	const FTraceDebug DebugOptions;
+	for(const FOmniRecordedTrace& Trace : Recording.Traces)
+	{
+		if(!Queries.IsValidIndex(Trace.QueryIndex))
+		{
+			continue;
+		}
+
+		const FCollisionShape CollisionShape = Trace.MakeCollisionShape();
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const TArray<FHitResult> HitResults = UOmniTraceLibrary::TraceByQuery(World, Trace.Shape, FVector(Trace.Start), FVector(Trace.End),
+			FQuat(Trace.Rotation), CollisionShape, Trace.ResultType, Queries[Trace.QueryIndex], DebugOptions);
+		const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+
+		Report.NumTraces++;
+		Report.NumResults += HitResults.Num();
+		Report.TotalSeconds += FPlatformTime::ToSeconds64(Cycles);
+		LatenciesMs.Add(FPlatformTime::ToMilliseconds64(Cycles));
+	}
+
+	Report.SetLatencies(LatenciesMs);
+	return Report;
+}
+
+FOmniTraceReplayReport FOmniTraceReplay::RunBatched(UWorld* World) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniTraceReplay::RunBatched);
+
+	FOmniTraceReplayReport Report;
+	Report.Path = TEXT("Batched");
+
+	TArray<double> LatenciesMs;
+	TArray<TArray<FOmniTraceRequest>> RequestsPerQuery;
+	RequestsPerQuery.SetNum(Queries.Num());
+	FOmniBatchTraceResult BatchResults;
+
+	for(int32 Frame = 0; Frame + 1 < FrameStarts.Num(); ++Frame)
+	{
+		for(TArray<FOmniTraceRequest>& Requests : RequestsPerQuery)
+		{
+			Requests.Reset();
+		}
+
+		for(int32 TraceIndex = FrameStarts[Frame]; TraceIndex < FrameStarts[Frame + 1]; ++TraceIndex)
+		{
+			const FOmniRecordedTrace& Trace = Recording.Traces[TraceIndex];
+			if(!Queries.IsValidIndex(Trace.QueryIndex))
+			{
+				continue;
+			}
+
+			FOmniTraceRequest& Request = RequestsPerQuery[Trace.QueryIndex].AddDefaulted_GetRef();
+			Request.Shape = Trace.Shape;
+			Request.Start = FVector(Trace.Start);
+			Request.End = FVector(Trace.End);
+			Request.Rotation = FRotator(FQuat(Trace.Rotation));
+			Request.ResultType = Trace.ResultType;
+			Request.Radius = Trace.ShapeParams.X;
+			Request.HalfHeight = Trace.ShapeParams.Y;
+			Request.Extent = FVector(Trace.ShapeParams);
+		}
+
+		for(int32 QueryIndex = 0; QueryIndex < Queries.Num(); ++QueryIndex)
+		{
+			if(RequestsPerQuery[QueryIndex].IsEmpty())
+			{
+				continue;
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			UOmniTraceLibrary::BatchTraceByQuery(World, RequestsPerQuery[QueryIndex], Queries[QueryIndex], BatchResults);
+			const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+
+			Report.NumTraces += RequestsPerQuery[QueryIndex].Num();
+			Report.NumResults += BatchResults.HitResults.Num();
+			Report.TotalSeconds += FPlatformTime::ToSeconds64(Cycles);
+			LatenciesMs.Add(FPlatformTime::ToMilliseconds64(Cycles));
+		}
+	}
+
+	Report.SetLatencies(LatenciesMs);
+	return Report;
+}
+
+FOmniTraceReplayReport FOmniTraceReplay::RunAsync(UWorld* World, TFunctionRef<void()> StepFrame, int32 MaxExtraFrames) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniTraceReplay::RunAsync);
+
+	FOmniTraceReplayReport Report;
+	Report.Path = TEXT("Async");
+
+	const TStrongObjectPtr<UOmniTraceReplayListener> Listener(NewObject<UOmniTraceReplayListener>());
+	FAsyncTraceResultDelegate OnTraceCompleted;
+	OnTraceCompleted.BindUFunction(Listener.Get(), GET_FUNCTION_NAME_CHECKED(UOmniTraceReplayListener, OnTraceCompleted));
+
+	const FTraceDebug DebugOptions;
+	const double StartTime = FPlatformTime::Seconds();
+
+	for(int32 Frame = 0; Frame + 1 < FrameStarts.Num(); ++Frame)
+	{
+		int32 NumQueued = 0;
+		for(int32 TraceIndex = FrameStarts[Frame]; TraceIndex < FrameStarts[Frame + 1]; ++TraceIndex)
+		{
+			const FOmniRecordedTrace& Trace = Recording.Traces[TraceIndex];
+			if(!Queries.IsValidIndex(Trace.QueryIndex))
+			{
+				continue;
+			}
+
+			UOmniTraceLibrary::AsyncTraceByQuery(World, Trace.Shape, FVector(Trace.Start), FVector(Trace.End), FQuat(Trace.Rotation),
+				Trace.MakeCollisionShape(), Trace.ResultType, Queries[Trace.QueryIndex], OnTraceCompleted, DebugOptions);
+			NumQueued++;
+		}
+
+		Listener->AddFrame(NumQueued);
+		Report.NumTraces += NumQueued;
+		StepFrame();
+	}
+
+	for(int32 ExtraFrame = 0; ExtraFrame < MaxExtraFrames && Listener->HasPendingTraces(); ++ExtraFrame)
+	{
+		StepFrame();
+	}
+
+	Report.TotalSeconds = FPlatformTime::Seconds() - StartTime;
+	Report.NumResults = Listener->NumResults;
+	Report.NumLost = Listener->NumPending;
+	Report.SetLatencies(Listener->LatenciesMs);
+	return Report;
+}
+
+FString FOmniTraceReplay::WriteReportsToCsv(TConstArrayView<FOmniTraceReplayReport> Reports)
+{
+	FString Csv = TEXT("Path,Traces,Results,TotalMs,TracesPerSecond,P50Ms,P90Ms,P99Ms,MaxMs,Lost\n");
+	for(const FOmniTraceReplayReport& Report : Reports)
+	{
+		Csv += FString::Printf(TEXT("%s,%d,%d,%.4f,%.2f,%.4f,%.4f,%.4f,%.4f,%d\n"),
+			*Report.Path, Report.NumTraces, Report.NumResults, Report.TotalSeconds * 1000.0, Report.GetTracesPerSecond(),
+			Report.P50Ms, Report.P90Ms, Report.P99Ms, Report.MaxMs, Report.NumLost);
+	}
+
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("OmniTrace");
+	IFileManager::Get().MakeDirectory(*Directory, true);
+
+	const FDateTime Now = FDateTime::Now();
+	const FString FilePath = Directory / FString::Printf(TEXT("TraceReplay_%02d-%02d-%04d_%02d-%02d-%02d.csv"),
+		Now.GetDay(), Now.GetMonth(), Now.GetYear(),
+		Now.GetHour(), Now.GetMinute(), Now.GetSecond());
+
+	return FFileHelper::SaveStringToFile(Csv, *FilePath) ? FilePath : FString();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayTraceRecordingCommand(
+	TEXT("OmniToolbox.Trace.Replay"),
+	TEXT("Replay a trace recording through the sync and batched trace paths and write the results to Saved/OmniTrace. Pass the path of the recording."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if(Args.IsEmpty() || !World)
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceReplay: Usage: OmniToolbox.Trace.Replay <RecordingPath>"));
+			return;
+		}
+
+		FOmniTraceRecording Recording;
+		if(!FOmniTraceRecorder::LoadRecording(Args[0], Recording))
+		{
+			return;
+		}
+
+		const FOmniTraceReplay Replay(Recording);
+		const FOmniTraceReplayReport Reports[] = { Replay.RunSync(World), Replay.RunBatched(World) };
+		for(const FOmniTraceReplayReport& Report : Reports)
+		{
+			UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceReplay: %s"), *Report.ToString());
+		}
+
+		const FString FilePath = FOmniTraceReplay::WriteReportsToCsv(Reports);
+		if(!FilePath.IsEmpty())
+		{
+			UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceReplay: Wrote replay results to %s"), *FilePath);
+		}
+	}));
@@ -0,0 +1,327 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Developer/OmniTraceStats.h"
+#include "OmniToolbox.h"
+#include "OmniRuntimeMacros.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, RecordTraceTagStats, false,
+	"OmniToolbox.Trace.TagStats",
+	"Record call counts, timings and results of every OmniTraceLibrary trace, grouped by their TraceTag");
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces"), STAT_OmniTraceCalls, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Trace Results"), STAT_OmniTraceResults, STATGROUP_OmniTrace);
+
+TRACE_DECLARE_INT_COUNTER(OmniTraceCallsPerFrame, TEXT("OmniTrace/Calls"));
+
+namespace OmniTraceStats
+{
+	struct FTagEntry
+	{
+		FOmniTraceTagStats Stats;
+
+#if STATS
+		TStatId StatId;
+#endif
+
+#if COUNTERSTRACE_ENABLED
+		FString CounterName;
+		TUniquePtr<FCountersTrace::FCounterInt> Counter;
+#endif
+	};
+
+	FCriticalSection Lock;
+	TMap<FName, FTagEntry> Entries;
+	int64 CallsThisFrame = 0;
+
+	/**Has to be called while holding the lock*/
+	FTagEntry& FindOrAddEntry(FName TraceTag)
+	{
+		FTagEntry* Entry = Entries.Find(TraceTag);
+		if(Entry)
+		{
+			return *Entry;
+		}
+
+		Entry = &Entries.Add(TraceTag);
+#if COUNTERSTRACE_ENABLED
+		Entry->CounterName = FString::Printf(TEXT("OmniTrace/%s"), *TraceTag.ToString());
+		Entry->Counter = MakeUnique<FCountersTrace::FCounterInt>(*Entry->CounterName, TraceCounterDisplayHint_None);
+#endif
+		return *Entry;
+	}
+
+	/**Has to be called while holding the lock*/
+	void AddTrace(FOmniTraceTagStats& Stats, EOmniTraceShape Shape, EAsyncTraceResultType ResultType, int32 NumResults,
+		uint64 Cycles, bool bAsync)
+	{
+		const int32 ShapeIndex = FMath::Clamp(static_cast<int32>(Shape), 0, FOmniTraceTagStats::NumShapes - 1);
+		const int32 ResultTypeIndex = FMath::Clamp(static_cast<int32>(ResultType), 0, FOmniTraceTagStats::NumResultTypes - 1);
+
+		Stats.Calls++;
+		Stats.AsyncCalls += bAsync ? 1 : 0;
+		Stats.CallsWithHits += NumResults > 0 ? 1 : 0;
+		Stats.TotalResults += NumResults;
+		Stats.TotalCycles += Cycles;
+		Stats.MaxCycles = FMath::Max(Stats.MaxCycles, Cycles);
+		Stats.CallsByShape[ShapeIndex]++;
+		Stats.ResultsByShape[ShapeIndex] += NumResults;
+		Stats.CallsByResultType[ResultTypeIndex]++;
+		Stats.ResultsByResultType[ResultTypeIndex] += NumResults;
+		Stats.CallsThisFrame++;
+	}
+
+	/**Traces from worker threads are gathered per thread first, so
+	 * parallel traces don't all have to wait on the shared lock.
+	 * Each buffer has its own lock, which is only contended while it's flushed.*/
+	struct FThreadBuffer
+	{
+		FCriticalSection Lock;
+		TMap<FName, FOmniTraceTagStats> Stats;
+		int64 Calls = 0;
+	};
+
+	/**Every thread that has recorded a trace, protected by @Lock*/
+	TArray<TSharedRef<FThreadBuffer, ESPMode::ThreadSafe>> ThreadBuffers;
+
+	FThreadBuffer& GetThreadBuffer()
+	{
+		thread_local TSharedPtr<FThreadBuffer, ESPMode::ThreadSafe> ThreadBuffer;
+		if(!ThreadBuffer.IsValid())
+		{
+			ThreadBuffer = MakeShared<FThreadBuffer, ESPMode::ThreadSafe>();
+
+			FScopeLock ScopeLock(&Lock);
+			ThreadBuffers.Add(ThreadBuffer.ToSharedRef());
+		}
+		return *ThreadBuffer;
+	}
+
+	void MergeStats(FOmniTraceTagStats& Stats, const FOmniTraceTagStats& Other)
+	{
+		Stats.Calls += Other.Calls;
+		Stats.AsyncCalls += Other.AsyncCalls;
+		Stats.CallsWithHits += Other.CallsWithHits;
+		Stats.TotalResults += Other.TotalResults;
+		Stats.TotalCycles += Other.TotalCycles;
+		Stats.MaxCycles = FMath::Max(Stats.MaxCycles, Other.MaxCycles);
+		for(int32 Index = 0; Index < FOmniTraceTagStats::NumShapes; ++Index)
+		{
+			Stats.CallsByShape[Index] += Other.CallsByShape[Index];
+			Stats.ResultsByShape[Index] += Other.ResultsByShape[Index];
+		}
+		for(int32 Index = 0; Index < FOmniTraceTagStats::NumResultTypes; ++Index)
+		{
+			Stats.CallsByResultType[Index] += Other.CallsByResultType[Index];
+			Stats.ResultsByResultType[Index] += Other.ResultsByResultType[Index];
+		}
+		Stats.CallsThisFrame += Other.CallsThisFrame;
+	}
+
+	/**Move everything the worker threads have recorded into @Entries.
+	 * Has to be called while holding the lock*/
+	void FlushThreadBuffers()
+	{
+		for(int32 BufferIndex = ThreadBuffers.Num() - 1; BufferIndex >= 0; --BufferIndex)
+		{
+			FThreadBuffer& Buffer = *ThreadBuffers[BufferIndex];
+			{
+				FScopeLock BufferLock(&Buffer.Lock);
+				for(TPair<FName, FOmniTraceTagStats>& Stats : Buffer.Stats)
+				{
+					MergeStats(FindOrAddEntry(Stats.Key).Stats, Stats.Value);
+					Stats.Value = FOmniTraceTagStats();
+				}
+				CallsThisFrame += Buffer.Calls;
+				Buffer.Calls = 0;
+			}
+
+			//Only we are holding on to the buffer, its thread has exited
+			if(ThreadBuffers[BufferIndex].GetSharedReferenceCount() == 1)
+			{
+				ThreadBuffers.RemoveAtSwap(BufferIndex);
+			}
+		}
+	}
+}
+
+Omni_OnPostEngineInit()
+{
+	FCoreDelegates::OnEndFrame.AddStatic(&FOmniTraceStats::OnEndFrame);
+}
+
+bool FOmniTraceStats::IsEnabled()
+{
+	return RecordTraceTagStats;
+}
+
+void FOmniTraceStats::RecordTrace(FName TraceTag, EOmniTraceShape Shape, EAsyncTraceResultType ResultType,
+	int32 NumResults, uint64 Cycles, bool bAsync)
+{
+	INC_DWORD_STAT(STAT_OmniTraceCalls);
+	INC_DWORD_STAT_BY(STAT_OmniTraceResults, NumResults);
+
+	if(!IsInGameThread())
+	{
+		OmniTraceStats::FThreadBuffer& Buffer = OmniTraceStats::GetThreadBuffer();
+		FScopeLock BufferLock(&Buffer.Lock);
+		OmniTraceStats::AddTrace(Buffer.Stats.FindOrAdd(TraceTag), Shape, ResultType, NumResults, Cycles, bAsync);
+		Buffer.Calls++;
+		return;
+	}
+
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	OmniTraceStats::AddTrace(OmniTraceStats::FindOrAddEntry(TraceTag).Stats, Shape, ResultType, NumResults, Cycles, bAsync);
+	OmniTraceStats::CallsThisFrame++;
+}
+
+void FOmniTraceStats::RecordBatch(FName TraceTag, TConstArrayView<FOmniTraceRequest> Requests,
+	const FOmniBatchTraceResult& Results, uint64 Cycles)
+{
+	if(Requests.IsEmpty())
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_OmniTraceCalls, Requests.Num());
+	INC_DWORD_STAT_BY(STAT_OmniTraceResults, Results.HitResults.Num());
+
+	const uint64 CyclesPerRequest = Cycles / Requests.Num();
+
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	FOmniTraceTagStats& Stats = OmniTraceStats::FindOrAddEntry(TraceTag).Stats;
+	for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const int32 NumResults = Results.Ranges.IsValidIndex(RequestIndex) ? Results.Ranges[RequestIndex].Num : 0;
+		OmniTraceStats::AddTrace(Stats, Requests[RequestIndex].Shape, Requests[RequestIndex].ResultType, NumResults,
+			CyclesPerRequest, false);
+	}
+	OmniTraceStats::CallsThisFrame += Requests.Num();
+}
+
+#if STATS
+TStatId FOmniTraceStats::GetTagStatId(FName TraceTag)
+{
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	OmniTraceStats::FTagEntry& Entry = OmniTraceStats::FindOrAddEntry(TraceTag);
+	if(!Entry.StatId.IsValidStat())
+	{
+		const FString StatName = TraceTag.IsNone() ? TEXT("OmniTrace_Untagged") : FString::Printf(TEXT("OmniTrace_%s"), *TraceTag.ToString());
+		Entry.StatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_OmniTrace>(StatName);
+	}
+
+	return Entry.StatId;
+}
+#endif
+
+TMap<FName, FOmniTraceTagStats> FOmniTraceStats::GetSnapshot()
+{
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	OmniTraceStats::FlushThreadBuffers();
+
+	TMap<FName, FOmniTraceTagStats> Snapshot;
+	Snapshot.Reserve(OmniTraceStats::Entries.Num());
+	for(const TPair<FName, OmniTraceStats::FTagEntry>& Entry : OmniTraceStats::Entries)
+	{
+		Snapshot.Add(Entry.Key, Entry.Value.Stats);
+	}
+
+	return Snapshot;
+}
+
+void FOmniTraceStats::Reset()
+{
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	OmniTraceStats::FlushThreadBuffers();
+
+	//Keep the entries themselves, their stat ids and counters are still registered
+	for(TPair<FName, OmniTraceStats::FTagEntry>& Entry : OmniTraceStats::Entries)
+	{
+		Entry.Value.Stats = FOmniTraceTagStats();
+	}
+	OmniTraceStats::CallsThisFrame = 0;
+}
+
+FString FOmniTraceStats::DumpToCsv()
+{
+	const TMap<FName, FOmniTraceTagStats> Snapshot = GetSnapshot();
+
+	FString Csv = TEXT("TraceTag,Calls,AsyncCalls,HitRatio,TotalResults,TotalMs,AverageMs,MaxMs,"
+		"LineCalls,SphereCalls,CapsuleCalls,BoxCalls,LineResults,SphereResults,CapsuleResults,BoxResults,"
+		"MultiCalls,SingleCalls,TestCalls,MultiResults,SingleResults,TestResults\n");
+
+	for(const TPair<FName, FOmniTraceTagStats>& Entry : Snapshot)
+	{
+		const FOmniTraceTagStats& Stats = Entry.Value;
+		const int64 SyncCalls = Stats.Calls - Stats.AsyncCalls;
+		const double TotalMs = FPlatformTime::ToMilliseconds64(Stats.TotalCycles);
+
+		Csv += FString::Printf(TEXT("%s,%lld,%lld,%.4f,%lld,%.4f,%.4f,%.4f"),
+			Entry.Key.IsNone() ? TEXT("Untagged") : *Entry.Key.ToString(),
+			Stats.Calls, Stats.AsyncCalls, Stats.GetHitRatio(), Stats.TotalResults,
+			TotalMs, SyncCalls > 0 ? TotalMs / SyncCalls : 0.0, FPlatformTime::ToMilliseconds64(Stats.MaxCycles));
+
+		for(const int64 Value : Stats.CallsByShape) { Csv += FString::Printf(TEXT(",%lld"), Value); }
+		for(const int64 Value : Stats.ResultsByShape) { Csv += FString::Printf(TEXT(",%lld"), Value); }
+		for(const int64 Value : Stats.CallsByResultType) { Csv += FString::Printf(TEXT(",%lld"), Value); }
+		for(const int64 Value : Stats.ResultsByResultType) { Csv += FString::Printf(TEXT(",%lld"), Value); }
+		Csv += TEXT("\n");
+	}
+
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("OmniTrace");
+	IFileManager::Get().MakeDirectory(*Directory, true);
+
+	const FDateTime Now = FDateTime::Now();
+	const FString FilePath = Directory / FString::Printf(TEXT("TraceTagStats_%02d-%02d-%04d_%02d-%02d-%02d.csv"),
+		Now.GetDay(), Now.GetMonth(), Now.GetYear(),
+		Now.GetHour(), Now.GetMinute(), Now.GetSecond());
+
+	return FFileHelper::SaveStringToFile(Csv, *FilePath) ? FilePath : FString();
+}
+
+void FOmniTraceStats::OnEndFrame()
+{
+	FScopeLock ScopeLock(&OmniTraceStats::Lock);
+	OmniTraceStats::FlushThreadBuffers();
+
+	TRACE_COUNTER_SET(OmniTraceCallsPerFrame, OmniTraceStats::CallsThisFrame);
+	OmniTraceStats::CallsThisFrame = 0;
+
+	for(TPair<FName, OmniTraceStats::FTagEntry>& Entry : OmniTraceStats::Entries)
+	{
+#if COUNTERSTRACE_ENABLED
+		Entry.Value.Counter->Set(Entry.Value.Stats.CallsThisFrame);
+#endif
+		Entry.Value.Stats.CallsThisFrame = 0;
+	}
+}
+
+static FAutoConsoleCommand DumpTraceTagStatsCommand(
+	TEXT("OmniToolbox.Trace.DumpTagStats"),
+	TEXT("Write the recorded trace statistics of every TraceTag to a CSV file in Saved/OmniTrace. Pass \"reset\" to clear the statistics afterwards."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString FilePath = FOmniTraceStats::DumpToCsv();
+		if(FilePath.IsEmpty())
+		{
+			UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceStats: Failed to write the trace tag stats"));
+		}
+		else
+		{
+			UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceStats: Wrote trace tag stats to %s"), *FilePath);
+		}
+
+		if(Args.Contains(TEXT("reset")))
+		{
+			FOmniTraceStats::Reset();
+		}
+	}));
+
+static FAutoConsoleCommand ResetTraceTagStatsCommand(
+	TEXT("OmniToolbox.Trace.ResetTagStats"),
+	TEXT("Clear the recorded trace statistics of every TraceTag"),
+	FConsoleCommandDelegate::CreateStatic(&FOmniTraceStats::Reset));
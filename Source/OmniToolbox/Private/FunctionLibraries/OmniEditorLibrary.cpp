@@ -222,244 +222,272 @@ void UOmniEditorLibrary::EnableVislogRecordingToFile(bool bEnabled)
 #endif // ENABLE_VISUAL_LOG
 }
 
-void UOmniEditorLibrary::DrawAndLogCapsule(UObject* WorldContextObject, FVector Center, float HalfHeight, float Radius,
+static UOmniDebugDrawSubsystem* GetDebugDrawSubsystem(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UOmniDebugDrawSubsystem>() : nullptr;
+}
+
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogShape(UObject* WorldContextObject, FOmniDebugDrawCommand&& Command, FName Key)
+{
+	if(!IsInGameThread())
+	{
+		//GetSubsystem isn't safe off the game thread, the subsystem is looked up through its own registry
+		const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+		UOmniDebugDrawSubsystem::QueueShapeForWorld(World, MoveTemp(Command), Key);
+		return FOmniDebugShapeHandle();
+	}
+
+	UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	if(!DrawSubsystem)
+	{
+		return FOmniDebugShapeHandle();
+	}
+
+	return DrawSubsystem->AddShape(MoveTemp(Command), Key);
+}
+
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogCapsule(UObject* WorldContextObject, FVector Center, float HalfHeight, float Radius,
                                            FQuat Rotation, FString Key, FString Text, FLinearColor Color, FName LogCategory, float Lifetime,
                                            bool bAddToMessageLog, bool bWireframe, EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Key, Thickness, Lifetime, Center, Rotation, HalfHeight, Radius]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Capsule;
-			DrawCommand.Location = Center;
-			DrawCommand.Rotation = Rotation;
-			DrawCommand.HalfHeight = HalfHeight;
-			DrawCommand.Radius = Radius;
-			DrawCommand.Thickness = Thickness;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Capsule;
+	DrawCommand.Location = Center;
+	DrawCommand.Rotation = Rotation;
+	DrawCommand.HalfHeight = HalfHeight;
+	DrawCommand.Radius = Radius;
+	DrawCommand.Thickness = Thickness;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogLine(UObject* WorldContextObject, FVector Start, FVector End, FString Key, FString Text,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogLine(UObject* WorldContextObject, FVector Start, FVector End, FString Key, FString Text,
 	FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog, bool bWireframe,
 	EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Key, Thickness, Lifetime, Start, End]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Line;
-			DrawCommand.Location = Start;
-			DrawCommand.End = End;
-			DrawCommand.Thickness = Thickness;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Line;
+	DrawCommand.Location = Start;
+	DrawCommand.End = End;
+	DrawCommand.Thickness = Thickness;
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
+}
+
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogPolyline(UObject* WorldContextObject, const TArray<FVector>& Points, FString Key, FString Text,
+	FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog, bool bWireframe,
+	EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
+{
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Polyline;
+	DrawCommand.Points = Points;
+	DrawCommand.Location = Points.IsEmpty() ? FVector::ZeroVector : Points[0];
+	DrawCommand.End = Points.IsEmpty() ? FVector::ZeroVector : Points.Last();
+	DrawCommand.Thickness = Thickness;
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogCone(UObject* WorldContextObject, FVector Start, FVector Direction, float Length, float Angle, FString Key,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogCone(UObject* WorldContextObject, FVector Start, FVector Direction, float Length, float Angle, FString Key,
                                         FString Text, FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog,
                                         bool bWireframe, EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Key, Thickness, Lifetime, Start, Direction, Length, Angle]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Cone;
-			DrawCommand.Location = Start;
-			DrawCommand.Direction = Direction;
-			DrawCommand.Length = Length;
-			DrawCommand.AngleHeight = Angle;
-			DrawCommand.AngleWidth = Angle;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.Thickness = Thickness;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}	
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Cone;
+	DrawCommand.Location = Start;
+	DrawCommand.Direction = Direction;
+	DrawCommand.Length = Length;
+	DrawCommand.AngleHeight = Angle;
+	DrawCommand.AngleWidth = Angle;
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.Thickness = Thickness;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogCircle(UObject* WorldContextObject, FVector Center, FVector UpAxis, float Radius, FString Key,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogCircle(UObject* WorldContextObject, FVector Center, FVector UpAxis, float Radius, FString Key,
 	FString Text, FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog,
 	bool bWireframe, EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Key, Thickness, Center, UpAxis, Radius, Lifetime]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Circle;
-			DrawCommand.Location = Center;
-			DrawCommand.Rotation = FQuat(UpAxis.Rotation());
-			DrawCommand.Radius = Radius;
-			DrawCommand.Color = Color;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.Text = Text;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = Thickness;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Circle;
+	DrawCommand.Location = Center;
+	DrawCommand.Rotation = FQuat(UpAxis.Rotation());
+	DrawCommand.Radius = Radius;
+	DrawCommand.Color = Color;
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = Thickness;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogBox(UObject* WorldContextObject, FVector Center, FVector Extent, FString Key, FString Text,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogBox(UObject* WorldContextObject, FVector Center, FVector Extent, FString Key, FString Text,
 	FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog, bool bWireframe,
 	EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Lifetime, Key, Thickness, Center, Extent]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Box;
-			DrawCommand.Location = Center;
-			DrawCommand.Extent = Extent;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = Thickness;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Box;
+	DrawCommand.Location = Center;
+	DrawCommand.Extent = Extent;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = Thickness;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogRotatedBox(UObject* WorldContextObject, FVector Center, FVector Extent,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogRotatedBox(UObject* WorldContextObject, FVector Center, FVector Extent,
 	FQuat Rotation, FString Key, FString Text, FLinearColor Color, FName LogCategory, float Lifetime,
 	bool bAddToMessageLog, bool bWireframe, EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Key, Thickness, Lifetime, Center, Extent, Rotation]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::RotatedBox;
-			DrawCommand.Location = Center;
-			DrawCommand.Extent = Extent;
-			DrawCommand.Rotation = Rotation;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = Thickness;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::RotatedBox;
+	DrawCommand.Location = Center;
+	DrawCommand.Extent = Extent;
+	DrawCommand.Rotation = Rotation;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = Thickness;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogSphere(UObject* WorldContextObject, FVector Center, float Radius, FString Key, FString Text,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogSphere(UObject* WorldContextObject, FVector Center, float Radius, FString Key, FString Text,
                                           FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog, bool bWireframe,
                                           EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Center, Radius, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Thickness, Key, Lifetime]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Sphere;
-			DrawCommand.Location = Center;
-			DrawCommand.Radius = Radius;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = Thickness;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Sphere;
+	DrawCommand.Location = Center;
+	DrawCommand.Radius = Radius;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = Thickness;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 }
 
-void UOmniEditorLibrary::DrawAndLogArrow(UObject* WorldContextObject, FVector Start, FVector End, float ArrowSize, FString Key,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogArrow(UObject* WorldContextObject, FVector Start, FVector End, float ArrowSize, FString Key,
 	FString Text, FLinearColor Color, FName LogCategory, float Lifetime, bool bAddToMessageLog,
 	bool bWireframe, EDrawDebugSceneDepthPriorityGroup DepthPriority, float Thickness)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Thickness, Key, Start, End, ArrowSize, Lifetime]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Arrow;
-			DrawCommand.Location = Start;
-			DrawCommand.End = End;
-			DrawCommand.ArrowSize = ArrowSize;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = Thickness;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Arrow;
+	DrawCommand.Location = Start;
+	DrawCommand.End = End;
+	DrawCommand.ArrowSize = ArrowSize;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = Thickness;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
 	
 }
 
-void UOmniEditorLibrary::DrawAndLogText(UObject* WorldContextObject, FVector Location, FString Text, FString Key, FLinearColor Color,
+FOmniDebugShapeHandle UOmniEditorLibrary::DrawAndLogText(UObject* WorldContextObject, FVector Location, FString Text, FString Key, FLinearColor Color,
 	FName LogCategory, float Lifetime, bool bAddToMessageLog, bool bWireframe,
 	EDrawDebugSceneDepthPriorityGroup DepthPriority, float FontSize)
 {
-	AsyncTask(ENamedThreads::GameThread, [WorldContextObject, Color, Text, bAddToMessageLog, bWireframe, LogCategory, DepthPriority, Lifetime, FontSize, Key, Location]()
-	{
-		if(UOmniDebugDrawSubsystem* DrawSubsystem = WorldContextObject->GetWorld()->GetSubsystem<UOmniDebugDrawSubsystem>())
-		{
-			FOmniDebugDrawCommand DrawCommand;
-			DrawCommand.Owner = WorldContextObject;
-			DrawCommand.Type = EOmniDebugDrawType::Text;
-			DrawCommand.Location = Location;
-			DrawCommand.Color = Color;
-			DrawCommand.Text = Text;
-			DrawCommand.AddMessageToLog = bAddToMessageLog;
-			DrawCommand.Lifetime = Lifetime;
-			DrawCommand.Wireframe = bWireframe;
-			DrawCommand.LogCategory = LogCategory;
-			DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
-			DrawCommand.Thickness = FontSize;
-			DrawSubsystem->AddShape(DrawCommand, FName(Key));
-		}
-	});
+	FOmniDebugDrawCommand DrawCommand;
+	DrawCommand.Owner = WorldContextObject;
+	DrawCommand.Type = EOmniDebugDrawType::Text;
+	DrawCommand.Location = Location;
+	DrawCommand.Color = Color;
+	DrawCommand.Text = MoveTemp(Text);
+	DrawCommand.AddMessageToLog = bAddToMessageLog;
+	DrawCommand.Lifetime = Lifetime;
+	DrawCommand.Wireframe = bWireframe;
+	DrawCommand.LogCategory = LogCategory;
+	DrawCommand.DepthPriority =  DepthPriority == EDrawDebugSceneDepthPriorityGroup::World ? ESceneDepthPriorityGroup::SDPG_World : ESceneDepthPriorityGroup::SDPG_Foreground;
+	DrawCommand.Thickness = FontSize;
+	return DrawAndLogShape(WorldContextObject, MoveTemp(DrawCommand), FName(Key));
+}
+
+bool UOmniEditorLibrary::IsDebugShapeValid(UObject* WorldContextObject, FOmniDebugShapeHandle Handle)
+{
+	const UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem && DrawSubsystem->IsShapeValid(Handle);
+}
+
+FOmniDebugShapeHandle UOmniEditorLibrary::FindDebugShape(UObject* WorldContextObject, FString Key)
+{
+	const UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem ? DrawSubsystem->FindShape(FName(Key)) : FOmniDebugShapeHandle();
+}
+
+bool UOmniEditorLibrary::MoveDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, FVector Location)
+{
+	UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem && DrawSubsystem->MoveShape(Handle, Location);
+}
+
+bool UOmniEditorLibrary::RecolorDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, FLinearColor Color)
+{
+	UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem && DrawSubsystem->RecolorShape(Handle, Color);
+}
+
+bool UOmniEditorLibrary::ExtendDebugShapeLifetime(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, float Seconds)
+{
+	UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem && DrawSubsystem->ExtendShapeLifetime(Handle, Seconds);
+}
+
+bool UOmniEditorLibrary::RemoveDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle)
+{
+	UOmniDebugDrawSubsystem* DrawSubsystem = GetDebugDrawSubsystem(WorldContextObject);
+	return DrawSubsystem && DrawSubsystem->RemoveShape(Handle);
 }
@@ -2,11 +2,547 @@
 
 
 #include "FunctionLibraries/OmniTraceLibrary.h"
+#include "OmniToolbox.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/World.h"
 #include "WorldCollision.h"
 #include "FunctionLibraries/OmniEditorLibrary.h"
+#include "Subsystems/OmniAsyncTraceSubsystem.h"
 #include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Async/ParallelFor.h"
+#include "Algo/AnyOf.h"
+#include "Subsystems/OmniTraceCacheSubsystem.h"
+#include "Subsystems/OmniStaticBVHSubsystem.h"
+#include "Developer/OmniTraceStats.h"
+#include "Developer/OmniTraceRecorder.h"
+#include "Developer/OmniTraceHeatmap.h"
+#include "Subsystems/OmniTraceLODSubsystem.h"
+#include "Components/SplineComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Physics Trace"), STAT_OmniTracePhysics, STATGROUP_OmniTrace);
+
+namespace OmniTrace
+{
+    struct FResolvedProfile
+    {
+        FName Profile;
+        ECollisionChannel Channel = ECC_WorldStatic;
+        FCollisionResponseParams ResponseParams;
+    };
+
+    static EAsyncTraceType ToAsyncTraceType(EAsyncTraceResultType ResultType)
+    {
+        if(ResultType == TestResult)
+        {
+            return EAsyncTraceType::Test;
+        }
+        
+        if(ResultType == MultiResult)
+        {
+            return EAsyncTraceType::Multi;
+        }
+        
+        return EAsyncTraceType::Single;
+    }
+
+    /**Queries that were made in Blueprint through a regular "Make" node
+     * have never been compiled. In that case we compile a copy, which
+     * is as slow as the non-query functions.*/
+    static const FOmniTraceQuery& GetCompiledQuery(const FOmniTraceQuery& Query, FOmniTraceQuery& FallbackQuery)
+    {
+        if(Query.IsCompiled())
+        {
+            return Query;
+        }
+
+        FallbackQuery = Query;
+        FallbackQuery.Compile();
+        return FallbackQuery;
+    }
+
+    /**The non-query functions compile a query on the stack through CompileFrom, instead of going
+     * through MakeTraceQuery, which would copy the ignored actors into a new array every call.
+     * The ignored actors of the params and the query live in inline storage, so the
+     * usual handful of ignored actors doesn't allocate. Every call gets its own query,
+     * so callbacks and debug drawing can safely start another trace in the meantime.*/
+    static FOmniTraceQuery CompileLegacyQuery(FName Profile, const FOmniTraceChannelSettings& TraceSettings,
+        const TArray<AActor*>& IgnoredActors, bool TraceComplex, FName TraceTag)
+    {
+        FOmniTraceQuery LegacyQuery;
+
+        FCollisionQueryParams QueryParams;
+        QueryParams.AddIgnoredActors(IgnoredActors);
+        QueryParams.TraceTag = TraceTag;
+        QueryParams.bTraceComplex = TraceComplex;
+
+        ECollisionChannel TraceChannel;
+        FCollisionResponseParams ResponseParams;
+        UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParams);
+        if(TraceSettings.UseTraceType)
+        {
+            TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+        }
+
+        LegacyQuery.CompileFrom(TraceChannel, QueryParams, ResponseParams);
+        return LegacyQuery;
+    }
+
+    /**Runs a single trace of any shape and appends the results to @OutHits.
+     * Line traces are handled by the sweep functions when the shape is a line.
+     * This does not touch any UObject state besides the world, so it's safe
+     * to call from worker threads. */
+    template<typename AllocatorType>
+    static bool RunTrace(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape,
+        EAsyncTraceResultType ResultType, ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams,
+        TArray<FHitResult, AllocatorType>& OutHits)
+    {
+        switch(ResultType)
+        {
+        case MultiResult:
+            {
+                TArray<FHitResult> MultiHits;
+                World->SweepMultiByChannel(MultiHits, Start, End, Rotation, Channel, CollisionShape, QueryParams, ResponseParams);
+                //@OutHits can already contain hits from the caller
+                const bool bHit = MultiHits.Num() > 0;
+                OutHits.Append(MoveTemp(MultiHits));
+                return bHit;
+            }
+        case SingleResult:
+            {
+                FHitResult& SingleHitResult = OutHits.AddDefaulted_GetRef();
+                if(World->SweepSingleByChannel(SingleHitResult, Start, End, Rotation, Channel, CollisionShape, QueryParams, ResponseParams))
+                {
+                    return true;
+                }
+                OutHits.Pop(EAllowShrinking::No);
+                return false;
+            }
+        case TestResult:
+            if(World->SweepTestByChannel(Start, End, Rotation, Channel, CollisionShape, QueryParams, ResponseParams))
+            {
+                OutHits.AddDefaulted();
+                return true;
+            }
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    /**The non-query trace functions predate TraceByQuery and have always been callable from
+     * worker threads, as long as the caller keeps the world alive. Those calls trace the world
+     * directly and skip the cache, LOD, static BVH and debug drawing, which all live on the game thread.*/
+    static TArray<FHitResult> RunLegacyTrace(const UObject* WorldContextObject, EOmniTraceShape Shape, const FVector& Start, const FVector& End,
+        const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query,
+        const FTraceDebug& DebugOptions)
+    {
+        const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+        if(IsInGameThread())
+        {
+            return UOmniTraceLibrary::TraceByQuery(World, Shape, Start, End, Rotation, CollisionShape, ResultType, Query, DebugOptions);
+        }
+
+        TArray<FHitResult> HitResults;
+        if(World)
+        {
+            SCOPE_CYCLE_COUNTER(STAT_OmniTracePhysics);
+            RunTrace(World, Start, End, Rotation, CollisionShape, ResultType, Query.GetChannel(), Query.GetQueryParams(),
+                Query.GetResponseParams(), HitResults);
+        }
+        return HitResults;
+    }
+
+    /**Sweeps every segment of @Points in order and stops at the first blocking hit.
+     * Same as RunTrace, this only touches the world.*/
+    static void RunPolylineTrace(const UWorld* World, TConstArrayView<FVector> Points, const FCollisionShape& CollisionShape, ECollisionChannel Channel,
+        const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams, FOmniPolylineTraceResult& OutResult)
+    {
+        OutResult = FOmniPolylineTraceResult();
+
+        double TravelledDistance = 0;
+        for(int32 SegmentIndex = 0; SegmentIndex + 1 < Points.Num(); ++SegmentIndex)
+        {
+            const FVector& SegmentStart = Points[SegmentIndex];
+            const FVector& SegmentEnd = Points[SegmentIndex + 1];
+            const double SegmentLength = FVector::Dist(SegmentStart, SegmentEnd);
+
+            if(World->SweepSingleByChannel(OutResult.HitResult, SegmentStart, SegmentEnd, FQuat::Identity, Channel, CollisionShape,
+                QueryParams, ResponseParams))
+            {
+                OutResult.bBlockingHit = true;
+                OutResult.SegmentIndex = SegmentIndex;
+                OutResult.SegmentAlpha = OutResult.HitResult.Time;
+                OutResult.Distance = static_cast<float>(TravelledDistance + SegmentLength * OutResult.HitResult.Time);
+                return;
+            }
+
+            TravelledDistance += SegmentLength;
+        }
+
+        OutResult.HitResult = FHitResult();
+        OutResult.Distance = static_cast<float>(TravelledDistance);
+    }
+
+    /**Runs every request in parallel and compacts the results into @OutResults.
+     * @GetSetup is called from worker threads to find out which channel and
+     * params a request should use.*/
+    template<typename SetupFunctionType>
+    static void RunBatch(const UWorld* World, const TArray<FOmniTraceRequest>& Requests, FOmniBatchTraceResult& OutResults, SetupFunctionType&& GetSetup)
+    {
+        /**Single and test traces never produce more than one hit, so
+         * the inline allocator means only multi traces touch the heap.*/
+        TArray<TArray<FHitResult, TInlineAllocator<1>>> RequestHits;
+        RequestHits.SetNum(Requests.Num());
+
+        if(FOmniTraceRecorder::IsRecording())
+        {
+            for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+            {
+                const FOmniTraceRequest& Request = Requests[RequestIndex];
+
+                ECollisionChannel TraceChannel = ECC_WorldStatic;
+                const FCollisionQueryParams* QueryParams = nullptr;
+                const FCollisionResponseParams* ResponseParams = nullptr;
+                GetSetup(RequestIndex, TraceChannel, QueryParams, ResponseParams);
+
+                FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath::Batch, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+                    Request.MakeCollisionShape(), Request.ResultType, TraceChannel, *QueryParams, *ResponseParams);
+            }
+        }
+
+        const bool bRecordHeatmap = FOmniTraceHeatmap::IsEnabled();
+        ParallelFor(TEXT("UOmniTraceLibrary::BatchTrace"), Requests.Num(), 8, [&](int32 RequestIndex)
+        {
+            const FOmniTraceRequest& Request = Requests[RequestIndex];
+
+            ECollisionChannel TraceChannel = ECC_WorldStatic;
+            const FCollisionQueryParams* QueryParams = nullptr;
+            const FCollisionResponseParams* ResponseParams = nullptr;
+            GetSetup(RequestIndex, TraceChannel, QueryParams, ResponseParams);
+
+            RunTrace(World, Request.Start, Request.End, FQuat(Request.Rotation), Request.MakeCollisionShape(), Request.ResultType,
+                TraceChannel, *QueryParams, *ResponseParams, RequestHits[RequestIndex]);
+
+            if(bRecordHeatmap)
+            {
+                FOmniTraceHeatmap::RecordTrace(QueryParams->TraceTag, Request.Start, Request.End, RequestHits[RequestIndex]);
+            }
+        });
+
+        //Compact every result into the contiguous buffer
+        int32 TotalHits = 0;
+        for(const auto& Hits : RequestHits)
+        {
+            TotalHits += Hits.Num();
+        }
+        OutResults.HitResults.Reserve(TotalHits);
+
+        for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+        {
+            FOmniTraceResultRange& Range = OutResults.Ranges.AddDefaulted_GetRef();
+            Range.Offset = OutResults.HitResults.Num();
+            Range.Num = RequestHits[RequestIndex].Num();
+            OutResults.HitResults.Append(MoveTemp(RequestHits[RequestIndex]));
+        }
+    }
+
+    static void DebugBatch(const UWorld* World, const TArray<FOmniTraceRequest>& Requests, const FOmniBatchTraceResult& Results, FTraceDebug DebugOptions)
+    {
+        if(!DebugOptions.bEnableDebug)
+        {
+            return;
+        }
+
+        //Every request gets its own key, otherwise they'd overwrite each other's shapes
+        const FName TraceTag = DebugOptions.TraceTag;
+        for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+        {
+            const FOmniTraceRequest& Request = Requests[RequestIndex];
+            const TArray<FHitResult> Hits(Results.GetHitResultsForRequest(RequestIndex));
+            DebugOptions.TraceTag = FName(TraceTag, RequestIndex + 1);
+            DebugOptions.Start = Request.Start;
+            DebugOptions.End = Request.End;
+            DebugOptions.Rotation = FQuat(Request.Rotation);
+            UOmniTraceLibrary::HandleShapeTraceDebug(World, Request.Shape, Request.MakeCollisionShape(), DebugOptions, Hits);
+        }
+    }
+
+    /**Same defaults as the UOmniEditorLibrary::DrawAndLog functions.
+     * The debug helpers submit through DrawAndLogShape, so their keys stay
+     * FNames instead of being formatted into a string for every shape.*/
+    static FOmniDebugDrawCommand MakeDebugCommand(const UObject* WorldContext, EOmniDebugDrawType Type, const FVector& Location, const FLinearColor& Color)
+    {
+        FOmniDebugDrawCommand Command;
+        Command.Owner = WorldContext->GetWorld();
+        Command.Type = Type;
+        Command.Location = Location;
+        Command.Color = Color;
+        Command.LogCategory = TEXT("VisLog");
+        Command.Lifetime = 3;
+        Command.Thickness = 1.5f;
+        Command.Wireframe = true;
+        Command.DepthPriority = SDPG_World;
+        return Command;
+    }
+
+    static void DrawDebugCommand(const UObject* WorldContext, FOmniDebugDrawCommand&& Command, FName Key)
+    {
+        UOmniEditorLibrary::DrawAndLogShape(WorldContext->GetWorld(), MoveTemp(Command), Key);
+    }
+}
+
+void FOmniTraceQuery::Compile()
+{
+    UCollisionProfile::GetChannelAndResponseParams(Profile, Channel, ResponseParams);
+    
+    //Merge our custom responses with the profile
+    for(auto& CurrentResponse : CustomChannelResponses.ChannelsAndResponses)
+    {
+        ResponseParams.CollisionResponse.SetResponse(CurrentResponse.Channel, CurrentResponse.Response);
+    }
+    
+    if(TraceSettings.UseTraceType)
+    {
+        Channel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+    }
+
+    QueryParams = FCollisionQueryParams();
+    QueryParams.TraceTag = TraceTag;
+    QueryParams.bTraceComplex = TraceComplex;
+    for(const TObjectPtr<AActor>& IgnoredActor : IgnoredActors)
+    {
+        if(IgnoredActor)
+        {
+            QueryParams.AddIgnoredActor(IgnoredActor);
+        }
+    }
+
+    UpdateCacheHash();
+    bCompiled = true;
+}
+
+void FOmniTraceQuery::CompileFrom(ECollisionChannel InChannel, const FCollisionQueryParams& InQueryParams,
+    const FCollisionResponseParams& InResponseParams)
+{
+    Channel = InChannel;
+    QueryParams = InQueryParams;
+    ResponseParams = InResponseParams;
+    TraceComplex = InQueryParams.bTraceComplex;
+    TraceTag = InQueryParams.TraceTag;
+
+    UpdateCacheHash();
+    bCompiled = true;
+}
+
+void FOmniTraceQuery::UpdateCacheHash()
+{
+    /**Both compile paths end up with the ignored actors in the query params,
+     * sorting them makes the same set of actors match regardless of their order.*/
+    SortedIgnoredActorIds.Reset();
+    SortedIgnoredActorIds.Append(QueryParams.GetIgnoredActors());
+    SortedIgnoredActorIds.Sort();
+
+    CacheHash = GetTypeHash(static_cast<uint8>(Channel));
+    CacheHash = HashCombineFast(CacheHash, FCrc::MemCrc32(&ResponseParams.CollisionResponse, sizeof(FCollisionResponseContainer)));
+    for(const uint32 IgnoredActorId : SortedIgnoredActorIds)
+    {
+        CacheHash = HashCombineFast(CacheHash, IgnoredActorId);
+    }
+}
+
+FOmniNetHit::FOmniNetHit(const FHitResult& HitResult)
+    : Actor(HitResult.GetActor())
+    , Component(HitResult.GetComponent())
+    , ImpactPoint(HitResult.ImpactPoint)
+    , Location(HitResult.Location)
+    , ImpactNormal(HitResult.ImpactNormal)
+    , Distance(HitResult.Distance)
+    , bBlockingHit(HitResult.bBlockingHit)
+    , bStartPenetrating(HitResult.bStartPenetrating)
+{
+}
+
+FHitResult FOmniNetHit::ToHitResult() const
+{
+    FHitResult HitResult(Actor.Get(), Component.Get(), ImpactPoint, ImpactNormal);
+    HitResult.Location = Location;
+    HitResult.Distance = Distance;
+    HitResult.bBlockingHit = bBlockingHit;
+    HitResult.bStartPenetrating = bStartPenetrating;
+    return HitResult;
+}
+
+bool FOmniNetHit::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    enum EFlags : uint8
+    {
+        BlockingHit = 1 << 0,
+        StartPenetrating = 1 << 1,
+        HasComponent = 1 << 2,
+        HasActor = 1 << 3,
+        HasLocation = 1 << 4,
+        HasNormal = 1 << 5,
+        HasDistance = 1 << 6,
+    };
+    constexpr uint32 NumFlagBits = 7;
+
+    UObject* HitComponent = nullptr;
+    UObject* HitActor = nullptr;
+    uint8 Flags = 0;
+
+    if(Ar.IsSaving())
+    {
+        const UPrimitiveComponent* PrimitiveComponent = Component.Get();
+        HitComponent = Component.Get();
+        HitActor = Actor.Get();
+
+        Flags |= bBlockingHit ? BlockingHit : 0;
+        Flags |= bStartPenetrating ? StartPenetrating : 0;
+
+        /**Components that can't be referenced over the network are dropped.
+         * The actor is only sent when it can't be taken from the component.*/
+        if(PrimitiveComponent && PrimitiveComponent->IsSupportedForNetworking())
+        {
+            Flags |= HasComponent;
+        }
+        if(HitActor && (!(Flags & HasComponent) || PrimitiveComponent->GetOwner() != HitActor))
+        {
+            Flags |= HasActor;
+        }
+
+        Flags |= !Location.Equals(ImpactPoint, 0.1) ? HasLocation : 0;
+        Flags |= !ImpactNormal.IsNearlyZero() ? HasNormal : 0;
+        Flags |= Distance > 0 ? HasDistance : 0;
+    }
+
+    Ar.SerializeBits(&Flags, NumFlagBits);
+
+    bOutSuccess = true;
+    bool bFieldSuccess = true;
+
+    if(Flags & HasComponent)
+    {
+        Ar << HitComponent;
+    }
+    if(Flags & HasActor)
+    {
+        Ar << HitActor;
+    }
+
+    ImpactPoint.NetSerialize(Ar, Map, bFieldSuccess);
+    bOutSuccess &= bFieldSuccess;
+
+    if(Flags & HasLocation)
+    {
+        Location.NetSerialize(Ar, Map, bFieldSuccess);
+        bOutSuccess &= bFieldSuccess;
+    }
+
+    if(Flags & HasNormal)
+    {
+        ImpactNormal.NetSerialize(Ar, Map, bFieldSuccess);
+        bOutSuccess &= bFieldSuccess;
+    }
+
+    uint32 QuantizedDistance = Ar.IsSaving() ? static_cast<uint32>(FMath::RoundToInt32(FMath::Max(Distance, 0.f) * 10.f)) : 0;
+    if(Flags & HasDistance)
+    {
+        Ar.SerializeIntPacked(QuantizedDistance);
+    }
+
+    if(Ar.IsLoading())
+    {
+        bBlockingHit = (Flags & BlockingHit) != 0;
+        bStartPenetrating = (Flags & StartPenetrating) != 0;
+        Component = Cast<UPrimitiveComponent>(HitComponent);
+        Actor = (Flags & HasActor) ? Cast<AActor>(HitActor) : Component.IsValid() ? Component->GetOwner() : nullptr;
+        if(!(Flags & HasLocation))
+        {
+            Location = ImpactPoint;
+        }
+        if(!(Flags & HasNormal))
+        {
+            ImpactNormal = FVector::ZeroVector;
+        }
+        Distance = QuantizedDistance / 10.f;
+    }
+
+    return true;
+}
+
+bool FOmniNetHitArray::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    uint32 NumHits = FMath::Min(Hits.Num(), MaxHits);
+    if(Ar.IsSaving() && Hits.Num() > MaxHits)
+    {
+        UE_LOG(LogOmniToolbox, Warning, TEXT("FOmniNetHitArray: Only the first %d of %d hits are replicated"), MaxHits, Hits.Num());
+    }
+    Ar.SerializeIntPacked(NumHits);
+
+    if(Ar.IsLoading())
+    {
+        if(NumHits > static_cast<uint32>(MaxHits))
+        {
+            Ar.SetError();
+            bOutSuccess = false;
+            return true;
+        }
+
+        Hits.SetNum(NumHits);
+    }
+
+    bOutSuccess = true;
+    for(uint32 HitIndex = 0; HitIndex < NumHits && !Ar.IsError(); ++HitIndex)
+    {
+        bool bHitSuccess = true;
+        Hits[HitIndex].NetSerialize(Ar, Map, bHitSuccess);
+        bOutSuccess &= bHitSuccess;
+    }
+
+    return true;
+}
+
+FOmniOverlapResult::FOmniOverlapResult(const FOverlapResult& Overlap)
+    : Component(Overlap.GetComponent())
+    , Actor(Overlap.GetActor())
+    , ItemIndex(Overlap.ItemIndex)
+    , bBlockingHit(Overlap.bBlockingHit)
+{
+}
+
+FCollisionShape FOmniOverlapRequest::MakeCollisionShape() const
+{
+    switch(Shape)
+    {
+    case EOmniTraceShape::Sphere:
+        return FCollisionShape::MakeSphere(Radius);
+    case EOmniTraceShape::Capsule:
+        return FCollisionShape::MakeCapsule(Radius, HalfHeight);
+    case EOmniTraceShape::Box:
+        return FCollisionShape::MakeBox(Extent);
+    case EOmniTraceShape::Line:
+    default:
+        return FCollisionShape();
+    }
+}
+
+FCollisionShape FOmniTraceRequest::MakeCollisionShape() const
+{
+    switch(Shape)
+    {
+    case EOmniTraceShape::Sphere:
+        return FCollisionShape::MakeSphere(Radius);
+    case EOmniTraceShape::Capsule:
+        return FCollisionShape::MakeCapsule(Radius, HalfHeight);
+    case EOmniTraceShape::Box:
+        return FCollisionShape::MakeBox(Extent);
+    case EOmniTraceShape::Line:
+    default:
+        return FCollisionShape();
+    }
+}
 
 
 FCollisionResponseContainer UOmniTraceLibrary::CreateResponseContainerFromProfile(FName ProfileName,
@@ -43,32 +579,38 @@ void UOmniTraceLibrary::FilterHitResultsByLineOfSight(TArray<FHitResult>& HitRes
     FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex,
     FTraceDebug DebugOptions)
 {
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
-    {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
-    }
-    
-    for(int i = 0; i < HitResultsToFilter.Num(); ++i)
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    FilterHitResultsByLineOfSightByQuery(HitResultsToFilter, WorldContextObject, Start, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncFilterHitResultsByLineOfSight(const TArray<FHitResult>& HitResultsToFilter,
+    UObject* WorldContextObject, const FVector& Start, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    const TArray<AActor*>& IgnoredActors, FAsyncTraceResultDelegate OnFilterCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncFilterHitResultsByLineOfSightByQuery(HitResultsToFilter, WorldContextObject, Start, Query, OnFilterCompleted, DebugOptions);
+}
+
+void UOmniTraceLibrary::RemoveHitResultsWithoutLineOfSight(TArray<FHitResult>& HitResults, TConstArrayView<bool> HasLineOfSight)
+{
+    check(HitResults.Num() == HasLineOfSight.Num());
+
+    int32 WriteIndex = 0;
+    for(int32 ReadIndex = 0; ReadIndex < HitResults.Num(); ++ReadIndex)
     {
-        bool bHit;
-        FHitResult SingleHitResult;
-        bHit = WorldContextObject->GetWorld()->LineTraceSingleByChannel(SingleHitResult, Start, HitResultsToFilter[i].ImpactPoint, TraceChannel, QueryParams, ResponseParam);
-        if(bHit && SingleHitResult.GetComponent() != HitResultsToFilter[i].GetComponent())
+        if(!HasLineOfSight[ReadIndex])
+        {
+            continue;
+        }
+
+        if(WriteIndex != ReadIndex)
         {
-            HitResultsToFilter.RemoveAt(i, EAllowShrinking::No);
-            i--;
+            HitResults[WriteIndex] = MoveTemp(HitResults[ReadIndex]);
         }
+        WriteIndex++;
     }
-    
-    HitResultsToFilter.Shrink();
+
+    HitResults.SetNum(WriteIndex, EAllowShrinking::No);
 }
 
 TArray<FHitResult> UOmniTraceLibrary::LineTrace(UObject* WorldContextObject,
@@ -81,425 +623,1540 @@ TArray<FHitResult> UOmniTraceLibrary::LineTrace(UObject* WorldContextObject,
                                                 bool TraceComplex,
                                                 FTraceDebug DebugOptions)
 {
-    TRACE_CPUPROFILER_EVENT_SCOPE(UTraceHelpersLibrary::LineTrace);
-    
-    TArray<FHitResult> HitResult;
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
-    {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
-    }
-
-    bool bHit;
-    FHitResult SingleHitResult;
-    switch(ResultType)
-    {
-    case MultiResult:
-        WorldContextObject->GetWorld()->LineTraceMultiByChannel(HitResult, Start, End, TraceChannel, QueryParams, ResponseParam);
-        break;
-    case SingleResult:
-        bHit = WorldContextObject->GetWorld()->LineTraceSingleByChannel(SingleHitResult, Start, End, TraceChannel, QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    case TestResult:
-        bHit = WorldContextObject->GetWorld()->LineTraceTestByChannel(Start, End, TraceChannel, QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    default:
-        break;
-    }
-    
-    HandleLineTraceDebug(WorldContextObject, DebugOptions, HitResult);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::LineTrace);
 
-    return HitResult;
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    return OmniTrace::RunLegacyTrace(WorldContextObject, EOmniTraceShape::Line, Start, End, FQuat::Identity, FCollisionShape(),
+        ResultType, Query, DebugOptions);
 }
 
 void UOmniTraceLibrary::AsyncLineTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End, TEnumAsByte<EAsyncTraceResultType> ResultType,
     const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
 {
-    if(!WorldContextObject)
-    {
-        return;
-    }
-    
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncLineTraceByQuery(WorldContextObject, Start, End, ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::SphereTrace(UObject* WorldContextObject, const FVector& Start,
+    const FVector& End, const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType,
+    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex,
+    FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::SphereTrace);
+
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    return OmniTrace::RunLegacyTrace(WorldContextObject, EOmniTraceShape::Sphere, Start, End, FQuat::Identity,
+        FCollisionShape::MakeSphere(Radius), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncSphereTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType, const TArray<AActor*>& IgnoredActors,
+    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, 
+    FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncSphereTraceByQuery(WorldContextObject, Start, End, Radius, ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::CapsuleTrace(UObject* WorldContextObject, const FVector& Start,
+                                                      const FVector& End, FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
+                                                      UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, 
+                                                      const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::CapsuleTrace);
+
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    return OmniTrace::RunLegacyTrace(WorldContextObject, EOmniTraceShape::Capsule, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeCapsule(Radius, HalfHeight), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncCapsuleTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
+    const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, 
+    FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncCapsuleTraceByQuery(WorldContextObject, Start, End, Rotation, Radius, HalfHeight, ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::BoxTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const FVector& Extent,
+    TEnumAsByte<EAsyncTraceResultType> ResultType,
+    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors,
+    bool TraceComplex, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BoxTrace);
+
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    return OmniTrace::RunLegacyTrace(WorldContextObject, EOmniTraceShape::Box, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeBox(Extent), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncBoxTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    FRotator Rotation, const FVector& Extent, TEnumAsByte<EAsyncTraceResultType> ResultType,
+    const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile,
+    FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncBoxTraceByQuery(WorldContextObject, Start, End, Rotation, Extent, ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+FOmniTraceQuery UOmniTraceLibrary::MakeTraceQuery(FName Profile, FOmniTraceChannelSettings TraceSettings,
+    const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceChannelAndResponseContainer CustomChannelResponses, FName TraceTag)
+{
+    FOmniTraceQuery Query;
+    Query.Profile = Profile;
+    Query.TraceSettings = TraceSettings;
+    Query.CustomChannelResponses = MoveTemp(CustomChannelResponses);
+    Query.TraceComplex = TraceComplex;
+    Query.IgnoredActors.Append(IgnoredActors);
+    Query.TraceTag = TraceTag;
+    Query.Compile();
+    return Query;
+}
+
+void UOmniTraceLibrary::FilterHitResultsByLineOfSightByQuery(TArray<FHitResult>& HitResultsToFilter,
+    UObject* WorldContextObject, const FVector& Start, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World)
+    {
+        return;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::FilterHitResultsByLineOfSight);
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+    const ECollisionChannel TraceChannel = CompiledQuery.GetChannel();
+    const FCollisionQueryParams& QueryParams = CompiledQuery.GetQueryParams();
+    const FCollisionResponseParams& ResponseParams = CompiledQuery.GetResponseParams();
+
+    /**Explosions can easily pass in a few hundred overlaps,
+     * so every trace is performed in parallel and the hit results
+     * are only moved once at the end.*/
+    TArray<bool, TInlineAllocator<256>> HasLineOfSight;
+    HasLineOfSight.SetNumUninitialized(HitResultsToFilter.Num());
+
+    ParallelFor(TEXT("UOmniTraceLibrary::FilterHitResultsByLineOfSight"), HitResultsToFilter.Num(), 16, [&](int32 Index)
+    {
+        const FHitResult& HitResultToFilter = HitResultsToFilter[Index];
+        FHitResult SingleHitResult;
+        const bool bHit = World->LineTraceSingleByChannel(SingleHitResult, Start, HitResultToFilter.ImpactPoint, TraceChannel,
+            QueryParams, ResponseParams);
+        HasLineOfSight[Index] = !bHit || SingleHitResult.GetComponent() == HitResultToFilter.GetComponent();
+    });
+
+    RemoveHitResultsWithoutLineOfSight(HitResultsToFilter, HasLineOfSight);
+}
+
+void UOmniTraceLibrary::AsyncFilterHitResultsByLineOfSightByQuery(const TArray<FHitResult>& HitResultsToFilter,
+    UObject* WorldContextObject, const FVector& Start, const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnFilterCompleted,
+    FTraceDebug DebugOptions)
+{
+    UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World)
+    {
+        return;
+    }
+
+    UOmniAsyncTraceSubsystem* AsyncTraceSubsystem = World->GetSubsystem<UOmniAsyncTraceSubsystem>();
+    if(!AsyncTraceSubsystem)
+    {
+        return;
+    }
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    AsyncTraceSubsystem->QueueLineOfSightFilter(HitResultsToFilter, Start, CompiledQuery.GetChannel(), CompiledQuery.GetQueryParams(),
+        CompiledQuery.GetResponseParams(), OnFilterCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::LineTraceByQuery(UObject* WorldContextObject, const FVector& Start,
+    const FVector& End, TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    return TraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Line, Start, End, FQuat::Identity,
+        FCollisionShape(), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncLineTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    AsyncTraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Line, Start, End, FQuat::Identity,
+        FCollisionShape(), ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::SphereTraceByQuery(UObject* WorldContextObject, const FVector& Start,
+    const FVector& End, const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    return TraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Sphere, Start, End, FQuat::Identity,
+        FCollisionShape::MakeSphere(Radius), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncSphereTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query,
+    FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    AsyncTraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Sphere, Start, End, FQuat::Identity,
+        FCollisionShape::MakeSphere(Radius), ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::CapsuleTraceByQuery(UObject* WorldContextObject, const FVector& Start,
+    const FVector& End, FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
+    const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    return TraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Capsule, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeCapsule(Radius, HalfHeight), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncCapsuleTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
+    const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    AsyncTraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Capsule, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeCapsule(Radius, HalfHeight), ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::BoxTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    FRotator Rotation, const FVector& Extent, TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    return TraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Box, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeBox(Extent), ResultType, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncBoxTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End,
+    FRotator Rotation, const FVector& Extent, TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query,
+    FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    AsyncTraceByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Box, Start, End, FQuat(Rotation),
+        FCollisionShape::MakeBox(Extent), ResultType, Query, OnTraceCompleted, DebugOptions);
+}
+
+TArray<FHitResult> UOmniTraceLibrary::TraceByQuery(const UWorld* World, EOmniTraceShape Shape, const FVector& Start,
+    const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+    const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::TraceByQuery);
+
+    TArray<FHitResult> HitResult;
+    if(!World)
+    {
+        return HitResult;
+    }
+
+    /**The cache, static BVH and debug drawing all assume the game thread.
+     * Catch callers that should be using the thread safe version.*/
+    ensureMsgf(IsInGameThread(), TEXT("UOmniTraceLibrary::TraceByQuery called off the game thread, use TraceByQueryThreadSafe instead"));
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    const FName TraceTag = DebugOptions.TraceTag.IsNone() ? CompiledQuery.GetQueryParams().TraceTag : DebugOptions.TraceTag;
+    const bool bRecordStats = FOmniTraceStats::IsEnabled();
+    const uint64 StartCycles = bRecordStats ? FPlatformTime::Cycles64() : 0;
+#if STATS
+    FScopeCycleCounter TagCycleCounter(bRecordStats ? FOmniTraceStats::GetTagStatId(TraceTag) : TStatId());
+#endif
+
+    if(FOmniTraceRecorder::IsRecording())
+    {
+        FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath::Sync, Shape, Start, End, Rotation, CollisionShape, ResultType,
+            CompiledQuery.GetChannel(), CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams());
+    }
+
+    const UOmniTraceLODPolicy* LODPolicy = UOmniTraceLODPolicy::IsLODEnabled() ? CompiledQuery.LODPolicy.Get() : nullptr;
+    UOmniTraceLODSubsystem* LODSubsystem = LODPolicy ? World->GetSubsystem<UOmniTraceLODSubsystem>() : nullptr;
+    FOmniTraceLODDecision LODDecision;
+    if(LODSubsystem)
+    {
+        LODDecision = LODSubsystem->Evaluate(*LODPolicy, Shape, Start, End, Rotation, CollisionShape, ResultType, CompiledQuery);
+        ResultType = LODDecision.ResultType;
+    }
+
+    /**Simplified traces only copy the params when they actually have to change*/
+    const FCollisionQueryParams* QueryParams = &CompiledQuery.GetQueryParams();
+    FCollisionQueryParams SimpleQueryParams;
+    if(LODDecision.bForceSimpleCollision)
+    {
+        SimpleQueryParams = *QueryParams;
+        SimpleQueryParams.bTraceComplex = false;
+        QueryParams = &SimpleQueryParams;
+    }
+
+    //The cache key doesn't know about simplified traces, so those skip the cache
+    UOmniTraceCacheSubsystem* TraceCache = nullptr;
+    FOmniTraceCacheKey CacheKey;
+    if(CompiledQuery.CacheFrames > 0 && UOmniTraceCacheSubsystem::IsCacheEnabled() && IsInGameThread()
+        && !LODDecision.bForceSimpleCollision)
+    {
+        TraceCache = World->GetSubsystem<UOmniTraceCacheSubsystem>();
+    }
+
+    if(TraceCache)
+    {
+        CacheKey = UOmniTraceCacheSubsystem::MakeKey(Shape, Start, End, Rotation, CollisionShape, ResultType, CompiledQuery);
+    }
+
+    if(LODSubsystem && LODSubsystem->FindReusableResult(*LODPolicy, LODDecision, HitResult))
+    {
+        //Reused from an earlier trace, no need to go to the cache or physics
+    }
+    else if(!TraceCache || !TraceCache->FindCachedTrace(CacheKey, HitResult))
+    {
+        FOmniStaticBVHSnapshotPtr StaticBVH;
+        if(CompiledQuery.UseStaticBVH && !QueryParams->bTraceComplex
+            && (Shape == EOmniTraceShape::Line || Shape == EOmniTraceShape::Sphere))
+        {
+            if(const UOmniStaticBVHSubsystem* StaticBVHSubsystem = World->GetSubsystem<UOmniStaticBVHSubsystem>())
+            {
+                StaticBVH = StaticBVHSubsystem->GetSnapshot();
+            }
+        }
+
+        if(StaticBVH.IsValid())
+        {
+            const FOmniBVHQueryFilter Filter(CompiledQuery.GetChannel(), *QueryParams, CompiledQuery.GetResponseParams());
+            StaticBVH->Trace(Start, End, Shape == EOmniTraceShape::Sphere ? CollisionShape.GetSphereRadius() : 0,
+                OmniTrace::ToAsyncTraceType(ResultType), Filter, HitResult);
+        }
+        else
+        {
+            SCOPE_CYCLE_COUNTER(STAT_OmniTracePhysics);
+
+            OmniTrace::RunTrace(World, Start, End, Rotation, CollisionShape, ResultType, CompiledQuery.GetChannel(),
+                *QueryParams, CompiledQuery.GetResponseParams(), HitResult);
+        }
+
+        if(TraceCache)
+        {
+            TraceCache->AddCachedTrace(CacheKey, HitResult, CompiledQuery.CacheFrames);
+        }
+
+        if(LODSubsystem)
+        {
+            LODSubsystem->StoreResult(*LODPolicy, LODDecision, HitResult);
+        }
+    }
+
+    if(bRecordStats)
+    {
+        FOmniTraceStats::RecordTrace(TraceTag, Shape, ResultType, HitResult.Num(), FPlatformTime::Cycles64() - StartCycles);
+    }
+
+    if(FOmniTraceHeatmap::IsEnabled())
+    {
+        FOmniTraceHeatmap::RecordTrace(TraceTag, Start, End, HitResult);
+    }
+
+    DebugOptions.Start = Start;
+    DebugOptions.End = End;
+    DebugOptions.Rotation = Rotation;
+    HandleShapeTraceDebug(World, Shape, CollisionShape, DebugOptions, HitResult);
+
+    return HitResult;
+}
+
+bool UOmniTraceLibrary::TraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, EOmniTraceShape Shape, const FVector& Start,
+    const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+    const FOmniTraceQuery& Query, TArray<FHitResult>& OutHits)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::TraceByQueryThreadSafe);
+
+    /**Compiling a query on a worker thread would race with the game thread
+     * compiling or modifying the same query, so it has to be done up front.*/
+    checkf(Query.IsCompiled(), TEXT("TraceByQueryThreadSafe requires a query that has been compiled on the game thread"));
+    checkf(World.GetWorldUnsafe(), TEXT("TraceByQueryThreadSafe was given a handle without a world, create it on the game thread first"));
+
+    const bool bRecordStats = FOmniTraceStats::IsEnabled();
+    const uint64 StartCycles = bRecordStats ? FPlatformTime::Cycles64() : 0;
+
+    if(FOmniTraceRecorder::IsRecording())
+    {
+        FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath::Sync, Shape, Start, End, Rotation, CollisionShape, ResultType,
+            Query.GetChannel(), Query.GetQueryParams(), Query.GetResponseParams());
+    }
+
+    const int32 PreviousNum = OutHits.Num();
+    bool bHit = false;
+
+    /**The handle keeps the world from being cleaned up while we trace.
+     * The physics scene's read lock is not taken here on purpose. UWorld's scene queries
+     * already take it through FScopedSceneReadLock (Engine/Private/Collision/SceneQuery.cpp),
+     * and the lock isn't recursive, so a second read lock on the same thread would
+     * deadlock as soon as the physics thread is waiting for the write lock.
+     * The static BVH snapshot is immutable and doesn't need the lock at all.*/
+    const FOmniStaticBVHSnapshotPtr& StaticBVH = World.GetStaticBVH();
+    const bool bUseStaticBVH = StaticBVH.IsValid() && Query.UseStaticBVH && !Query.GetQueryParams().bTraceComplex
+        && (Shape == EOmniTraceShape::Line || Shape == EOmniTraceShape::Sphere);
+
+    World.ExecuteRead([&](const UWorld& TraceWorld)
+    {
+        if(bUseStaticBVH)
+        {
+            const FOmniBVHQueryFilter Filter(Query.GetChannel(), Query.GetQueryParams(), Query.GetResponseParams());
+            StaticBVH->Trace(Start, End, Shape == EOmniTraceShape::Sphere ? CollisionShape.GetSphereRadius() : 0,
+                OmniTrace::ToAsyncTraceType(ResultType), Filter, OutHits);
+            bHit = OutHits.Num() > PreviousNum;
+            return;
+        }
+
+        SCOPE_CYCLE_COUNTER(STAT_OmniTracePhysics);
+
+        bHit = OmniTrace::RunTrace(&TraceWorld, Start, End, Rotation, CollisionShape, ResultType, Query.GetChannel(),
+            Query.GetQueryParams(), Query.GetResponseParams(), OutHits);
+    });
+
+    if(bRecordStats)
+    {
+        const FName TraceTag = Query.GetQueryParams().TraceTag;
+        FOmniTraceStats::RecordTrace(TraceTag, Shape, ResultType, OutHits.Num() - PreviousNum, FPlatformTime::Cycles64() - StartCycles);
+    }
+
+    if(FOmniTraceHeatmap::IsEnabled())
+    {
+        FOmniTraceHeatmap::RecordTrace(Query.GetQueryParams().TraceTag, Start, End, MakeArrayView(OutHits).RightChop(PreviousNum));
+    }
+
+    return bHit;
+}
+
+bool UOmniTraceLibrary::LineTraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, const FVector& Start, const FVector& End,
+    EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query, TArray<FHitResult>& OutHits)
+{
+    return TraceByQueryThreadSafe(World, EOmniTraceShape::Line, Start, End, FQuat::Identity, FCollisionShape::LineShape,
+        ResultType, Query, OutHits);
+}
+
+void UOmniTraceLibrary::AsyncTraceByQuery(UWorld* World, EOmniTraceShape Shape, const FVector& Start,
+    const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+    const FOmniTraceQuery& Query, const FAsyncTraceResultDelegate& OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    if(!World)
+    {
+        return;
+    }
+
+    UOmniAsyncTraceSubsystem* AsyncTraceSubsystem = World->GetSubsystem<UOmniAsyncTraceSubsystem>();
+    if(!AsyncTraceSubsystem)
+    {
+        return;
+    }
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    if(FOmniTraceRecorder::IsRecording())
+    {
+        FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath::Async, Shape, Start, End, Rotation, CollisionShape, ResultType,
+            CompiledQuery.GetChannel(), CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams());
+    }
+
+    DebugOptions.Start = Start;
+    DebugOptions.End = End;
+    DebugOptions.Rotation = Rotation;
+
+    /**Async traces only get downgraded. Reusing results would mean
+     * dispatching them ourselves, which the subsystem doesn't support.*/
+    const UOmniTraceLODPolicy* LODPolicy = UOmniTraceLODPolicy::IsLODEnabled() ? CompiledQuery.LODPolicy.Get() : nullptr;
+    if(UOmniTraceLODSubsystem* LODSubsystem = LODPolicy ? World->GetSubsystem<UOmniTraceLODSubsystem>() : nullptr)
+    {
+        const FOmniTraceLODDecision LODDecision = LODSubsystem->Evaluate(*LODPolicy, Shape, Start, End, Rotation, CollisionShape, ResultType, CompiledQuery);
+        if(LODDecision.bForceSimpleCollision)
+        {
+            FCollisionQueryParams SimpleQueryParams = CompiledQuery.GetQueryParams();
+            SimpleQueryParams.bTraceComplex = false;
+            AsyncTraceSubsystem->QueueTrace(Shape, Start, End, Rotation, CollisionShape, OmniTrace::ToAsyncTraceType(LODDecision.ResultType),
+                CompiledQuery.GetChannel(), SimpleQueryParams, CompiledQuery.GetResponseParams(), OnTraceCompleted, DebugOptions);
+            return;
+        }
+
+        ResultType = LODDecision.ResultType;
+    }
+
+    AsyncTraceSubsystem->QueueTrace(Shape, Start, End, Rotation, CollisionShape, OmniTrace::ToAsyncTraceType(ResultType), CompiledQuery.GetChannel(),
+        CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams(), OnTraceCompleted, DebugOptions);
+}
+
+void UOmniTraceLibrary::BatchTrace(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests,
+    const TArray<AActor*>& IgnoredActors, FOmniBatchTraceResult& OutResults, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BatchTrace);
+
+    OutResults.HitResults.Reset();
+    OutResults.Ranges.Reset(Requests.Num());
+
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Requests.IsEmpty())
+    {
+        return;
+    }
+
+    /**Every request shares the same ignore list, so we only build it once.
+     * The complex flag is the only thing that differs per request.*/
+    FCollisionQueryParams SimpleQueryParams;
+    SimpleQueryParams.AddIgnoredActors(IgnoredActors);
+    SimpleQueryParams.TraceTag = DebugOptions.TraceTag;
+    SimpleQueryParams.bTraceComplex = false;
+    FCollisionQueryParams ComplexQueryParams = SimpleQueryParams;
+    ComplexQueryParams.bTraceComplex = true;
+
+    /**Resolve every unique profile once on the game thread.
+     * Most batches only use a handful of profiles, so a linear
+     * search is cheaper than hashing.*/
+    TArray<OmniTrace::FResolvedProfile, TInlineAllocator<8>> ResolvedProfiles;
+    TArray<int32> ProfileIndices;
+    ProfileIndices.SetNumUninitialized(Requests.Num());
+    for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+    {
+        const FName Profile = Requests[RequestIndex].Profile;
+        int32 FoundIndex = ResolvedProfiles.IndexOfByPredicate([Profile](const OmniTrace::FResolvedProfile& Resolved)
+        {
+            return Resolved.Profile == Profile;
+        });
+
+        if(FoundIndex == INDEX_NONE)
+        {
+            OmniTrace::FResolvedProfile& NewProfile = ResolvedProfiles.AddDefaulted_GetRef();
+            NewProfile.Profile = Profile;
+            UCollisionProfile::GetChannelAndResponseParams(Profile, NewProfile.Channel, NewProfile.ResponseParams);
+            FoundIndex = ResolvedProfiles.Num() - 1;
+        }
+
+        ProfileIndices[RequestIndex] = FoundIndex;
+    }
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    OmniTrace::RunBatch(World, Requests, OutResults, [&](int32 RequestIndex, ECollisionChannel& OutChannel,
+        const FCollisionQueryParams*& OutQueryParams, const FCollisionResponseParams*& OutResponseParams)
+    {
+        const FOmniTraceRequest& Request = Requests[RequestIndex];
+        const OmniTrace::FResolvedProfile& Resolved = ResolvedProfiles[ProfileIndices[RequestIndex]];
+
+        OutChannel = Request.TraceSettings.UseTraceType ? UEngineTypes::ConvertToCollisionChannel(Request.TraceSettings.TraceType) : Resolved.Channel;
+        OutQueryParams = Request.TraceComplex ? &ComplexQueryParams : &SimpleQueryParams;
+        OutResponseParams = &Resolved.ResponseParams;
+    });
+
+    if(FOmniTraceStats::IsEnabled())
+    {
+        FOmniTraceStats::RecordBatch(DebugOptions.TraceTag, Requests, OutResults, FPlatformTime::Cycles64() - StartCycles);
+    }
+
+    OmniTrace::DebugBatch(World, Requests, OutResults, DebugOptions);
+}
+
+void UOmniTraceLibrary::BatchTraceByQuery(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests,
+    const FOmniTraceQuery& Query, FOmniBatchTraceResult& OutResults, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BatchTraceByQuery);
+
+    OutResults.HitResults.Reset();
+    OutResults.Ranges.Reset(Requests.Num());
+
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Requests.IsEmpty())
+    {
+        return;
+    }
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    OmniTrace::RunBatch(World, Requests, OutResults, [&CompiledQuery](int32 RequestIndex, ECollisionChannel& OutChannel,
+        const FCollisionQueryParams*& OutQueryParams, const FCollisionResponseParams*& OutResponseParams)
+    {
+        OutChannel = CompiledQuery.GetChannel();
+        OutQueryParams = &CompiledQuery.GetQueryParams();
+        OutResponseParams = &CompiledQuery.GetResponseParams();
+    });
+
+    if(FOmniTraceStats::IsEnabled())
+    {
+        const FName TraceTag = DebugOptions.TraceTag.IsNone() ? CompiledQuery.GetQueryParams().TraceTag : DebugOptions.TraceTag;
+        FOmniTraceStats::RecordBatch(TraceTag, Requests, OutResults, FPlatformTime::Cycles64() - StartCycles);
+    }
+
+    OmniTrace::DebugBatch(World, Requests, OutResults, DebugOptions);
+}
+
+namespace OmniTrace
+{
+    /**Per worker scratch memory used while running a compact batch*/
+    struct FCompactTraceWorkerContext
+    {
+        struct FRequestRecord
+        {
+            int32 RequestIndex = 0;
+            int32 Offset = 0;
+            int32 Num = 0;
+            bool bHit = false;
+        };
+
+        TArray<FRequestRecord> Records;
+        TArray<FOmniCompactHit> Hits;
+        TArray<const UPrimitiveComponent*> HitComponents;
+        TArray<FHitResult> ScratchHits;
+
+        void Reset()
+        {
+            Records.Reset();
+            Hits.Reset();
+            HitComponents.Reset();
+            ScratchHits.Reset();
+        }
+    };
+
+    /**Open addressing table from component to its index in FOmniCompactTraceResults::Components.
+     * Sized to at least twice the amount of hits before the merge, so it can never fill up
+     * and inserting never allocates. Its arrays keep their memory between batches.*/
+    struct FCompactComponentTable
+    {
+        TArray<const UPrimitiveComponent*> Keys;
+        TArray<int32> Values;
+        uint32 Mask = 0;
+
+        void Reset(int32 NumHits)
+        {
+            const int32 Capacity = static_cast<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(NumHits * 2, 16)));
+            Keys.SetNumUninitialized(Capacity, EAllowShrinking::No);
+            Values.SetNumUninitialized(Capacity, EAllowShrinking::No);
+            FMemory::Memzero(Keys.GetData(), Capacity * sizeof(const UPrimitiveComponent*));
+            Mask = Capacity - 1;
+        }
+
+        /**INDEX_NONE if the component hasn't been added yet*/
+        int32& FindOrAdd(const UPrimitiveComponent* Component)
+        {
+            uint32 Slot = PointerHash(Component) & Mask;
+            while(Keys[Slot] && Keys[Slot] != Component)
+            {
+                Slot = (Slot + 1) & Mask;
+            }
+
+            if(!Keys[Slot])
+            {
+                Keys[Slot] = Component;
+                Values[Slot] = INDEX_NONE;
+            }
+            return Values[Slot];
+        }
+    };
+
+    /**Kept alive between calls so every array keeps its memory, instead of
+     * living inside of the Blueprint visible FOmniCompactTraceResults.
+     * One per calling thread, ParallelForWithTaskContext would recreate the contexts every call.*/
+    struct FCompactTraceScratch
+    {
+        TArray<FCompactTraceWorkerContext> WorkerContexts;
+        FCompactComponentTable ComponentTable;
+    };
+
+    FCompactTraceScratch& GetCompactTraceScratch()
+    {
+        thread_local FCompactTraceScratch Scratch;
+        return Scratch;
+    }
+}
+
+void UOmniTraceLibrary::BatchTraceCompact(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests,
+    const FOmniTraceQuery& Query, FOmniCompactTraceResults& Results)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BatchTraceCompact);
+
+    Results.Reset();
+
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Requests.IsEmpty())
+    {
+        return;
+    }
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+    const ECollisionChannel TraceChannel = CompiledQuery.GetChannel();
+    const FCollisionQueryParams& QueryParams = CompiledQuery.GetQueryParams();
+    const FCollisionResponseParams& ResponseParams = CompiledQuery.GetResponseParams();
+
+    if(FOmniTraceRecorder::IsRecording())
+    {
+        for(const FOmniTraceRequest& Request : Requests)
+        {
+            FOmniTraceRecorder::RecordTrace(EOmniRecordedTracePath::Batch, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+                Request.MakeCollisionShape(), Request.ResultType, TraceChannel, QueryParams, ResponseParams);
+        }
+    }
+
+    OmniTrace::FCompactTraceScratch& Scratch = OmniTrace::GetCompactTraceScratch();
+    const int32 NumContexts = FMath::Min(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, Requests.Num());
+    if(Scratch.WorkerContexts.Num() < NumContexts)
+    {
+        Scratch.WorkerContexts.SetNum(NumContexts);
+    }
+    for(OmniTrace::FCompactTraceWorkerContext& Context : Scratch.WorkerContexts)
+    {
+        Context.Reset();
+    }
+
+    /**Each worker writes into its own context, which are merged afterwards.
+     * The bit array is only written to during the merge, since neighbouring
+     * bits share the same word and can't be written to from multiple threads.*/
+    const bool bRecordHeatmap = FOmniTraceHeatmap::IsEnabled();
+    ParallelForWithExistingTaskContext(MakeArrayView(Scratch.WorkerContexts), Requests.Num(), 16,
+        [&](OmniTrace::FCompactTraceWorkerContext& Context, int32 RequestIndex)
+    {
+        const FOmniTraceRequest& Request = Requests[RequestIndex];
+        const FVector& Start = Request.Start;
+        const FVector& End = Request.End;
+        const FQuat Rotation = FQuat(Request.Rotation);
+        const FCollisionShape CollisionShape = Request.MakeCollisionShape();
+
+        OmniTrace::FCompactTraceWorkerContext::FRequestRecord& Record = Context.Records.AddDefaulted_GetRef();
+        Record.RequestIndex = RequestIndex;
+        Record.Offset = Context.Hits.Num();
+
+        auto AddCompactHit = [&Context](const FHitResult& HitResult)
+        {
+            FOmniCompactHit& CompactHit = Context.Hits.AddDefaulted_GetRef();
+            CompactHit.Distance = HitResult.Distance;
+            CompactHit.ImpactPoint = HitResult.ImpactPoint;
+            CompactHit.ImpactNormal = HitResult.ImpactNormal;
+            CompactHit.bBlockingHit = HitResult.bBlockingHit;
+            Context.HitComponents.Add(HitResult.GetComponent());
+        };
+
+        switch(Request.ResultType)
+        {
+        case MultiResult:
+            Context.ScratchHits.Reset();
+            World->SweepMultiByChannel(Context.ScratchHits, Start, End, Rotation, TraceChannel, CollisionShape, QueryParams, ResponseParams);
+            for(const FHitResult& HitResult : Context.ScratchHits)
+            {
+                AddCompactHit(HitResult);
+            }
+            Record.bHit = Context.ScratchHits.IsEmpty() == false;
+            break;
+        case SingleResult:
+            {
+                FHitResult HitResult;
+                Record.bHit = World->SweepSingleByChannel(HitResult, Start, End, Rotation, TraceChannel, CollisionShape, QueryParams, ResponseParams);
+                if(Record.bHit)
+                {
+                    AddCompactHit(HitResult);
+                }
+                break;
+            }
+        case TestResult:
+            Record.bHit = World->SweepTestByChannel(Start, End, Rotation, TraceChannel, CollisionShape, QueryParams, ResponseParams);
+            break;
+        default:
+            break;
+        }
+
+        Record.Num = Context.Hits.Num() - Record.Offset;
+
+        if(bRecordHeatmap)
+        {
+            FOmniTraceHeatmap::RecordPoint(QueryParams.TraceTag, Start, EOmniTraceHeatmapChannel::Start);
+            FOmniTraceHeatmap::RecordPoint(QueryParams.TraceTag, End, EOmniTraceHeatmapChannel::End);
+            for(int32 HitIndex = Record.Offset; HitIndex < Context.Hits.Num(); ++HitIndex)
+            {
+                FOmniTraceHeatmap::RecordPoint(QueryParams.TraceTag, Context.Hits[HitIndex].ImpactPoint, EOmniTraceHeatmapChannel::Hit);
+            }
+        }
+    });
+
+    //Merge the worker contexts into the results
+    Results.Ranges.SetNumZeroed(Requests.Num(), EAllowShrinking::No);
+    Results.TestResults.SetNumUninitialized(Requests.Num());
+    Results.TestResults.SetRange(0, Requests.Num(), false);
+
+    int32 NumHits = 0;
+    for(const OmniTrace::FCompactTraceWorkerContext& Context : Scratch.WorkerContexts)
+    {
+        NumHits += Context.Hits.Num();
+    }
+    Scratch.ComponentTable.Reset(NumHits);
+    Results.Hits.Reserve(NumHits);
+
+    for(const OmniTrace::FCompactTraceWorkerContext& Context : Scratch.WorkerContexts)
+    {
+        for(const OmniTrace::FCompactTraceWorkerContext::FRequestRecord& Record : Context.Records)
+        {
+            Results.TestResults[Record.RequestIndex] = Record.bHit;
+
+            FOmniTraceResultRange& Range = Results.Ranges[Record.RequestIndex];
+            Range.Offset = Results.Hits.Num();
+            Range.Num = Record.Num;
+
+            for(int32 HitIndex = Record.Offset; HitIndex < Record.Offset + Record.Num; ++HitIndex)
+            {
+                FOmniCompactHit& CompactHit = Results.Hits.Add_GetRef(Context.Hits[HitIndex]);
+                if(const UPrimitiveComponent* Component = Context.HitComponents[HitIndex])
+                {
+                    int32& ComponentIndex = Scratch.ComponentTable.FindOrAdd(Component);
+                    if(ComponentIndex == INDEX_NONE)
+                    {
+                        ComponentIndex = Results.Components.Add(const_cast<UPrimitiveComponent*>(Component));
+                    }
+                    CompactHit.ComponentIndex = ComponentIndex;
+                }
+            }
+        }
+    }
+}
+
+bool UOmniTraceLibrary::WasCompactTraceHit(const FOmniCompactTraceResults& Results, int32 RequestIndex)
+{
+    return Results.WasHit(RequestIndex);
+}
+
+TArray<FOmniCompactHit> UOmniTraceLibrary::GetCompactTraceHits(const FOmniCompactTraceResults& Results, int32 RequestIndex)
+{
+    return TArray<FOmniCompactHit>(Results.GetHitsForRequest(RequestIndex));
+}
+
+void UOmniTraceLibrary::MassTrace(UObject* WorldContextObject, const TArray<FOmniMassTraceRequest>& Requests,
+    const TArray<AActor*>& IgnoredActors, FOmniMassTraceResults& OutResults, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::MassTrace);
+
+    OutResults.Reset();
+    if(Requests.IsEmpty())
+    {
+        return;
+    }
+
+    //Find every unique GUID and how many requests use it
+    TArray<int32> GroupIndices;
+    TArray<int32> GroupSizes;
+    GroupIndices.SetNumUninitialized(Requests.Num());
+    for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+    {
+        const FGuid& TraceGUID = Requests[RequestIndex].TraceGUID;
+        int32& GroupIndex = OutResults.GuidIndices.FindOrAdd(TraceGUID, INDEX_NONE);
+        if(GroupIndex == INDEX_NONE)
+        {
+            GroupIndex = OutResults.TraceGUIDs.Add(TraceGUID);
+            GroupSizes.Add(0);
+        }
+
+        GroupIndices[RequestIndex] = GroupIndex;
+        GroupSizes[GroupIndex]++;
+    }
+
+    /**Sort the requests by group, keeping their original order within the group.
+     * The batch trace compacts its results in request order, so every
+     * group ends up in one contiguous range of the hit results.*/
+    TArray<int32> GroupStarts;
+    GroupStarts.SetNumUninitialized(GroupSizes.Num());
+    int32 RunningStart = 0;
+    for(int32 GroupIndex = 0; GroupIndex < GroupSizes.Num(); ++GroupIndex)
+    {
+        GroupStarts[GroupIndex] = RunningStart;
+        RunningStart += GroupSizes[GroupIndex];
+    }
+
+    TArray<FOmniTraceRequest> SortedRequests;
+    SortedRequests.SetNum(Requests.Num());
+    TArray<int32> WriteIndices = GroupStarts;
+    for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+    {
+        SortedRequests[WriteIndices[GroupIndices[RequestIndex]]++] = Requests[RequestIndex].Trace;
+    }
+
+    FOmniBatchTraceResult BatchResults;
+    BatchTrace(WorldContextObject, SortedRequests, IgnoredActors, BatchResults, DebugOptions);
+    if(BatchResults.Ranges.Num() != SortedRequests.Num())
+    {
+        //Most likely no valid world, nothing was traced
+        OutResults.Ranges.SetNumZeroed(OutResults.TraceGUIDs.Num());
+        return;
+    }
+
+    OutResults.HitResults = MoveTemp(BatchResults.HitResults);
+    OutResults.Ranges.SetNumUninitialized(GroupSizes.Num());
+    for(int32 GroupIndex = 0; GroupIndex < GroupSizes.Num(); ++GroupIndex)
+    {
+        FOmniTraceResultRange& Range = OutResults.Ranges[GroupIndex];
+        Range.Offset = BatchResults.Ranges[GroupStarts[GroupIndex]].Offset;
+        Range.Num = 0;
+        for(int32 SortedIndex = GroupStarts[GroupIndex]; SortedIndex < GroupStarts[GroupIndex] + GroupSizes[GroupIndex]; ++SortedIndex)
+        {
+            Range.Num += BatchResults.Ranges[SortedIndex].Num;
+        }
+    }
+}
+
+void UOmniTraceLibrary::AsyncMassTrace(UObject* WorldContextObject, const TArray<FOmniMassTraceRequest>& Requests,
+    const TArray<AActor*>& IgnoredActors, FMassTraceCompletedDelegate OnTraceCompleted, FMassTraceResultDelegate OnGroupCompleted,
+    FTraceDebug DebugOptions)
+{
+    UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    UOmniAsyncTraceSubsystem* AsyncTraceSubsystem = World ? World->GetSubsystem<UOmniAsyncTraceSubsystem>() : nullptr;
+    if(!AsyncTraceSubsystem)
+    {
+        //Nothing will ever trace these, let the caller know right away
+        TArray<FGuid, TInlineAllocator<16>> TraceGUIDs;
+        for(const FOmniMassTraceRequest& Request : Requests)
+        {
+            TraceGUIDs.AddUnique(Request.TraceGUID);
+        }
+
+        FMassTraceResult EmptyResult;
+        for(const FGuid& TraceGUID : TraceGUIDs)
+        {
+            EmptyResult.TraceGUID = TraceGUID;
+            OnGroupCompleted.ExecuteIfBound(EmptyResult);
+        }
+
+        OnTraceCompleted.ExecuteIfBound(FOmniMassTraceResults());
+        return;
+    }
+
+    AsyncTraceSubsystem->QueueMassTrace(Requests, IgnoredActors, OnTraceCompleted, OnGroupCompleted, DebugOptions);
+}
+
+FMassTraceResult UOmniTraceLibrary::GetMassTraceResult(const FOmniMassTraceResults& MassResults, FGuid TraceGUID)
+{
+    FMassTraceResult Result;
+    Result.TraceGUID = TraceGUID;
+    Result.HitResults = TArray<FHitResult>(MassResults.GetHitResultsForGUID(TraceGUID));
+    return Result;
+}
+
+TArray<FHitResult> UOmniTraceLibrary::GetBatchTraceHitResults(const FOmniBatchTraceResult& BatchResult, int32 RequestIndex)
+{
+    return TArray<FHitResult>(BatchResult.GetHitResultsForRequest(RequestIndex));
+}
+
+FOmniNetHitArray UOmniTraceLibrary::MakeNetHits(const TArray<FHitResult>& HitResults)
+{
+    FOmniNetHitArray NetHits;
+    ToNetHits(HitResults, NetHits.Hits);
+    return NetHits;
+}
+
+TArray<FHitResult> UOmniTraceLibrary::BreakNetHits(const FOmniNetHitArray& NetHits)
+{
+    TArray<FHitResult> HitResults;
+    FromNetHits(NetHits.Hits, HitResults);
+    return HitResults;
+}
+
+void UOmniTraceLibrary::ToNetHits(TConstArrayView<FHitResult> HitResults, TArray<FOmniNetHit>& OutNetHits)
+{
+    OutNetHits.Reset(HitResults.Num());
+    for(const FHitResult& HitResult : HitResults)
+    {
+        OutNetHits.Emplace(HitResult);
+    }
+}
+
+void UOmniTraceLibrary::FromNetHits(TConstArrayView<FOmniNetHit> NetHits, TArray<FHitResult>& OutHitResults)
+{
+    OutHitResults.Reset(NetHits.Num());
+    for(const FOmniNetHit& NetHit : NetHits)
+    {
+        OutHitResults.Add(NetHit.ToHitResult());
+    }
+}
+
+void UOmniTraceLibrary::FanTrace(UObject* WorldContextObject, const FVector& Origin, FRotator Rotation,
+    const FOmniFanTraceSettings& Settings, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    const TArray<AActor*>& IgnoredActors, FOmniFanTraceResult& Result, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    FanTraceByQuery(WorldContextObject, Origin, Rotation, Settings, Query, Result, DebugOptions);
+}
+
+void UOmniTraceLibrary::FanTraceByQuery(UObject* WorldContextObject, const FVector& Origin, FRotator Rotation,
+    const FOmniFanTraceSettings& Settings, const FOmniTraceQuery& Query, FOmniFanTraceResult& Result, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::FanTraceByQuery);
+
+    GenerateFanTraceDirections(FQuat(Rotation), Settings, Result.Directions);
+
+    const int32 NumRays = Result.Directions.Num();
+    const float Range = FMath::Max(Settings.Range, 0.f);
+
+    Result.Requests.SetNum(NumRays, EAllowShrinking::No);
+    for(int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+    {
+        FOmniTraceRequest& Request = Result.Requests[RayIndex];
+        Request.Shape = EOmniTraceShape::Line;
+        Request.Start = Origin;
+        Request.End = Origin + Result.Directions[RayIndex] * Range;
+        Request.ResultType = SingleResult;
+    }
+
+    //Rays are drawn up to their hit instead of as full traces, so the debug is handled below
+    FTraceDebug BatchDebugOptions;
+    BatchDebugOptions.TraceTag = DebugOptions.TraceTag;
+    BatchTraceByQuery(WorldContextObject, Result.Requests, Query, Result.BatchResults, BatchDebugOptions);
+
+    Result.Distances.SetNumUninitialized(NumRays, EAllowShrinking::No);
+    Result.NumBlockingHits = 0;
+    Result.NearestRayIndex = INDEX_NONE;
+    Result.NearestHit = FHitResult();
+
+    for(int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+    {
+        Result.Distances[RayIndex] = Range;
+        for(const FHitResult& HitResult : Result.BatchResults.GetHitResultsForRequest(RayIndex))
+        {
+            if(!HitResult.bBlockingHit)
+            {
+                continue;
+            }
+
+            Result.Distances[RayIndex] = HitResult.Distance;
+            Result.NumBlockingHits++;
+            if(Result.NearestRayIndex == INDEX_NONE || HitResult.Distance < Result.NearestHit.Distance)
+            {
+                Result.NearestRayIndex = RayIndex;
+                Result.NearestHit = HitResult;
+            }
+            break;
+        }
+    }
+
+    Result.VisibleFraction = NumRays > 0 ? 1.f - static_cast<float>(Result.NumBlockingHits) / NumRays : 1.f;
+
+    if(const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr)
+    {
+        HandleFanTraceDebug(World, Origin, Result, DebugOptions);
+    }
+}
+
+TArray<FVector> UOmniTraceLibrary::GetFanTraceDirections(FRotator Rotation, const FOmniFanTraceSettings& Settings)
+{
+    TArray<FVector> Directions;
+    GenerateFanTraceDirections(FQuat(Rotation), Settings, Directions);
+    return Directions;
+}
+
+void UOmniTraceLibrary::GenerateFanTraceDirections(const FQuat& Rotation, const FOmniFanTraceSettings& Settings,
+    TArray<FVector>& OutDirections)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::GenerateFanTraceDirections);
+
+    const int32 NumRays = FMath::Max(Settings.NumRays, 1);
+    const int32 NumPadded = Align(NumRays, 4);
+    OutDirections.SetNumUninitialized(NumRays, EAllowShrinking::No);
+
+    /**Every ray is described by the cosine of its angle away from the
+     * forward vector and its angle around it. Those are generated first,
+     * then turned into directions 4 rays at a time.
+     * The padding rays simply point forward and are never stored.*/
+    TArray<float, TInlineAllocator<256>> CosTheta;
+    TArray<float, TInlineAllocator<256>> Phi;
+    CosTheta.Init(1.f, NumPadded);
+    Phi.Init(0.f, NumPadded);
+
+    FRandomStream RandomStream(Settings.Seed);
+    const float MaxAngle = FMath::DegreesToRadians(Settings.Pattern == EOmniFanTracePattern::Hemisphere ? 90.f : FMath::Clamp(Settings.Angle, 0.f, 180.f));
+    static constexpr float GoldenRatioConjugate = 0.618034f;
+    static constexpr float GoldenAngle = UE_PI * 0.763932f; //PI * (3 - sqrt(5))
+
+    if(Settings.Pattern == EOmniFanTracePattern::Fan)
+    {
+        for(int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+        {
+            float Alpha;
+            switch(Settings.Distribution)
+            {
+            case EOmniFanTraceDistribution::GoldenSpiral:
+                Alpha = FMath::Frac(0.5f + RayIndex * GoldenRatioConjugate);
+                break;
+            case EOmniFanTraceDistribution::Jittered:
+                Alpha = (RayIndex + RandomStream.GetFraction()) / NumRays;
+                break;
+            default:
+                Alpha = NumRays > 1 ? static_cast<float>(RayIndex) / (NumRays - 1) : 0.5f;
+                break;
+            }
+
+            //A negative yaw is the same angle away from forward, just on the other side
+            const float Yaw = FMath::Lerp(-MaxAngle, MaxAngle, Alpha);
+            CosTheta[RayIndex] = FMath::Cos(Yaw);
+            Phi[RayIndex] = Yaw < 0 ? UE_PI : 0.f;
+        }
+    }
+    else if(Settings.Distribution == EOmniFanTraceDistribution::Uniform)
+    {
+        /**One ray straight forward, the rest is spread over rings of
+         * increasing angle. Wider rings receive more rays.*/
+        const int32 NumRings = FMath::Max(1, FMath::RoundToInt(FMath::Sqrt((NumRays - 1) / UE_PI)));
+        float TotalWeight = 0;
+        for(int32 Ring = 0; Ring < NumRings; ++Ring)
+        {
+            TotalWeight += FMath::Sin(MaxAngle * (Ring + 1) / NumRings);
+        }
+
+        int32 RayIndex = 1;
+        for(int32 Ring = 0; Ring < NumRings; ++Ring)
+        {
+            const float RingAngle = MaxAngle * (Ring + 1) / NumRings;
+            const int32 RingRays = Ring == NumRings - 1 || TotalWeight <= UE_SMALL_NUMBER
+                ? NumRays - RayIndex
+                : FMath::Min(FMath::FloorToInt((NumRays - 1) * FMath::Sin(RingAngle) / TotalWeight), NumRays - RayIndex);
+
+            //Offset every other ring so the rays don't line up
+            const float PhiOffset = Ring % 2 == 0 ? 0.f : 0.5f;
+            for(int32 RingRay = 0; RingRay < RingRays; ++RingRay)
+            {
+                CosTheta[RayIndex] = FMath::Cos(RingAngle);
+                Phi[RayIndex] = UE_TWO_PI * (RingRay + PhiOffset) / RingRays;
+                RayIndex++;
+            }
+
+            if(RayIndex >= NumRays)
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        //Sampling the cosine uniformly gives every ray the same amount of area on the cap
+        const float CosMaxAngle = FMath::Cos(MaxAngle);
+        const bool bJittered = Settings.Distribution == EOmniFanTraceDistribution::Jittered;
+        for(int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+        {
+            const float Alpha = (RayIndex + (bJittered ? RandomStream.GetFraction() : 0.5f)) / NumRays;
+            CosTheta[RayIndex] = 1.f - Alpha * (1.f - CosMaxAngle);
+            Phi[RayIndex] = bJittered ? RandomStream.GetFraction() * UE_TWO_PI : RayIndex * GoldenAngle;
+        }
+    }
+
+    const VectorRegister4Double RotationRegister = VectorLoad(&Rotation.X);
+    alignas(16) float LocalY[4];
+    alignas(16) float LocalZ[4];
+
+    for(int32 GroupStart = 0; GroupStart < NumPadded; GroupStart += 4)
+    {
+        const VectorRegister4Float CosThetaRegister = VectorLoad(&CosTheta[GroupStart]);
+        const VectorRegister4Float SinThetaRegister = VectorSqrt(VectorMax(VectorZeroFloat(),
+            VectorSubtract(VectorOneFloat(), VectorMultiply(CosThetaRegister, CosThetaRegister))));
+
+        VectorRegister4Float SinPhi;
+        VectorRegister4Float CosPhi;
+        const VectorRegister4Float PhiRegister = VectorLoad(&Phi[GroupStart]);
+        VectorSinCos(&SinPhi, &CosPhi, &PhiRegister);
+
+        VectorStoreAligned(VectorMultiply(SinThetaRegister, CosPhi), LocalY);
+        VectorStoreAligned(VectorMultiply(SinThetaRegister, SinPhi), LocalZ);
+
+        const int32 GroupEnd = FMath::Min(GroupStart + 4, NumRays);
+        for(int32 RayIndex = GroupStart; RayIndex < GroupEnd; ++RayIndex)
+        {
+            const int32 Lane = RayIndex - GroupStart;
+            const VectorRegister4Double LocalDirection = MakeVectorRegisterDouble(
+                static_cast<double>(CosTheta[RayIndex]), static_cast<double>(LocalY[Lane]), static_cast<double>(LocalZ[Lane]), 0.0);
+            VectorStoreFloat3(VectorQuaternionRotateVector(RotationRegister, LocalDirection), &OutDirections[RayIndex].X);
+        }
+    }
+}
+
+FOmniPolylineTraceResult UOmniTraceLibrary::PolylineTrace(UObject* WorldContextObject, const TArray<FVector>& Points, float Radius,
+    FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    return PolylineTraceByQuery(WorldContextObject, Points, Radius, Query, DebugOptions);
+}
+
+FOmniPolylineTraceResult UOmniTraceLibrary::PolylineTraceByQuery(UObject* WorldContextObject, const TArray<FVector>& Points,
+    float Radius, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::PolylineTraceByQuery);
+
+    FOmniPolylineTraceResult Result;
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Points.Num() < 2)
+    {
+        return Result;
+    }
+
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    const EOmniTraceShape Shape = Radius > 0 ? EOmniTraceShape::Sphere : EOmniTraceShape::Line;
+    const bool bRecordStats = FOmniTraceStats::IsEnabled();
+    const uint64 StartCycles = bRecordStats ? FPlatformTime::Cycles64() : 0;
 
-    FTraceDelegate* TraceDelegate = new FTraceDelegate();
-    TraceDelegate->BindLambda([OnTraceCompleted, DebugOptions](const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
     {
-        HandleLineTraceDebug(TraceData.PhysWorld.Get(), DebugOptions, TraceData.OutHits);
+        SCOPE_CYCLE_COUNTER(STAT_OmniTracePhysics);
 
-        OnTraceCompleted.Execute(TraceData.OutHits);
-    });
+        OmniTrace::RunPolylineTrace(World, Points, Radius > 0 ? FCollisionShape::MakeSphere(Radius) : FCollisionShape::LineShape,
+            CompiledQuery.GetChannel(), CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams(), Result);
+    }
 
-    EAsyncTraceType TraceType;
-    if(ResultType == TestResult)
+    if(bRecordStats)
     {
-        TraceType = EAsyncTraceType::Test;
+        const FName TraceTag = DebugOptions.TraceTag.IsNone() ? CompiledQuery.GetQueryParams().TraceTag : DebugOptions.TraceTag;
+        FOmniTraceStats::RecordTrace(TraceTag, Shape, SingleResult, Result.bBlockingHit ? 1 : 0, FPlatformTime::Cycles64() - StartCycles);
     }
-    else if(ResultType == MultiResult)
+
+    if(FOmniTraceHeatmap::IsEnabled())
     {
-        TraceType = EAsyncTraceType::Multi;
+        const FName TraceTag = DebugOptions.TraceTag.IsNone() ? CompiledQuery.GetQueryParams().TraceTag : DebugOptions.TraceTag;
+        FOmniTraceHeatmap::RecordTrace(TraceTag, Points[0], Points.Last(), MakeArrayView(&Result.HitResult, Result.bBlockingHit ? 1 : 0));
     }
-    else
+
+    HandlePolylineTraceDebug(World, Points, Result, DebugOptions, DebugOptions.TraceTag);
+    return Result;
+}
+
+FOmniPolylineTraceResult UOmniTraceLibrary::SplineTraceByQuery(UObject* WorldContextObject, const USplineComponent* Spline,
+    float SampleDistance, float Radius, const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    TArray<FVector> Points;
+    GetSplineTracePoints(Spline, SampleDistance, Points);
+    return PolylineTraceByQuery(WorldContextObject, Points, Radius, Query, DebugOptions);
+}
+
+void UOmniTraceLibrary::GetSplineTracePoints(const USplineComponent* Spline, float SampleDistance, TArray<FVector>& OutPoints)
+{
+    OutPoints.Reset();
+    if(!Spline)
     {
-        TraceType = EAsyncTraceType::Single;
+        return;
     }
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
+
+    const float SplineLength = Spline->GetSplineLength();
+    const int32 NumSegments = FMath::Max(FMath::CeilToInt32(SplineLength / FMath::Max(SampleDistance, 1.f)), 1);
+
+    OutPoints.Reserve(NumSegments + 1);
+    for(int32 PointIndex = 0; PointIndex <= NumSegments; ++PointIndex)
     {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+        const float Distance = SplineLength * PointIndex / NumSegments;
+        OutPoints.Add(Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World));
     }
-    
-    WorldContextObject->GetWorld()->AsyncLineTraceByChannel(TraceType, Start, End, TraceChannel, QueryParams, ResponseParam, TraceDelegate);
 }
 
-    TArray<FHitResult> UOmniTraceLibrary::SphereTrace(UObject* WorldContextObject, const FVector& Start,
-    const FVector& End, const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType,
-    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex,
-    FTraceDebug DebugOptions)
+void UOmniTraceLibrary::BatchPolylineTraceByQuery(UObject* WorldContextObject, const TArray<FOmniPolylineTraceRequest>& Paths,
+    const FOmniTraceQuery& Query, TArray<FOmniPolylineTraceResult>& OutResults, FTraceDebug DebugOptions)
 {
-    TRACE_CPUPROFILER_EVENT_SCOPE(UTraceHelpersLibrary::SphereTrace);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BatchPolylineTraceByQuery);
 
-    TArray<FHitResult> HitResult;
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
+    OutResults.Reset(Paths.Num());
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Paths.IsEmpty())
     {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+        return;
     }
 
-    bool bHit;
-    FHitResult SingleHitResult;
-    switch(ResultType)
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    const bool bRecordStats = FOmniTraceStats::IsEnabled();
+    const uint64 StartCycles = bRecordStats ? FPlatformTime::Cycles64() : 0;
+
+    OutResults.SetNum(Paths.Num());
+
+    //Paths are sequential on their own, so each path is one task
+    const bool bRecordHeatmap = FOmniTraceHeatmap::IsEnabled();
+    ParallelFor(TEXT("UOmniTraceLibrary::BatchPolylineTrace"), Paths.Num(), 1, [&](int32 PathIndex)
     {
-    case MultiResult:
-        WorldContextObject->GetWorld()->SweepMultiByChannel(HitResult, Start, End, FQuat::Identity, TraceChannel, FCollisionShape::MakeSphere(Radius), QueryParams, ResponseParam);
-        break;
-    case SingleResult:
-        bHit = WorldContextObject->GetWorld()->SweepSingleByChannel(SingleHitResult, Start, End, FQuat::Identity, TraceChannel, FCollisionShape::MakeSphere(Radius), QueryParams, ResponseParam);
-        if(bHit)
+        const FOmniPolylineTraceRequest& Path = Paths[PathIndex];
+        FOmniPolylineTraceResult& Result = OutResults[PathIndex];
+        OmniTrace::RunPolylineTrace(World, Path.Points, Path.Radius > 0 ? FCollisionShape::MakeSphere(Path.Radius) : FCollisionShape::LineShape,
+            CompiledQuery.GetChannel(), CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams(), Result);
+
+        if(bRecordHeatmap && Path.Points.Num() >= 2)
         {
-            HitResult.Add(SingleHitResult);
+            FOmniTraceHeatmap::RecordTrace(CompiledQuery.GetQueryParams().TraceTag, Path.Points[0], Path.Points.Last(),
+                MakeArrayView(&Result.HitResult, Result.bBlockingHit ? 1 : 0));
         }
-        break;
-    case TestResult:
-        bHit = WorldContextObject->GetWorld()->SweepTestByChannel(Start, End, FQuat::Identity, TraceChannel, FCollisionShape::MakeSphere(Radius), QueryParams, ResponseParam);
-        if(bHit)
+    });
+
+    if(bRecordStats)
+    {
+        //Same as RecordBatch, the cycles are spread evenly over the paths
+        const FName TraceTag = DebugOptions.TraceTag.IsNone() ? CompiledQuery.GetQueryParams().TraceTag : DebugOptions.TraceTag;
+        const uint64 CyclesPerPath = (FPlatformTime::Cycles64() - StartCycles) / Paths.Num();
+        for(int32 PathIndex = 0; PathIndex < Paths.Num(); ++PathIndex)
         {
-            HitResult.Add(SingleHitResult);
+            FOmniTraceStats::RecordTrace(TraceTag, Paths[PathIndex].Radius > 0 ? EOmniTraceShape::Sphere : EOmniTraceShape::Line,
+                SingleResult, OutResults[PathIndex].bBlockingHit ? 1 : 0, CyclesPerPath);
         }
-        break;
-    default: break;
     }
-    
-    HandleSphereTraceDebug(WorldContextObject, Radius, DebugOptions, HitResult);
 
-    return HitResult;
+    if(DebugOptions.bEnableDebug)
+    {
+        for(int32 PathIndex = 0; PathIndex < Paths.Num(); ++PathIndex)
+        {
+            HandlePolylineTraceDebug(World, Paths[PathIndex].Points, OutResults[PathIndex], DebugOptions, FName(DebugOptions.TraceTag, PathIndex + 1));
+        }
+    }
 }
 
-void UOmniTraceLibrary::AsyncSphereTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
-    const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType, const TArray<AActor*>& IgnoredActors,
-    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, 
-    FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+void UOmniTraceLibrary::PolylineTraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, TConstArrayView<FVector> Points,
+    float Radius, const FOmniTraceQuery& Query, FOmniPolylineTraceResult& OutResult)
 {
-    if(!WorldContextObject)
-    {
-        return;
-    }
-    
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
-    {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
-    }
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::PolylineTraceByQueryThreadSafe);
+
+    checkf(Query.IsCompiled(), TEXT("PolylineTraceByQueryThreadSafe requires a query that has been compiled on the game thread"));
+    checkf(World.GetWorldUnsafe(), TEXT("PolylineTraceByQueryThreadSafe was given a handle without a world, create it on the game thread first"));
 
-    FTraceDelegate* TraceDelegate = new FTraceDelegate();
-    TraceDelegate->BindLambda([OnTraceCompleted, DebugOptions, Radius](const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
+    const bool bRecordStats = FOmniTraceStats::IsEnabled();
+    const uint64 StartCycles = bRecordStats ? FPlatformTime::Cycles64() : 0;
+
+    OutResult = FOmniPolylineTraceResult();
+    World.ExecuteRead([&](const UWorld& TraceWorld)
     {
-        HandleSphereTraceDebug(TraceData.PhysWorld.Get(), Radius, DebugOptions, TraceData.OutHits);
+        SCOPE_CYCLE_COUNTER(STAT_OmniTracePhysics);
 
-        OnTraceCompleted.Execute(TraceData.OutHits);
+        OmniTrace::RunPolylineTrace(&TraceWorld, Points, Radius > 0 ? FCollisionShape::MakeSphere(Radius) : FCollisionShape::LineShape,
+            Query.GetChannel(), Query.GetQueryParams(), Query.GetResponseParams(), OutResult);
     });
 
-    EAsyncTraceType TraceType;
-    if(ResultType == TestResult)
+    if(bRecordStats)
     {
-        TraceType = EAsyncTraceType::Test;
+        FOmniTraceStats::RecordTrace(Query.GetQueryParams().TraceTag, Radius > 0 ? EOmniTraceShape::Sphere : EOmniTraceShape::Line,
+            SingleResult, OutResult.bBlockingHit ? 1 : 0, FPlatformTime::Cycles64() - StartCycles);
     }
-    else if(ResultType == MultiResult)
+
+    if(FOmniTraceHeatmap::IsEnabled() && Points.Num() >= 2)
     {
-        TraceType = EAsyncTraceType::Multi;
+        FOmniTraceHeatmap::RecordTrace(Query.GetQueryParams().TraceTag, Points[0], Points.Last(),
+            MakeArrayView(&OutResult.HitResult, OutResult.bBlockingHit ? 1 : 0));
     }
-    else
+}
+
+void UOmniTraceLibrary::AsyncBatchPolylineTraceByQuery(UObject* WorldContextObject, const TArray<FOmniPolylineTraceRequest>& Paths,
+    const FOmniTraceQuery& Query, FPolylineTraceCompletedDelegate OnTraceCompleted, FTraceDebug DebugOptions)
+{
+    UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    UOmniAsyncTraceSubsystem* AsyncTraceSubsystem = World ? World->GetSubsystem<UOmniAsyncTraceSubsystem>() : nullptr;
+    if(!AsyncTraceSubsystem)
     {
-        TraceType = EAsyncTraceType::Single;
+        //Nothing will ever trace these, let the caller know right away
+        OnTraceCompleted.ExecuteIfBound(TArray<FOmniPolylineTraceResult>());
+        return;
     }
-    
-    WorldContextObject->GetWorld()->AsyncSweepByChannel(TraceType, Start, End, FQuat::Identity, TraceChannel, FCollisionShape::MakeSphere(Radius), QueryParams, ResponseParam, TraceDelegate);
+
+    //The worker threads can't compile the query themselves
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+    AsyncTraceSubsystem->QueuePolylineTrace(Paths, CompiledQuery, OnTraceCompleted, DebugOptions);
 }
 
-TArray<FHitResult> UOmniTraceLibrary::CapsuleTrace(UObject* WorldContextObject, const FVector& Start,
-                                                      const FVector& End, FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
-                                                      UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, 
-                                                      const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceDebug DebugOptions)
+TArray<FOmniOverlapResult> UOmniTraceLibrary::SphereOverlap(UObject* WorldContextObject, const FVector& Location,
+    const float Radius, FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors,
+    bool TraceComplex, FTraceDebug DebugOptions)
 {
-    TRACE_CPUPROFILER_EVENT_SCOPE(UTraceHelpersLibrary::CapsuleTrace);
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    TArray<FOmniOverlapResult> Overlaps;
+    OverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Sphere, Location, FQuat::Identity,
+        FCollisionShape::MakeSphere(Radius), Query, Overlaps, DebugOptions);
+    return Overlaps;
+}
 
-    FQuat QuatRotation = FQuat(Rotation);
+TArray<FOmniOverlapResult> UOmniTraceLibrary::BoxOverlap(UObject* WorldContextObject, const FVector& Location,
+    FRotator Rotation, const FVector& Extent, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    TArray<FOmniOverlapResult> Overlaps;
+    OverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Box, Location, FQuat(Rotation),
+        FCollisionShape::MakeBox(Extent), Query, Overlaps, DebugOptions);
+    return Overlaps;
+}
 
-    TArray<FHitResult> HitResult;
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    DebugOptions.Rotation = QuatRotation;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
-    {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
-    }
+TArray<FOmniOverlapResult> UOmniTraceLibrary::CapsuleOverlap(UObject* WorldContextObject, const FVector& Location,
+    FRotator Rotation, const float Radius, const float HalfHeight, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    const TArray<AActor*>& IgnoredActors, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    TArray<FOmniOverlapResult> Overlaps;
+    OverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Capsule, Location, FQuat(Rotation),
+        FCollisionShape::MakeCapsule(Radius, HalfHeight), Query, Overlaps, DebugOptions);
+    return Overlaps;
+}
 
-    bool bHit;
-    FHitResult SingleHitResult;
-    switch(ResultType)
-    {
-    case MultiResult:
-        WorldContextObject->GetWorld()->SweepMultiByChannel(HitResult, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeCapsule(Radius, HalfHeight), QueryParams, ResponseParam);
-        break;
-    case SingleResult:
-        bHit = WorldContextObject->GetWorld()->SweepSingleByChannel(SingleHitResult, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeCapsule(Radius, HalfHeight), QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    case TestResult:
-        bHit = WorldContextObject->GetWorld()->SweepTestByChannel(Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeCapsule(Radius, HalfHeight), QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    default: break;
-    }
+void UOmniTraceLibrary::AsyncSphereOverlap(UObject* WorldContextObject, const FVector& Location, const float Radius,
+    const TArray<AActor*>& IgnoredActors, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncOverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Sphere, Location, FQuat::Identity,
+        FCollisionShape::MakeSphere(Radius), Query, OnOverlapCompleted, DebugOptions);
+}
+
+void UOmniTraceLibrary::AsyncBoxOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation,
+    const FVector& Extent, const TArray<AActor*>& IgnoredActors, FName Profile, FOmniTraceChannelSettings TraceSettings,
+    FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncOverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Box, Location, FQuat(Rotation),
+        FCollisionShape::MakeBox(Extent), Query, OnOverlapCompleted, DebugOptions);
+}
 
-    // UKismetSystemLibrary::DrawDebugCapsuleTraceMulti(World, Start, End, Radius, HalfHeight, DrawDebugType, bHit, OutHits, TraceColor, TraceHitColor, DrawTime);
-    HandleCapsuleTraceDebug(WorldContextObject, Radius, HalfHeight, DebugOptions, HitResult);
+void UOmniTraceLibrary::AsyncCapsuleOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation,
+    const float Radius, const float HalfHeight, const TArray<AActor*>& IgnoredActors, FName Profile,
+    FOmniTraceChannelSettings TraceSettings, FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex,
+    FTraceDebug DebugOptions)
+{
+    const FOmniTraceQuery Query = OmniTrace::CompileLegacyQuery(Profile, TraceSettings, IgnoredActors, TraceComplex, DebugOptions.TraceTag);
+    AsyncOverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, EOmniTraceShape::Capsule, Location, FQuat(Rotation),
+        FCollisionShape::MakeCapsule(Radius, HalfHeight), Query, OnOverlapCompleted, DebugOptions);
+}
 
-    return HitResult;
+TArray<FOmniOverlapResult> UOmniTraceLibrary::OverlapByQuery(UObject* WorldContextObject, const FOmniOverlapRequest& Request,
+    const FOmniTraceQuery& Query, FTraceDebug DebugOptions)
+{
+    TArray<FOmniOverlapResult> Overlaps;
+    OverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, Request.Shape, Request.Location, FQuat(Request.Rotation),
+        Request.MakeCollisionShape(), Query, Overlaps, DebugOptions);
+    return Overlaps;
 }
 
-void UOmniTraceLibrary::AsyncCapsuleTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
-    FRotator Rotation, const float Radius, const float HalfHeight, TEnumAsByte<EAsyncTraceResultType> ResultType,
-    const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, 
-    FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+void UOmniTraceLibrary::AsyncOverlapByQuery(UObject* WorldContextObject, const FOmniOverlapRequest& Request,
+    const FOmniTraceQuery& Query, FAsyncOverlapResultDelegate OnOverlapCompleted, FTraceDebug DebugOptions)
+{
+    AsyncOverlapShapeByQuery(WorldContextObject ? WorldContextObject->GetWorld() : nullptr, Request.Shape, Request.Location, FQuat(Request.Rotation),
+        Request.MakeCollisionShape(), Query, OnOverlapCompleted, DebugOptions);
+}
+
+void UOmniTraceLibrary::BatchOverlap(UObject* WorldContextObject, const TArray<FOmniOverlapRequest>& Requests,
+    const FOmniTraceQuery& Query, FOmniBatchOverlapResult& OutResults, FTraceDebug DebugOptions)
 {
-    if(!WorldContextObject)
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::BatchOverlap);
+
+    OutResults.Overlaps.Reset();
+    OutResults.Ranges.Reset(Requests.Num());
+
+    const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+    if(!World || Requests.IsEmpty())
     {
         return;
     }
 
-    FQuat QuatRotation = FQuat(Rotation);
-    
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    DebugOptions.Rotation = QuatRotation;
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+    const ECollisionChannel TraceChannel = CompiledQuery.GetChannel();
+    const FCollisionQueryParams& QueryParams = CompiledQuery.GetQueryParams();
+    const FCollisionResponseParams& ResponseParams = CompiledQuery.GetResponseParams();
+
+    //Never shrink the scratch arrays, so their memory can be reused next time
+    if(OutResults.ScratchOverlaps.Num() < Requests.Num())
+    {
+        OutResults.ScratchOverlaps.SetNum(Requests.Num());
+    }
 
-    FTraceDelegate* TraceDelegate = new FTraceDelegate();
-    TraceDelegate->BindLambda([OnTraceCompleted, DebugOptions, Radius, HalfHeight](const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
+    ParallelFor(TEXT("UOmniTraceLibrary::BatchOverlap"), Requests.Num(), 8, [&](int32 RequestIndex)
     {
-        HandleCapsuleTraceDebug(TraceData.PhysWorld.Get(), Radius, HalfHeight, DebugOptions, TraceData.OutHits);
+        const FOmniOverlapRequest& Request = Requests[RequestIndex];
+        TArray<FOverlapResult>& ScratchOverlaps = OutResults.ScratchOverlaps[RequestIndex];
+        ScratchOverlaps.Reset();
 
-        OnTraceCompleted.Execute(TraceData.OutHits);
+        if(Request.Shape != EOmniTraceShape::Line)
+        {
+            World->OverlapMultiByChannel(ScratchOverlaps, Request.Location, FQuat(Request.Rotation), TraceChannel,
+                Request.MakeCollisionShape(), QueryParams, ResponseParams);
+        }
     });
 
-    EAsyncTraceType TraceType;
-    if(ResultType == TestResult)
+    //Compact every request into one array
+    int32 TotalOverlaps = 0;
+    for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
     {
-        TraceType = EAsyncTraceType::Test;
+        TotalOverlaps += OutResults.ScratchOverlaps[RequestIndex].Num();
     }
-    else if(ResultType == MultiResult)
-    {
-        TraceType = EAsyncTraceType::Multi;
-    }
-    else
+
+    OutResults.Overlaps.Reserve(TotalOverlaps);
+    for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
     {
-        TraceType = EAsyncTraceType::Single;
+        FOmniTraceResultRange& Range = OutResults.Ranges.AddDefaulted_GetRef();
+        Range.Offset = OutResults.Overlaps.Num();
+        Range.Num = OutResults.ScratchOverlaps[RequestIndex].Num();
+
+        for(const FOverlapResult& Overlap : OutResults.ScratchOverlaps[RequestIndex])
+        {
+            OutResults.Overlaps.Emplace(Overlap);
+        }
     }
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
+
+    if(DebugOptions.bEnableDebug)
     {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+        for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+        {
+            const FOmniOverlapRequest& Request = Requests[RequestIndex];
+            FTraceDebug RequestDebugOptions = DebugOptions;
+            RequestDebugOptions.Start = Request.Location;
+            RequestDebugOptions.Rotation = FQuat(Request.Rotation);
+            RequestDebugOptions.TraceTag = FName(DebugOptions.TraceTag, RequestIndex + 1);
+            HandleOverlapDebug(World, Request.Shape, Request.MakeCollisionShape(), RequestDebugOptions, OutResults.GetOverlapsForRequest(RequestIndex));
+        }
     }
-    
-    WorldContextObject->GetWorld()->AsyncSweepByChannel(TraceType, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeCapsule(Radius, HalfHeight), QueryParams, ResponseParam, TraceDelegate);
 }
 
-TArray<FHitResult> UOmniTraceLibrary::BoxTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const FVector& Extent,
-    TEnumAsByte<EAsyncTraceResultType> ResultType,
-    UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors,
-    bool TraceComplex, FTraceDebug DebugOptions)
+TArray<FOmniOverlapResult> UOmniTraceLibrary::GetBatchOverlapResults(const FOmniBatchOverlapResult& BatchResult,
+    int32 RequestIndex)
 {
-    TRACE_CPUPROFILER_EVENT_SCOPE(UTraceHelpersLibrary::BoxTrace);
+    return TArray<FOmniOverlapResult>(BatchResult.GetOverlapsForRequest(RequestIndex));
+}
 
-    FQuat QuatRotation = FQuat(Rotation);
+void UOmniTraceLibrary::OverlapShapeByQuery(const UWorld* World, EOmniTraceShape Shape, const FVector& Location,
+    const FQuat& Rotation, const FCollisionShape& CollisionShape, const FOmniTraceQuery& Query,
+    TArray<FOmniOverlapResult>& OutOverlaps, FTraceDebug DebugOptions)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceLibrary::OverlapShapeByQuery);
 
-    TArray<FHitResult> HitResult;
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    DebugOptions.Rotation = QuatRotation;
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
+    OutOverlaps.Reset();
+    if(!World || Shape == EOmniTraceShape::Line)
     {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
+        return;
     }
 
-    bool bHit;
-    FHitResult SingleHitResult;
-    switch(ResultType)
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
+
+    TArray<FOverlapResult> Overlaps;
+    World->OverlapMultiByChannel(Overlaps, Location, Rotation, CompiledQuery.GetChannel(), CollisionShape,
+        CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams());
+
+    OutOverlaps.Reserve(Overlaps.Num());
+    for(const FOverlapResult& Overlap : Overlaps)
     {
-    case MultiResult:
-        WorldContextObject->GetWorld()->SweepMultiByChannel(HitResult, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeBox(Extent), QueryParams, ResponseParam);
-        break;
-    case SingleResult:
-        bHit = WorldContextObject->GetWorld()->SweepSingleByChannel(SingleHitResult, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeBox(Extent), QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    case TestResult:
-        bHit = WorldContextObject->GetWorld()->SweepTestByChannel(Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeBox(Extent), QueryParams, ResponseParam);
-        if(bHit)
-        {
-            HitResult.Add(SingleHitResult);
-        }
-        break;
-    default:
-        break;
+        OutOverlaps.Emplace(Overlap);
     }
-    
-    HandleBoxTraceDebug(WorldContextObject, Extent, DebugOptions, HitResult);
 
-    return HitResult;
+    DebugOptions.Start = Location;
+    DebugOptions.Rotation = Rotation;
+    HandleOverlapDebug(World, Shape, CollisionShape, DebugOptions, OutOverlaps);
 }
 
-void UOmniTraceLibrary::AsyncBoxTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End,
-    FRotator Rotation, const FVector& Extent, TEnumAsByte<EAsyncTraceResultType> ResultType,
-    const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile,
-    FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex, FTraceDebug DebugOptions)
+void UOmniTraceLibrary::AsyncOverlapShapeByQuery(UWorld* World, EOmniTraceShape Shape, const FVector& Location,
+    const FQuat& Rotation, const FCollisionShape& CollisionShape, const FOmniTraceQuery& Query,
+    const FAsyncOverlapResultDelegate& OnOverlapCompleted, FTraceDebug DebugOptions)
 {
-    if(!WorldContextObject)
+    //Callers always hear back, even when there is nothing to overlap
+    ensureMsgf(Shape != EOmniTraceShape::Line, TEXT("AsyncOverlapShapeByQuery can't overlap a line"));
+    UOmniAsyncTraceSubsystem* AsyncTraceSubsystem = World && Shape != EOmniTraceShape::Line
+        ? World->GetSubsystem<UOmniAsyncTraceSubsystem>() : nullptr;
+    if(!AsyncTraceSubsystem)
     {
+        OnOverlapCompleted.ExecuteIfBound(TArray<FOmniOverlapResult>());
         return;
     }
 
-    FQuat QuatRotation = FQuat(Rotation);
-    
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActors(IgnoredActors);
-    QueryParams.TraceTag = DebugOptions.TraceTag;
-    QueryParams.bTraceComplex = TraceComplex;
-    DebugOptions.Start = Start;
-    DebugOptions.End = End;
-    DebugOptions.Rotation = QuatRotation;
-
-    FTraceDelegate* TraceDelegate = new FTraceDelegate();
-    TraceDelegate->BindLambda([OnTraceCompleted, DebugOptions, Extent](const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
-    {
-        HandleBoxTraceDebug(TraceData.PhysWorld.Get(), Extent, DebugOptions, TraceData.OutHits);
+    FOmniTraceQuery FallbackQuery;
+    const FOmniTraceQuery& CompiledQuery = OmniTrace::GetCompiledQuery(Query, FallbackQuery);
 
-        OnTraceCompleted.Execute(TraceData.OutHits);
-    });
+    DebugOptions.Start = Location;
+    DebugOptions.Rotation = Rotation;
 
-    EAsyncTraceType TraceType;
-    if(ResultType == TestResult)
-    {
-        TraceType = EAsyncTraceType::Test;
-    }
-    else if(ResultType == MultiResult)
-    {
-        TraceType = EAsyncTraceType::Multi;
-    }
-    else
-    {
-        TraceType = EAsyncTraceType::Single;
-    }
-    
-    ECollisionChannel TraceChannel;
-    FCollisionResponseParams ResponseParam;
-    UCollisionProfile::GetChannelAndResponseParams(Profile, TraceChannel, ResponseParam);
-    if(TraceSettings.UseTraceType)
-    {
-        TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceSettings.TraceType);
-    }
-    
-    WorldContextObject->GetWorld()->AsyncSweepByChannel(TraceType, Start, End, QuatRotation, TraceChannel, FCollisionShape::MakeBox(Extent), QueryParams, ResponseParam, TraceDelegate);
+    AsyncTraceSubsystem->QueueOverlap(Shape, Location, Rotation, CollisionShape, CompiledQuery.GetChannel(),
+        CompiledQuery.GetQueryParams(), CompiledQuery.GetResponseParams(), OnOverlapCompleted, DebugOptions);
 }
 
 bool UOmniTraceLibrary::DebugHitResults(const UObject* WorldContext, const FTraceDebug& DebugOptions,
-    TArray<FHitResult> HitResult)
+    const TArray<FHitResult>& HitResult)
 {
     bool BlockingHitFound = false;
     
@@ -509,14 +2166,14 @@ bool UOmniTraceLibrary::DebugHitResults(const UObject* WorldContext, const FTrac
         for(auto& CurrentHit : HitResult)
         {
             Index++;
-            if(CurrentHit.bBlockingHit)
+            if(CurrentHit.bBlockingHit || CurrentHit.Component.IsValid())
             {
-                BlockingHitFound = true;
-                UOmniEditorLibrary::DrawAndLogBox(WorldContext->GetWorld(), CurrentHit.ImpactPoint, FVector(5), FString::Printf(TEXT("%s_%i"), *DebugOptions.TraceTag.ToString(), Index), "", DebugOptions.HitColor);
-            }
-            else if(CurrentHit.Component.IsValid())
-            {
-                UOmniEditorLibrary::DrawAndLogBox(WorldContext->GetWorld(), CurrentHit.ImpactPoint, FVector(5), FString::Printf(TEXT("%s_%i"), *DebugOptions.TraceTag.ToString(), Index), "", DebugOptions.OverlapColor);
+                BlockingHitFound |= CurrentHit.bBlockingHit;
+                FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Box, CurrentHit.ImpactPoint,
+                    CurrentHit.bBlockingHit ? DebugOptions.HitColor : DebugOptions.OverlapColor);
+                Command.Extent = FVector(5);
+                //Same key as "Tag_Index", without formatting a string
+                OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), FName(DebugOptions.TraceTag, Index + 1));
             }
         }
     }
@@ -524,36 +2181,156 @@ bool UOmniTraceLibrary::DebugHitResults(const UObject* WorldContext, const FTrac
     return BlockingHitFound;
 }
 
-void UOmniTraceLibrary::HandleLineTraceDebug(const UObject* WorldContext, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult)
+void UOmniTraceLibrary::HandleLineTraceDebug(const UObject* WorldContext, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult)
 {
     if(!DebugOptions.bEnableDebug) { return; }
     
-    UOmniEditorLibrary::DrawAndLogLine(WorldContext->GetWorld(), DebugOptions.Start, DebugOptions.End, DebugOptions.TraceTag.ToString(), "",
-    DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Line, DebugOptions.Start,
+        DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    Command.End = DebugOptions.End;
+    OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
 }
 
 void UOmniTraceLibrary::HandleSphereTraceDebug(const UObject* WorldContext, const float Radius,
-    const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult)
+    const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult)
 {
     if(!DebugOptions.bEnableDebug) { return; }
     
-    UOmniEditorLibrary::DrawAndLogSphere(WorldContext->GetWorld(), DebugOptions.Start, Radius, DebugOptions.TraceTag.ToString(), "", 
+    FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Sphere, DebugOptions.Start,
         DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    Command.Radius = Radius;
+    OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
 }
 
 void UOmniTraceLibrary::HandleCapsuleTraceDebug(const UObject* WorldContext, const float Radius,
-    const float HalfHeight, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult)
+    const float HalfHeight, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult)
 {
     if(!DebugOptions.bEnableDebug) { return; }
     
-    UOmniEditorLibrary::DrawAndLogCapsule(WorldContext->GetWorld(), DebugOptions.Start, HalfHeight, Radius, DebugOptions.Rotation, DebugOptions.TraceTag.ToString(), "", 
+    FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Capsule, DebugOptions.Start,
         DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    Command.HalfHeight = HalfHeight;
+    Command.Radius = Radius;
+    Command.Rotation = DebugOptions.Rotation;
+    OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
 }
 
-void UOmniTraceLibrary::HandleBoxTraceDebug(const UObject* WorldContext, const FVector& Shape, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult)
+void UOmniTraceLibrary::HandleBoxTraceDebug(const UObject* WorldContext, const FVector& Shape, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult)
 {
     if(!DebugOptions.bEnableDebug) { return; }
     
-    UOmniEditorLibrary::DrawAndLogBox(WorldContext->GetWorld(), DebugOptions.Start, Shape, DebugOptions.TraceTag.ToString(), "", 
-    DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Box, DebugOptions.Start,
+        DebugHitResults(WorldContext, DebugOptions, HitResult) ? DebugOptions.HitColor : HitResult.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor);
+    Command.Extent = Shape;
+    OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
+}
+
+void UOmniTraceLibrary::HandleOverlapDebug(const UObject* WorldContext, EOmniTraceShape Shape,
+    const FCollisionShape& CollisionShape, const FTraceDebug& DebugOptions, TConstArrayView<FOmniOverlapResult> Overlaps)
+{
+    if(!DebugOptions.bEnableDebug) { return; }
+
+    const bool bBlockingHit = Algo::AnyOf(Overlaps, [](const FOmniOverlapResult& Overlap) { return Overlap.bBlockingHit; });
+    const FLinearColor Color = bBlockingHit ? DebugOptions.HitColor : Overlaps.IsEmpty() ? DebugOptions.MissColor : DebugOptions.OverlapColor;
+
+    switch(Shape)
+    {
+    case EOmniTraceShape::Sphere:
+        {
+            FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Sphere, DebugOptions.Start, Color);
+            Command.Radius = CollisionShape.GetSphereRadius();
+            OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
+            break;
+        }
+    case EOmniTraceShape::Capsule:
+        {
+            FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Capsule, DebugOptions.Start, Color);
+            Command.HalfHeight = CollisionShape.GetCapsuleHalfHeight();
+            Command.Radius = CollisionShape.GetCapsuleRadius();
+            Command.Rotation = DebugOptions.Rotation;
+            OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
+            break;
+        }
+    case EOmniTraceShape::Box:
+        {
+            FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::RotatedBox, DebugOptions.Start, Color);
+            Command.Extent = CollisionShape.GetBox();
+            Command.Rotation = DebugOptions.Rotation;
+            OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
+            break;
+        }
+    default:
+        break;
+    }
 }
+
+void UOmniTraceLibrary::HandleFanTraceDebug(const UObject* WorldContext, const FVector& Origin,
+    const FOmniFanTraceResult& Result, const FTraceDebug& DebugOptions)
+{
+    if(!DebugOptions.bEnableDebug) { return; }
+
+    for(int32 RayIndex = 0; RayIndex < Result.Directions.Num(); ++RayIndex)
+    {
+        const bool bHit = Algo::AnyOf(Result.BatchResults.GetHitResultsForRequest(RayIndex), [](const FHitResult& HitResult)
+        {
+            return HitResult.bBlockingHit;
+        });
+        FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Line, Origin, bHit ? DebugOptions.HitColor : DebugOptions.MissColor);
+        Command.End = Origin + Result.Directions[RayIndex] * Result.Distances[RayIndex];
+        OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), FName(DebugOptions.TraceTag, RayIndex + 1));
+    }
+
+    if(Result.NearestRayIndex != INDEX_NONE)
+    {
+        FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Box, Result.NearestHit.ImpactPoint, DebugOptions.HitColor);
+        Command.Extent = FVector(5);
+        Command.Text = FString::Printf(TEXT("Visible: %.0f%%"), Result.VisibleFraction * 100.f);
+        OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), DebugOptions.TraceTag);
+    }
+}
+
+void UOmniTraceLibrary::HandlePolylineTraceDebug(const UObject* WorldContext, TConstArrayView<FVector> Points,
+    const FOmniPolylineTraceResult& Result, const FTraceDebug& DebugOptions, FName Key)
+{
+    if(!DebugOptions.bEnableDebug || Points.IsEmpty()) { return; }
+
+    FOmniDebugDrawCommand Command = OmniTrace::MakeDebugCommand(WorldContext, EOmniDebugDrawType::Polyline, Points[0],
+        Result.bBlockingHit ? DebugOptions.HitColor : DebugOptions.MissColor);
+
+    //Only draw the part of the path that was actually traced
+    if(Result.bBlockingHit)
+    {
+        Command.Points.Append(Points.GetData(), Result.SegmentIndex + 1);
+        Command.Points.Add(Result.HitResult.Location);
+        Command.Text = FString::Printf(TEXT("Segment %d (%.2f)"), Result.SegmentIndex, Result.SegmentAlpha);
+    }
+    else
+    {
+        Command.Points.Append(Points.GetData(), Points.Num());
+    }
+    Command.End = Command.Points.Last();
+
+    OmniTrace::DrawDebugCommand(WorldContext, MoveTemp(Command), Key);
+}
+
+void UOmniTraceLibrary::HandleShapeTraceDebug(const UObject* WorldContext, EOmniTraceShape Shape,
+    const FCollisionShape& CollisionShape, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult)
+{
+    if(!DebugOptions.bEnableDebug) { return; }
+
+    switch(Shape)
+    {
+    case EOmniTraceShape::Line:
+        HandleLineTraceDebug(WorldContext, DebugOptions, HitResult);
+        break;
+    case EOmniTraceShape::Sphere:
+        HandleSphereTraceDebug(WorldContext, CollisionShape.GetSphereRadius(), DebugOptions, HitResult);
+        break;
+    case EOmniTraceShape::Capsule:
+        HandleCapsuleTraceDebug(WorldContext, CollisionShape.GetCapsuleRadius(), CollisionShape.GetCapsuleHalfHeight(), DebugOptions, HitResult);
+        break;
+    case EOmniTraceShape::Box:
+        HandleBoxTraceDebug(WorldContext, CollisionShape.GetBox(), DebugOptions, HitResult);
+        break;
+    }
+}
\ No newline at end of file
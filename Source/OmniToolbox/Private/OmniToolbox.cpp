@@ -4,6 +4,8 @@
 
 #define LOCTEXT_NAMESPACE "FOmniToolboxRuntimeModule"
 
+DEFINE_LOG_CATEGORY(LogOmniToolbox);
+
 void FOmniToolboxModule::StartupModule()
 {
     
@@ -0,0 +1,663 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniAsyncTraceSubsystem.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Developer/OmniTraceStats.h"
+#include "Developer/OmniTraceHeatmap.h"
+
+void UOmniAsyncTraceSubsystem::QueueTrace(EOmniTraceShape Shape, const FVector& Start, const FVector& End,
+	const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceType TraceType, ECollisionChannel Channel,
+	const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams,
+	const FAsyncTraceResultDelegate& OnTraceCompleted, const FTraceDebug& DebugOptions)
+{
+	const int32 SlotIndex = AllocateSlot();
+	FOmniAsyncTraceSlot& Slot = Slots[SlotIndex];
+	Slot.Shape = Shape;
+	Slot.Start = Start;
+	Slot.End = End;
+	Slot.Rotation = Rotation;
+	Slot.CollisionShape = CollisionShape;
+	Slot.TraceType = TraceType;
+	Slot.Channel = Channel;
+	Slot.QueryParams = QueryParams;
+	Slot.ResponseParams = ResponseParams;
+	Slot.OnTraceCompleted = OnTraceCompleted;
+	Slot.DebugOptions = DebugOptions;
+
+	PendingSlots.Add(SlotIndex);
+}
+
+void UOmniAsyncTraceSubsystem::QueueOverlap(EOmniTraceShape Shape, const FVector& Location, const FQuat& Rotation,
+	const FCollisionShape& CollisionShape, ECollisionChannel Channel, const FCollisionQueryParams& QueryParams,
+	const FCollisionResponseParams& ResponseParams, const FAsyncOverlapResultDelegate& OnOverlapCompleted,
+	const FTraceDebug& DebugOptions)
+{
+	const int32 SlotIndex = AllocateOverlapSlot();
+
+	FOmniAsyncOverlapSlot& Slot = OverlapSlots[SlotIndex];
+	Slot.Shape = Shape;
+	Slot.Location = Location;
+	Slot.Rotation = Rotation;
+	Slot.CollisionShape = CollisionShape;
+	Slot.Channel = Channel;
+	Slot.QueryParams = QueryParams;
+	Slot.ResponseParams = ResponseParams;
+	Slot.OnOverlapCompleted = OnOverlapCompleted;
+	Slot.DebugOptions = DebugOptions;
+
+	PendingOverlapSlots.Add(SlotIndex);
+}
+
+void UOmniAsyncTraceSubsystem::QueueLineOfSightFilter(const TArray<FHitResult>& HitResults, const FVector& Start,
+	ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams,
+	const FAsyncTraceResultDelegate& OnFilterCompleted, const FTraceDebug& DebugOptions)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::QueueLineOfSightFilter);
+
+	UWorld* World = GetWorld();
+
+	/**Unlike regular traces, these are submitted right away.
+	 * Every trace ends up in the same async trace buffer, so they're
+	 * still processed together and complete during the same frame.*/
+	FOmniLineOfSightFilterJob& Job = LineOfSightFilters.AddDefaulted_GetRef();
+	Job.HitResults = HitResults;
+	Job.Start = Start;
+	Job.OnFilterCompleted = OnFilterCompleted;
+	Job.DebugOptions = DebugOptions;
+	Job.Handles.Reserve(HitResults.Num());
+	for(const FHitResult& HitResult : HitResults)
+	{
+		Job.Handles.Add(World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, HitResult.ImpactPoint, Channel,
+			QueryParams, ResponseParams));
+	}
+}
+
+void UOmniAsyncTraceSubsystem::QueueMassTrace(const TArray<FOmniMassTraceRequest>& Requests, const TArray<AActor*>& IgnoredActors,
+	const FMassTraceCompletedDelegate& OnTraceCompleted, const FMassTraceResultDelegate& OnGroupCompleted, const FTraceDebug& DebugOptions)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::QueueMassTrace);
+
+	FOmniMassTraceJob& Job = MassTraces.AddDefaulted_GetRef();
+	Job.OnTraceCompleted = OnTraceCompleted;
+	Job.OnGroupCompleted = OnGroupCompleted;
+	Job.DebugOptions = DebugOptions;
+
+	const TSharedRef<FOmniMassTraceInput, ESPMode::ThreadSafe> Input = MakeShared<FOmniMassTraceInput, ESPMode::ThreadSafe>();
+	Input->World = FOmniTraceWorldHandle(this);
+
+	//Find every unique GUID, in the order they first appear, and how many requests use it
+	TMap<FGuid, int32> GroupLookup;
+	TArray<int32> GroupIndices;
+	GroupIndices.SetNumUninitialized(Requests.Num());
+	for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const FGuid& TraceGUID = Requests[RequestIndex].TraceGUID;
+		int32& GroupIndex = GroupLookup.FindOrAdd(TraceGUID, INDEX_NONE);
+		if(GroupIndex == INDEX_NONE)
+		{
+			GroupIndex = Job.Groups.AddDefaulted();
+			Job.Groups[GroupIndex].TraceGUID = TraceGUID;
+		}
+
+		GroupIndices[RequestIndex] = GroupIndex;
+		Job.Groups[GroupIndex].NumRequests++;
+	}
+
+	int32 RunningStart = 0;
+	TArray<int32> WriteIndices;
+	WriteIndices.SetNumUninitialized(Job.Groups.Num());
+	for(int32 GroupIndex = 0; GroupIndex < Job.Groups.Num(); ++GroupIndex)
+	{
+		Job.Groups[GroupIndex].FirstRequest = RunningStart;
+		WriteIndices[GroupIndex] = RunningStart;
+		RunningStart += Job.Groups[GroupIndex].NumRequests;
+	}
+
+	//Same as MassTrace, the requests are sorted by group while keeping their order within the group
+	Input->Requests.SetNum(Requests.Num());
+	for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		Input->Requests[WriteIndices[GroupIndices[RequestIndex]]++] = Requests[RequestIndex].Trace;
+	}
+
+	/**Queries can only be compiled on the game thread. Most mass traces
+	 * only use a handful of profiles, so a linear search is cheaper than hashing.*/
+	Input->QueryIndices.SetNumUninitialized(Input->Requests.Num());
+	for(int32 RequestIndex = 0; RequestIndex < Input->Requests.Num(); ++RequestIndex)
+	{
+		const FOmniTraceRequest& Request = Input->Requests[RequestIndex];
+		int32 QueryIndex = Input->Queries.IndexOfByPredicate([&Request](const FOmniTraceQuery& Query)
+		{
+			return Query.Profile == Request.Profile && Query.TraceComplex == Request.TraceComplex
+				&& Query.TraceSettings.UseTraceType == Request.TraceSettings.UseTraceType
+				&& Query.TraceSettings.TraceType == Request.TraceSettings.TraceType;
+		});
+
+		if(QueryIndex == INDEX_NONE)
+		{
+			QueryIndex = Input->Queries.Add(UOmniTraceLibrary::MakeTraceQuery(Request.Profile, Request.TraceSettings, IgnoredActors,
+				Request.TraceComplex, FTraceChannelAndResponseContainer(), DebugOptions.TraceTag));
+		}
+
+		Input->QueryIndices[RequestIndex] = QueryIndex;
+	}
+
+	const TSharedRef<const FOmniMassTraceInput, ESPMode::ThreadSafe> SharedInput = Input;
+	Job.Input = SharedInput;
+
+	for(FOmniMassTraceGroup& Group : Job.Groups)
+	{
+		Group.Task = UE::Tasks::Launch(TEXT("UOmniAsyncTraceSubsystem::MassTraceGroup"),
+			[SharedInput, FirstRequest = Group.FirstRequest, NumRequests = Group.NumRequests]()
+		{
+			FOmniBatchTraceResult Result;
+			Result.Ranges.SetNumUninitialized(NumRequests);
+			for(int32 Index = 0; Index < NumRequests; ++Index)
+			{
+				const int32 RequestIndex = FirstRequest + Index;
+				const FOmniTraceRequest& Request = SharedInput->Requests[RequestIndex];
+
+				FOmniTraceResultRange& Range = Result.Ranges[Index];
+				Range.Offset = Result.HitResults.Num();
+				UOmniTraceLibrary::TraceByQueryThreadSafe(SharedInput->World, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+					Request.MakeCollisionShape(), Request.ResultType, SharedInput->Queries[SharedInput->QueryIndices[RequestIndex]], Result.HitResults);
+				Range.Num = Result.HitResults.Num() - Range.Offset;
+			}
+			return Result;
+		});
+	}
+}
+
+void UOmniAsyncTraceSubsystem::QueuePolylineTrace(const TArray<FOmniPolylineTraceRequest>& Paths, const FOmniTraceQuery& Query,
+	const FPolylineTraceCompletedDelegate& OnTraceCompleted, const FTraceDebug& DebugOptions)
+{
+	const TSharedRef<FOmniPolylineTraceInput, ESPMode::ThreadSafe> Input = MakeShared<FOmniPolylineTraceInput, ESPMode::ThreadSafe>();
+	Input->World = FOmniTraceWorldHandle(this);
+	Input->Paths = Paths;
+	Input->Query = Query;
+
+	const TSharedRef<const FOmniPolylineTraceInput, ESPMode::ThreadSafe> SharedInput = Input;
+
+	FOmniPolylineTraceJob& Job = PolylineTraces.AddDefaulted_GetRef();
+	Job.Input = SharedInput;
+	Job.OnTraceCompleted = OnTraceCompleted;
+	Job.DebugOptions = DebugOptions;
+	Job.Task = UE::Tasks::Launch(TEXT("UOmniAsyncTraceSubsystem::PolylineTrace"), [SharedInput]()
+	{
+		//Paths are sequential on their own, so each path is one task
+		TArray<FOmniPolylineTraceResult> Results;
+		Results.SetNum(SharedInput->Paths.Num());
+		ParallelFor(TEXT("UOmniAsyncTraceSubsystem::PolylineTrace"), SharedInput->Paths.Num(), 1, [&](int32 PathIndex)
+		{
+			const FOmniPolylineTraceRequest& Path = SharedInput->Paths[PathIndex];
+			UOmniTraceLibrary::PolylineTraceByQueryThreadSafe(SharedInput->World, Path.Points, Path.Radius, SharedInput->Query, Results[PathIndex]);
+		});
+		return Results;
+	});
+}
+
+void UOmniAsyncTraceSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::Tick);
+
+	/**Dispatch first, in case any of the callbacks want to
+	 * start a new trace. That way they'll still get submitted
+	 * this frame instead of waiting an extra frame.*/
+	DispatchCompletedTraces();
+	DispatchCompletedOverlaps();
+	DispatchLineOfSightFilters();
+	DispatchMassTraces();
+	DispatchPolylineTraces();
+	SubmitPendingTraces();
+	SubmitPendingOverlaps();
+}
+
+void UOmniAsyncTraceSubsystem::Deinitialize()
+{
+	Slots.Empty();
+	FreeSlots.Empty();
+	PendingSlots.Empty();
+	InFlightSlots.Empty();
+	OverlapSlots.Empty();
+	FreeOverlapSlots.Empty();
+	PendingOverlapSlots.Empty();
+	InFlightOverlapSlots.Empty();
+	LineOfSightFilters.Empty();
+	//Mass trace tasks share their input and check the world through their handle, there's no need to wait for them
+	MassTraces.Empty();
+	MassTraceResults.Reset();
+	MassTraceDebugHits.Empty();
+	PolylineTraces.Empty();
+
+	Super::Deinitialize();
+}
+
+int32 UOmniAsyncTraceSubsystem::AllocateSlot()
+{
+	if(FreeSlots.IsEmpty())
+	{
+		return Slots.AddDefaulted();
+	}
+
+	SlotReuses++;
+	return FreeSlots.Pop(EAllowShrinking::No);
+}
+
+void UOmniAsyncTraceSubsystem::ReleaseSlot(int32 SlotIndex)
+{
+	FOmniAsyncTraceSlot& Slot = Slots[SlotIndex];
+	Slot.OnTraceCompleted.Unbind();
+	Slot.QueryParams.ClearIgnoredActors();
+	Slot.Handle = FTraceHandle();
+
+	FreeSlots.Add(SlotIndex);
+}
+
+int32 UOmniAsyncTraceSubsystem::AllocateOverlapSlot()
+{
+	if(FreeOverlapSlots.IsEmpty())
+	{
+		return OverlapSlots.AddDefaulted();
+	}
+
+	SlotReuses++;
+	return FreeOverlapSlots.Pop(EAllowShrinking::No);
+}
+
+void UOmniAsyncTraceSubsystem::ReleaseOverlapSlot(int32 SlotIndex)
+{
+	FOmniAsyncOverlapSlot& Slot = OverlapSlots[SlotIndex];
+	Slot.OnOverlapCompleted.Unbind();
+	Slot.QueryParams.ClearIgnoredActors();
+	Slot.Handle = FTraceHandle();
+
+	FreeOverlapSlots.Add(SlotIndex);
+}
+
+void UOmniAsyncTraceSubsystem::DispatchCompletedTraces()
+{
+	if(InFlightSlots.IsEmpty())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	CompletedSlots.Reset();
+	CompletedData.Reset();
+	ExpiredSlots.Reset();
+
+	for(int32 Index = InFlightSlots.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 SlotIndex = InFlightSlots[Index];
+		const FTraceHandle& Handle = Slots[SlotIndex].Handle;
+
+		FTraceDatum& Datum = CompletedData.AddDefaulted_GetRef();
+		if(World->QueryTraceData(Handle, Datum))
+		{
+			CompletedSlots.Add(SlotIndex);
+			InFlightSlots.RemoveAtSwap(Index, EAllowShrinking::No);
+			continue;
+		}
+
+		CompletedData.Pop(EAllowShrinking::No);
+
+		/**The async trace system only keeps the data around for one frame.
+		 * If we've missed it, the caller still hears back without any hits.*/
+		if(!World->IsTraceHandleValid(Handle, false))
+		{
+			InFlightSlots.RemoveAtSwap(Index, EAllowShrinking::No);
+			ExpiredSlots.Add(SlotIndex);
+		}
+	}
+
+	/**Slots are not released until every callback has been executed,
+	 * so a callback queuing a new trace can't overwrite a slot we
+	 * have yet to dispatch. It can however grow the slot array,
+	 * so we have to index into it every time.*/
+	for(int32 Index = 0; Index < CompletedSlots.Num(); ++Index)
+	{
+		const int32 SlotIndex = CompletedSlots[Index];
+		const TArray<FHitResult>& HitResults = CompletedData[Index].OutHits;
+
+		const FOmniAsyncTraceSlot& Slot = Slots[SlotIndex];
+		if(FOmniTraceStats::IsEnabled())
+		{
+			const FName TraceTag = Slot.DebugOptions.TraceTag.IsNone() ? Slot.QueryParams.TraceTag : Slot.DebugOptions.TraceTag;
+			const EAsyncTraceResultType ResultType = Slot.TraceType == EAsyncTraceType::Multi ? MultiResult
+				: Slot.TraceType == EAsyncTraceType::Test ? TestResult : SingleResult;
+			FOmniTraceStats::RecordTrace(TraceTag, Slot.Shape, ResultType, HitResults.Num(), 0, true);
+		}
+
+		if(FOmniTraceHeatmap::IsEnabled())
+		{
+			const FName TraceTag = Slot.DebugOptions.TraceTag.IsNone() ? Slot.QueryParams.TraceTag : Slot.DebugOptions.TraceTag;
+			FOmniTraceHeatmap::RecordTrace(TraceTag, Slot.Start, Slot.End, HitResults);
+		}
+
+		UOmniTraceLibrary::HandleShapeTraceDebug(World, Slot.Shape, Slot.CollisionShape, Slot.DebugOptions, HitResults);
+
+		const FAsyncTraceResultDelegate OnTraceCompleted = Slot.OnTraceCompleted;
+		OnTraceCompleted.ExecuteIfBound(HitResults);
+	}
+
+	for(const int32 SlotIndex : ExpiredSlots)
+	{
+		const FAsyncTraceResultDelegate OnTraceCompleted = Slots[SlotIndex].OnTraceCompleted;
+		OnTraceCompleted.ExecuteIfBound(TArray<FHitResult>());
+	}
+
+	for(const int32 SlotIndex : CompletedSlots)
+	{
+		ReleaseSlot(SlotIndex);
+	}
+
+	for(const int32 SlotIndex : ExpiredSlots)
+	{
+		ReleaseSlot(SlotIndex);
+	}
+}
+
+void UOmniAsyncTraceSubsystem::DispatchCompletedOverlaps()
+{
+	if(InFlightOverlapSlots.IsEmpty())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	CompletedOverlapSlots.Reset();
+	CompletedOverlapData.Reset();
+	ExpiredOverlapSlots.Reset();
+
+	for(int32 Index = InFlightOverlapSlots.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 SlotIndex = InFlightOverlapSlots[Index];
+		FOmniAsyncOverlapSlot& Slot = OverlapSlots[SlotIndex];
+
+		FOverlapDatum& Datum = CompletedOverlapData.AddDefaulted_GetRef();
+		if(World->QueryOverlapData(Slot.Handle, Datum))
+		{
+			CompletedOverlapSlots.Add(SlotIndex);
+			InFlightOverlapSlots.RemoveAtSwap(Index, EAllowShrinking::No);
+			continue;
+		}
+
+		CompletedOverlapData.Pop(EAllowShrinking::No);
+
+		if(!World->IsTraceHandleValid(Slot.Handle, true))
+		{
+			InFlightOverlapSlots.RemoveAtSwap(Index, EAllowShrinking::No);
+			ExpiredOverlapSlots.Add(SlotIndex);
+		}
+	}
+
+	//Same as the traces, slots are only released once every callback has been executed
+	for(int32 Index = 0; Index < CompletedOverlapSlots.Num(); ++Index)
+	{
+		DispatchedOverlaps.Reset();
+		for(const FOverlapResult& Overlap : CompletedOverlapData[Index].OutOverlaps)
+		{
+			DispatchedOverlaps.Emplace(Overlap);
+		}
+
+		const FOmniAsyncOverlapSlot& Slot = OverlapSlots[CompletedOverlapSlots[Index]];
+		UOmniTraceLibrary::HandleOverlapDebug(World, Slot.Shape, Slot.CollisionShape, Slot.DebugOptions, DispatchedOverlaps);
+
+		const FAsyncOverlapResultDelegate OnOverlapCompleted = Slot.OnOverlapCompleted;
+		OnOverlapCompleted.ExecuteIfBound(DispatchedOverlaps);
+	}
+
+	for(const int32 SlotIndex : ExpiredOverlapSlots)
+	{
+		const FAsyncOverlapResultDelegate OnOverlapCompleted = OverlapSlots[SlotIndex].OnOverlapCompleted;
+		OnOverlapCompleted.ExecuteIfBound(TArray<FOmniOverlapResult>());
+	}
+
+	for(const int32 SlotIndex : CompletedOverlapSlots)
+	{
+		ReleaseOverlapSlot(SlotIndex);
+	}
+
+	for(const int32 SlotIndex : ExpiredOverlapSlots)
+	{
+		ReleaseOverlapSlot(SlotIndex);
+	}
+}
+
+void UOmniAsyncTraceSubsystem::SubmitPendingOverlaps()
+{
+	if(PendingOverlapSlots.IsEmpty())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	for(const int32 SlotIndex : PendingOverlapSlots)
+	{
+		FOmniAsyncOverlapSlot& Slot = OverlapSlots[SlotIndex];
+		Slot.Handle = World->AsyncOverlapByChannel(Slot.Location, Slot.Rotation, Slot.Channel, Slot.CollisionShape,
+			Slot.QueryParams, Slot.ResponseParams);
+		InFlightOverlapSlots.Add(SlotIndex);
+	}
+
+	PendingOverlapSlots.Reset();
+}
+
+void UOmniAsyncTraceSubsystem::DispatchLineOfSightFilters()
+{
+	if(LineOfSightFilters.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::DispatchLineOfSightFilters);
+
+	UWorld* World = GetWorld();
+
+	/**Callbacks might queue new filters, so move the current ones out first.*/
+	TArray<FOmniLineOfSightFilterJob> Jobs = MoveTemp(LineOfSightFilters);
+	LineOfSightFilters.Reset();
+
+	TArray<bool, TInlineAllocator<256>> HasLineOfSight;
+	FTraceDatum Datum;
+
+	for(FOmniLineOfSightFilterJob& Job : Jobs)
+	{
+		HasLineOfSight.Reset();
+		bool bIsComplete = true;
+
+		for(int32 Index = 0; Index < Job.Handles.Num(); ++Index)
+		{
+			if(!World->QueryTraceData(Job.Handles[Index], Datum))
+			{
+				/**Traces whose results have expired count as not visible,
+				 * the job is still dispatched so callers always hear back.*/
+				if(!World->IsTraceHandleValid(Job.Handles[Index], false))
+				{
+					HasLineOfSight.Add(false);
+					continue;
+				}
+
+				bIsComplete = false;
+				break;
+			}
+
+			const FHitResult* BlockingHit = Datum.OutHits.FindByPredicate([](const FHitResult& HitResult)
+			{
+				return HitResult.bBlockingHit;
+			});
+			HasLineOfSight.Add(!BlockingHit || BlockingHit->GetComponent() == Job.HitResults[Index].GetComponent());
+		}
+
+		if(!bIsComplete)
+		{
+			LineOfSightFilters.Add(MoveTemp(Job));
+			continue;
+		}
+
+		if(Job.DebugOptions.bEnableDebug)
+		{
+			//The results are still buffered, so they're only fetched again when they're drawn
+			FTraceDebug DebugOptions = Job.DebugOptions;
+			DebugOptions.Start = Job.Start;
+			DebugOptions.Rotation = FQuat::Identity;
+			for(int32 Index = 0; Index < Job.Handles.Num(); ++Index)
+			{
+				Datum.OutHits.Reset();
+				World->QueryTraceData(Job.Handles[Index], Datum);
+				DebugOptions.TraceTag = FName(Job.DebugOptions.TraceTag, Index + 1);
+				DebugOptions.End = Job.HitResults[Index].ImpactPoint;
+				UOmniTraceLibrary::HandleShapeTraceDebug(World, EOmniTraceShape::Line, FCollisionShape::LineShape, DebugOptions, Datum.OutHits);
+			}
+		}
+
+		UOmniTraceLibrary::RemoveHitResultsWithoutLineOfSight(Job.HitResults, HasLineOfSight);
+		Job.OnFilterCompleted.ExecuteIfBound(Job.HitResults);
+	}
+}
+
+void UOmniAsyncTraceSubsystem::DispatchMassTraces()
+{
+	if(MassTraces.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::DispatchMassTraces);
+
+	//Callbacks might queue new mass traces, those will be handled next tick
+	TArray<FOmniMassTraceJob> Jobs = MoveTemp(MassTraces);
+	MassTraces.Reset();
+
+	const UWorld* World = GetWorld();
+	for(FOmniMassTraceJob& Job : Jobs)
+	{
+		for(FOmniMassTraceGroup& Group : Job.Groups)
+		{
+			if(Group.bDispatched || !Group.Task.IsCompleted())
+			{
+				continue;
+			}
+
+			Group.bDispatched = true;
+			Job.NumDispatchedGroups++;
+
+			const FOmniBatchTraceResult& GroupResult = Group.Task.GetResult();
+			if(Job.DebugOptions.bEnableDebug)
+			{
+				//Same keys as a sync mass trace, so every request gets its own shapes
+				FTraceDebug DebugOptions = Job.DebugOptions;
+				for(int32 Index = 0; Index < Group.NumRequests; ++Index)
+				{
+					const int32 RequestIndex = Group.FirstRequest + Index;
+					const FOmniTraceRequest& Request = Job.Input->Requests[RequestIndex];
+					MassTraceDebugHits.Reset();
+					MassTraceDebugHits.Append(GroupResult.GetHitResultsForRequest(Index));
+					DebugOptions.TraceTag = FName(Job.DebugOptions.TraceTag, RequestIndex + 1);
+					DebugOptions.Start = Request.Start;
+					DebugOptions.End = Request.End;
+					DebugOptions.Rotation = FQuat(Request.Rotation);
+					UOmniTraceLibrary::HandleShapeTraceDebug(World, Request.Shape, Request.MakeCollisionShape(), DebugOptions, MassTraceDebugHits);
+				}
+			}
+
+			FMassTraceResult TraceResult;
+			TraceResult.TraceGUID = Group.TraceGUID;
+			TraceResult.HitResults = GroupResult.HitResults;
+			Job.OnGroupCompleted.ExecuteIfBound(TraceResult);
+		}
+
+		if(Job.NumDispatchedGroups < Job.Groups.Num())
+		{
+			MassTraces.Add(MoveTemp(Job));
+			continue;
+		}
+
+		//Every group is done, put their results together in the same layout as MassTrace
+		MassTraceResults.Reset();
+		for(const FOmniMassTraceGroup& Group : Job.Groups)
+		{
+			const FOmniBatchTraceResult& GroupResult = Group.Task.GetResult();
+			MassTraceResults.GuidIndices.Add(Group.TraceGUID, MassTraceResults.TraceGUIDs.Add(Group.TraceGUID));
+
+			FOmniTraceResultRange& Range = MassTraceResults.Ranges.AddDefaulted_GetRef();
+			Range.Offset = MassTraceResults.HitResults.Num();
+			Range.Num = GroupResult.HitResults.Num();
+			MassTraceResults.HitResults.Append(GroupResult.HitResults);
+		}
+
+		Job.OnTraceCompleted.ExecuteIfBound(MassTraceResults);
+	}
+}
+
+void UOmniAsyncTraceSubsystem::DispatchPolylineTraces()
+{
+	if(PolylineTraces.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniAsyncTraceSubsystem::DispatchPolylineTraces);
+
+	//Callbacks might queue new polyline traces, those will be handled next tick
+	TArray<FOmniPolylineTraceJob> Jobs = MoveTemp(PolylineTraces);
+	PolylineTraces.Reset();
+
+	const UWorld* World = GetWorld();
+	for(FOmniPolylineTraceJob& Job : Jobs)
+	{
+		if(!Job.Task.IsCompleted())
+		{
+			PolylineTraces.Add(MoveTemp(Job));
+			continue;
+		}
+
+		const TArray<FOmniPolylineTraceResult>& Results = Job.Task.GetResult();
+		if(Job.DebugOptions.bEnableDebug)
+		{
+			const TArray<FOmniPolylineTraceRequest>& Paths = Job.Input->Paths;
+			for(int32 PathIndex = 0; PathIndex < Paths.Num(); ++PathIndex)
+			{
+				UOmniTraceLibrary::HandlePolylineTraceDebug(World, Paths[PathIndex].Points, Results[PathIndex], Job.DebugOptions,
+					FName(Job.DebugOptions.TraceTag, PathIndex + 1));
+			}
+		}
+
+		Job.OnTraceCompleted.ExecuteIfBound(Results);
+	}
+}
+
+void UOmniAsyncTraceSubsystem::SubmitPendingTraces()
+{
+	if(PendingSlots.IsEmpty())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	for(const int32 SlotIndex : PendingSlots)
+	{
+		FOmniAsyncTraceSlot& Slot = Slots[SlotIndex];
+		if(Slot.Shape == EOmniTraceShape::Line)
+		{
+			Slot.Handle = World->AsyncLineTraceByChannel(Slot.TraceType, Slot.Start, Slot.End, Slot.Channel,
+				Slot.QueryParams, Slot.ResponseParams);
+		}
+		else
+		{
+			Slot.Handle = World->AsyncSweepByChannel(Slot.TraceType, Slot.Start, Slot.End, Slot.Rotation, Slot.Channel,
+				Slot.CollisionShape, Slot.QueryParams, Slot.ResponseParams);
+		}
+
+		InFlightSlots.Add(SlotIndex);
+	}
+
+	PendingSlots.Reset();
+}
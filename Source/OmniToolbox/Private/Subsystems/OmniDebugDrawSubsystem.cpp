@@ -2,16 +2,79 @@
 
 
 #include "Subsystems/OmniDebugDrawSubsystem.h"
+#include "OmniToolbox.h"
 #include "DrawDebugHelpers.h"
+#include "Engine/World.h"
 #include "OmniRuntimeMacros.h"
 #include "VisualLogger/VisualLogger.h"
 #include "Logging/MessageLog.h"
+#include <type_traits>
 
 Omni_ConsoleVariable(
 	OMNITOOLBOX_API, bool, DrawDebugShapes, 1,
 	"OmniToolbox.Debug.DrawDebugShapes",
 	"Allow the OmniToolbox debug draw subsystem to draw debug shapes");
 
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, BatchDebugShapes, 1,
+	"OmniToolbox.Debug.BatchDebugShapes",
+	"Tessellate debug shapes into cached lines and submit them to the line batchers in one call, "
+	"instead of calling the DrawDebug helpers for every shape");
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, int32, MaxCachedDebugLines, 65536,
+	"OmniToolbox.Debug.MaxCachedDebugLines",
+	"Maximum amount of tessellated lines the debug draw subsystem keeps cached between frames. "
+	"Shapes that don't fit are tessellated again every frame");
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, VislogChangesOnly, 1,
+	"OmniToolbox.Debug.VislogChangesOnly",
+	"Only send debug shapes to the visual logger when they change or a keyframe is due, instead of every frame");
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, float, VislogKeyframeInterval, 1.f,
+	"OmniToolbox.Debug.VislogKeyframeInterval",
+	"Seconds after which an unchanged debug shape is sent to the visual logger again. 0 or less only logs changes");
+
+/**Logs per second for each category that has been limited through OmniToolbox.Debug.VislogCategoryRate*/
+static TMap<FName, float> VislogCategoryRates;
+
+static FAutoConsoleCommand VislogCategoryRateCommand(
+	TEXT("OmniToolbox.Debug.VislogCategoryRate"),
+	TEXT("Limit how many times per second debug shapes of a log category are sent to the visual logger. ")
+	TEXT("Leave out the rate or use 0 to remove the limit. Arguments: Category [LogsPerSecond]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if(Args.IsEmpty())
+		{
+			for(const TPair<FName, float>& Rate : VislogCategoryRates)
+			{
+				UE_LOG(LogOmniToolbox, Log, TEXT("VislogCategoryRate: %s - %.2f per second"), *Rate.Key.ToString(), Rate.Value);
+			}
+			return;
+		}
+
+		const FName Category(*Args[0]);
+		const float Rate = Args.IsValidIndex(1) ? FCString::Atof(*Args[1]) : 0.f;
+		if(Rate > 0)
+		{
+			VislogCategoryRates.Add(Category, Rate);
+		}
+		else
+		{
+			VislogCategoryRates.Remove(Category);
+		}
+	}));
+
+namespace OmniDebugDraw
+{
+	/**Lets worker threads find a world's subsystem without going through GetSubsystem.
+	 * Deinitialize waits for every thread that is still queueing a shape.*/
+	FRWLock WorldSubsystemsLock;
+	TMap<const UWorld*, UOmniDebugDrawSubsystem*> WorldSubsystems;
+}
+
 #define VLOG_BP_LIBRARY_ADD_TO_LOG(CategoryName, Format, ...) \
 if (IsInGameThread())\
 {\
@@ -22,213 +85,1039 @@ else\
 FMsg::Logf(__FILE__, __LINE__, UE_FNAME_TO_LOG_CATEGORY_NAME(CategoryName), DefaultVerbosity, (Format), __VA_ARGS__);\
 }
 
-void UOmniDebugDrawSubsystem::AddShape(FOmniDebugDrawCommand Command, FName Key)
+/**V: Small note; you're not "really supposed to" use most kismet libraries
+ * in C++. But in this case, the kismet library does exactly what we
+ * want to do. They handle the preprocessor macro for us and they handle
+ * the message log for us, and we want as much parity between the blueprint
+ * nodes as possible.
+ *
+ * Every shape type has a DrawShape, LogShape and AddShapeToMessageLog overload,
+ * which TickPool picks between at compile time. */
+namespace OmniDebugDraw
 {
-	if(Key.IsNone())
+	static constexpr ELogVerbosity::Type DefaultVerbosity = ELogVerbosity::Log;
+
+	//Circle
+
+	static void DrawShape(UWorld* World, const FOmniDebugCircle& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
 	{
-		FGuid RandomGuid = FGuid::NewGuid();
-		Key = FName(*RandomGuid.ToString(EGuidFormats::Digits));
+		DrawDebugCircle(World, Shape.Center, Shape.Radius, 16, Style.Color,
+			false, 0, Style.DepthPriority, Style.Thickness, Shape.Rotation.GetAxisY(), Shape.Rotation.GetAxisZ(), false);
 	}
-	
-	ShapesToDraw.Add(Key, Command);
-}
 
-void UOmniDebugDrawSubsystem::Tick(float DeltaTime)
-{
-	TArray<FName> ShapesToRemove;
-	
-	/**Start going over every command and draw them.
-	 * V: Small note; you're not "really supposed to" use most kismet libraries
-	 * in C++. But in this case, the kismet library does exactly what we
-	 * want to do. They handle the preprocessor macro for us and they handle
-	 * the message log for us, and we want as much parity between the blueprint
-	 * nodes as possible. */
-	for(auto& CurrentCommand : ShapesToDraw)
+	static void LogShape(const FOmniDebugCircle& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
 	{
-		FOmniDebugDrawCommand& Command = CurrentCommand.Value;
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::DiscLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, Shape.Center, Shape.Rotation.GetForwardVector(), Shape.Radius, 
+			Style.Color, Style.Thickness /**For some reason the thickness for discs is extremely thin*/,
+			Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
 
-		switch(Command.Type) {
-		case Circle:
-			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugCircle(GetWorld(), Command.Location, Command.Radius, 16, Command.Color.ToFColor(true),
-						false, 0, Command.DepthPriority, Command.Thickness, Command.Rotation.GetAxisY(), Command.Rotation.GetAxisZ(), false);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::DiscLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Command.Location, Command.Rotation.GetForwardVector(), Command.Radius, 
-					Command.Color.ToFColor(true), Command.Thickness /**For some reason the thickness for discs is extremely thin*/,
-					Command.Wireframe, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogCircle: '%s' - Center: (%s) | UpAxis: (%s) | Radius: %f")	, *Command.Text, *Command.Location.ToString(), *Command.Direction.ToString(), Command.Radius);
-				}
-				break;
-			}
-			
-		case Line:
-			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugLine(GetWorld(), Command.Location, Command.End, Command.Color.ToFColor(true),
-						false, 0, Command.DepthPriority, Command.Thickness);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::SegmentLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log,
-					Command.Location, Command.End, Command.Color.ToFColor(true), Command.Thickness * 3, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogLine: '%s' - Start: (%s) | End: %s"), *Command.Text, *Command.Location.ToString(), *Command.End.ToString());
-				}
-				break;
-			}
-			
-		case Box:
+	static void AddShapeToMessageLog(const FOmniDebugCircle& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogCircle: '%s' - Center: (%s) | UpAxis: (%s) | Radius: %f"), *Log.Text, *Shape.Center.ToString(), *Shape.Rotation.GetForwardVector().ToString(), Shape.Radius);
+	}
+
+	//Line
+
+	static void DrawShape(UWorld* World, const FOmniDebugLine& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugLine(World, Shape.Start, Shape.End, Style.Color,
+			false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugLine& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::SegmentLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log,
+			Shape.Start, Shape.End, Style.Color, Style.Thickness * 3, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugLine& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogLine: '%s' - Start: (%s) | End: %s"), *Log.Text, *Shape.Start.ToString(), *Shape.End.ToString());
+	}
+
+	//Box
+
+	static void DrawShape(UWorld* World, const FOmniDebugBox& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugBox(World, Shape.Center, Shape.Extent, Style.Color,
+			false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugBox& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::BoxLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, FBox(Shape.Center - Shape.Extent, Shape.Center + Shape.Extent), FMatrix::Identity, 
+			Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugBox& Shape, const FOmniDebugShapeLog& Log)
+	{
+		const FBox Box = FBox(Shape.Center - Shape.Extent, Shape.Center + Shape.Extent);
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogBox: '%s' - BoxMin: (%s) | BoxMax: (%s)"), *Log.Text, *Box.Min.ToString(), *Box.Max.ToString());
+	}
+
+	//Rotated box
+
+	static void DrawShape(UWorld* World, const FOmniDebugRotatedBox& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugBox(World, Shape.Center, Shape.Extent, Shape.Rotation, Style.Color,
+			false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugRotatedBox& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::BoxLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, FBox(Shape.Center - Shape.Extent, Shape.Center + Shape.Extent), Shape.Rotation.ToMatrix(), 
+			Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugRotatedBox& Shape, const FOmniDebugShapeLog& Log)
+	{
+		const FBox Box = FBox(Shape.Center - Shape.Extent, Shape.Center + Shape.Extent);
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogBox: '%s' - BoxMin: (%s) | BoxMax: (%s)"), *Log.Text, *Box.Min.ToString(), *Box.Max.ToString());
+	}
+
+	//Sphere
+
+	static void DrawShape(UWorld* World, const FOmniDebugSphere& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugSphere(World, Shape.Center, Shape.Radius, 16, Style.Color,
+			false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugSphere& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::SphereLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, Shape.Center, Shape.Radius, Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugSphere& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogSphere: '%s' - Center: (%s) | Radius: %f"), *Log.Text, *Shape.Center.ToString(), Shape.Radius);
+	}
+
+	//Capsule
+
+	static void DrawShape(UWorld* World, const FOmniDebugCapsule& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		/**We have to offset the center, because Vislog capsule does not use the center. And I think this is far more useful*/
+		DrawDebugCapsule(World, FVector(Shape.Base.X, Shape.Base.Y, Shape.Base.Z + Shape.HalfHeight), Shape.HalfHeight, Shape.Radius, Shape.Rotation, Style.Color,
+			false, 0, 0, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugCapsule& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::CapsuleLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, Shape.Base, Shape.HalfHeight, Shape.Radius, Shape.Rotation, Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugCapsule& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogCapsule: '%s' - Base: (%s) | HalfHeight: %f | Radius: %f | Rotation: (%s)"), *Log.Text, *Shape.Base.ToString(), Shape.HalfHeight, Shape.Radius, *Shape.Rotation.ToString());
+	}
+
+	//Arrow
+
+	static void DrawShape(UWorld* World, const FOmniDebugArrow& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugDirectionalArrow(World, Shape.Start, Shape.End, Shape.ArrowSize, Style.Color, false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugArrow& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::ArrowLineLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log,
+			Shape.Start, Shape.End, Style.Color, Shape.ArrowSize, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugArrow& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogText: '%s'"), *Log.Text);
+	}
+
+	//Text
+
+	static void DrawShape(UWorld* World, const FOmniDebugText& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugString(World, Shape.Location, Log.Text, nullptr, Style.Color, 0, false, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugText& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		/**There is no "Log text" in a way that draws text in the world like we have for the other shapes.
+		 * Fake it by making a sphere with 0 radius. This lets us hijack the text system that comes with
+		 * other shapes */
+		FVisualLogger::SphereLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, Shape.Location, 0, Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		/**Majority of the time when you log text, you also want it to appear in the log section*/
+		FVisualLogger::CategorizedLogf(Log.Owner.Get(), Log.LogCategory, DefaultVerbosity
+			, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugText& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogText: '%s'"), *Log.Text);
+	}
+
+	//Cone
+
+	static void DrawShape(UWorld* World, const FOmniDebugCone& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		DrawDebugCone(World, Shape.Origin, Shape.Direction, Shape.Length, FMath::DegreesToRadians(Shape.AngleWidth), FMath::DegreesToRadians(Shape.AngleHeight), 
+			16, Style.Color, false, 0, Style.DepthPriority, Style.Thickness);
+	}
+
+	static void LogShape(const FOmniDebugCone& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		FVisualLogger::ConeLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log
+			, Shape.Origin, Shape.Direction, Shape.Length, Shape.AngleHeight, Style.Color, Log.Wireframe, TEXT("%s"), *Log.Text);
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugCone& Shape, const FOmniDebugShapeLog& Log)
+	{
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogCone: '%s' - Origin: (%s) | Direction: (%s) | Length: %f | Angle: %f"), *Log.Text, *Shape.Origin.ToString(), *Shape.Direction.ToString(), Shape.Length, Shape.AngleHeight);
+	}
+
+	//Polyline
+
+	static void DrawShape(UWorld* World, const FOmniDebugPolyline& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		for(int32 PointIndex = 0; PointIndex + 1 < Shape.Points.Num(); ++PointIndex)
+		{
+			DrawDebugLine(World, Shape.Points[PointIndex], Shape.Points[PointIndex + 1], Style.Color,
+				false, 0, Style.DepthPriority, Style.Thickness);
+		}
+	}
+
+	static void LogShape(const FOmniDebugPolyline& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		#if ENABLE_VISUAL_LOG
+		for(int32 PointIndex = 0; PointIndex + 1 < Shape.Points.Num(); ++PointIndex)
+		{
+			//Only the last segment carries the text, otherwise it would be repeated along the entire path
+			FVisualLogger::SegmentLogf(Log.Owner.Get(), Log.LogCategory, ELogVerbosity::Log,
+				Shape.Points[PointIndex], Shape.Points[PointIndex + 1], Style.Color, Style.Thickness * 3,
+				TEXT("%s"), PointIndex + 2 == Shape.Points.Num() ? *Log.Text : TEXT(""));
+		}
+		#endif
+	}
+
+	static void AddShapeToMessageLog(const FOmniDebugPolyline& Shape, const FOmniDebugShapeLog& Log)
+	{
+		const FVector Start = Shape.Points.IsEmpty() ? FVector::ZeroVector : Shape.Points[0];
+		const FVector End = Shape.Points.IsEmpty() ? FVector::ZeroVector : Shape.Points.Last();
+		VLOG_BP_LIBRARY_ADD_TO_LOG(Log.LogCategory, TEXT("LogPolyline: '%s' - Start: (%s) | End: (%s) | Points: %d"), *Log.Text, *Start.ToString(), *End.ToString(), Shape.Points.Num());
+	}
+
+	/**Content hashes.
+	 * Every field is hashed separately, so struct padding never ends up in the hash. */
+
+	template<typename... FieldTypes>
+	static uint32 HashFields(const FieldTypes&... Fields)
+	{
+		uint32 Hash = 0;
+		((Hash = FCrc::MemCrc32(&Fields, sizeof(Fields), Hash)), ...);
+		return Hash;
+	}
+
+	static uint32 GetShapeHash(const FOmniDebugCircle& Shape) { return HashFields(Shape.Center, Shape.Rotation, Shape.Radius); }
+	static uint32 GetShapeHash(const FOmniDebugLine& Shape) { return HashFields(Shape.Start, Shape.End); }
+	static uint32 GetShapeHash(const FOmniDebugBox& Shape) { return HashFields(Shape.Center, Shape.Extent); }
+	static uint32 GetShapeHash(const FOmniDebugRotatedBox& Shape) { return HashFields(Shape.Center, Shape.Extent, Shape.Rotation); }
+	static uint32 GetShapeHash(const FOmniDebugSphere& Shape) { return HashFields(Shape.Center, Shape.Radius); }
+	static uint32 GetShapeHash(const FOmniDebugCapsule& Shape) { return HashFields(Shape.Base, Shape.Rotation, Shape.HalfHeight, Shape.Radius); }
+	static uint32 GetShapeHash(const FOmniDebugArrow& Shape) { return HashFields(Shape.Start, Shape.End, Shape.ArrowSize); }
+	static uint32 GetShapeHash(const FOmniDebugText& Shape) { return HashFields(Shape.Location); }
+	static uint32 GetShapeHash(const FOmniDebugCone& Shape) { return HashFields(Shape.Origin, Shape.Direction, Shape.Length, Shape.AngleWidth, Shape.AngleHeight); }
+	static uint32 GetShapeHash(const FOmniDebugPolyline& Shape) { return FCrc::MemCrc32(Shape.Points.GetData(), Shape.Points.Num() * sizeof(FVector)); }
+
+	template<typename ShapeType>
+	static uint32 GetContentHash(const ShapeType& Shape, const FOmniDebugShapeStyle& Style, const FOmniDebugShapeLog& Log)
+	{
+		uint32 Hash = HashCombine(GetShapeHash(Shape), HashFields(Style.Color, Style.Thickness, Log.Wireframe));
+		Hash = HashCombine(Hash, GetTypeHash(Log.LogCategory));
+		return FCrc::StrCrc32(*Log.Text, Hash);
+	}
+
+	/**Location used when moving a shape. Moving translates the entire shape.*/
+
+	static FVector GetShapeLocation(const FOmniDebugCircle& Shape) { return Shape.Center; }
+	static FVector GetShapeLocation(const FOmniDebugLine& Shape) { return Shape.Start; }
+	static FVector GetShapeLocation(const FOmniDebugBox& Shape) { return Shape.Center; }
+	static FVector GetShapeLocation(const FOmniDebugRotatedBox& Shape) { return Shape.Center; }
+	static FVector GetShapeLocation(const FOmniDebugSphere& Shape) { return Shape.Center; }
+	static FVector GetShapeLocation(const FOmniDebugCapsule& Shape) { return Shape.Base; }
+	static FVector GetShapeLocation(const FOmniDebugArrow& Shape) { return Shape.Start; }
+	static FVector GetShapeLocation(const FOmniDebugText& Shape) { return Shape.Location; }
+	static FVector GetShapeLocation(const FOmniDebugCone& Shape) { return Shape.Origin; }
+	static FVector GetShapeLocation(const FOmniDebugPolyline& Shape) { return Shape.Points.IsEmpty() ? FVector::ZeroVector : Shape.Points[0]; }
+
+	static void TranslateShape(FOmniDebugCircle& Shape, const FVector& Delta) { Shape.Center += Delta; }
+	static void TranslateShape(FOmniDebugLine& Shape, const FVector& Delta) { Shape.Start += Delta; Shape.End += Delta; }
+	static void TranslateShape(FOmniDebugBox& Shape, const FVector& Delta) { Shape.Center += Delta; }
+	static void TranslateShape(FOmniDebugRotatedBox& Shape, const FVector& Delta) { Shape.Center += Delta; }
+	static void TranslateShape(FOmniDebugSphere& Shape, const FVector& Delta) { Shape.Center += Delta; }
+	static void TranslateShape(FOmniDebugCapsule& Shape, const FVector& Delta) { Shape.Base += Delta; }
+	static void TranslateShape(FOmniDebugArrow& Shape, const FVector& Delta) { Shape.Start += Delta; Shape.End += Delta; }
+	static void TranslateShape(FOmniDebugText& Shape, const FVector& Delta) { Shape.Location += Delta; }
+	static void TranslateShape(FOmniDebugCone& Shape, const FVector& Delta) { Shape.Origin += Delta; }
+	static void TranslateShape(FOmniDebugPolyline& Shape, const FVector& Delta)
+	{
+		for(FVector& Point : Shape.Points)
+		{
+			Point += Delta;
+		}
+	}
+
+	/**Batched lines.
+	 * Every AppendShapeLines overload produces the same lines as the DrawDebug* helper
+	 * that DrawShape calls, so the batched path and the fallback look identical. */
+
+	struct FLineWriter
+	{
+		TArray<FBatchedLine>& Lines;
+		FLinearColor Color;
+		float Lifetime = 0;
+		float Thickness = 0;
+		uint8 DepthPriority = 0;
+
+		void Add(const FVector& Start, const FVector& End) const
+		{
+			Lines.Emplace(Start, End, Color, Lifetime, Thickness, DepthPriority);
+		}
+	};
+
+	/**Every round shape uses 16 segments, so the sin and cos of every
+	 * step only has to be calculated once. X is the cos, Y is the sin.*/
+	static constexpr int32 NumRoundSegments = 16;
+
+	static const FVector2D* GetUnitCircle()
+	{
+		static const TArray<FVector2D> UnitCircle = []()
+		{
+			TArray<FVector2D> Points;
+			for(int32 Step = 0; Step <= NumRoundSegments; ++Step)
 			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugBox(GetWorld(), Command.Location, Command.Extent, Command.Color.ToFColor(true),
-						false, 0, Command.DepthPriority, Command.Thickness);
-				}
-				FBox Box = FBox(Command.Location - Command.Extent, Command.Location + Command.Extent);
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::BoxLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Box, FMatrix::Identity, 
-					Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogBox: '%s' - BoxMin: (%s) | BoxMax: (%s)"), *Command.Text, *Box.Min.ToString(), *Box.Max.ToString());
-				}
-				break;
+				double Sin, Cos;
+				FMath::SinCos(&Sin, &Cos, 2.0 * UE_DOUBLE_PI * Step / NumRoundSegments);
+				Points.Add(FVector2D(Cos, Sin));
 			}
-			
-		case Sphere:
+			return Points;
+		}();
+		return UnitCircle.GetData();
+	}
+
+	static void AppendArc(const FLineWriter& Writer, const FVector& Center, const FVector& X, const FVector& Y, float Radius, int32 NumSteps)
+	{
+		const FVector2D* UnitCircle = GetUnitCircle();
+		FVector LastVertex = Center + X * Radius;
+		for(int32 Step = 1; Step <= NumSteps; ++Step)
+		{
+			const FVector Vertex = Center + (X * UnitCircle[Step].X + Y * UnitCircle[Step].Y) * Radius;
+			Writer.Add(LastVertex, Vertex);
+			LastVertex = Vertex;
+		}
+	}
+
+	static void AppendBox(const FLineWriter& Writer, const FVector& Center, const FVector& Extent, const FQuat& Rotation)
+	{
+		auto Corner = [&](double X, double Y, double Z)
+		{
+			return Center + Rotation.RotateVector(FVector(X, Y, Z));
+		};
+
+		for(const double Z : { Extent.Z, -Extent.Z })
+		{
+			Writer.Add(Corner(Extent.X, Extent.Y, Z), Corner(Extent.X, -Extent.Y, Z));
+			Writer.Add(Corner(Extent.X, -Extent.Y, Z), Corner(-Extent.X, -Extent.Y, Z));
+			Writer.Add(Corner(-Extent.X, -Extent.Y, Z), Corner(-Extent.X, Extent.Y, Z));
+			Writer.Add(Corner(-Extent.X, Extent.Y, Z), Corner(Extent.X, Extent.Y, Z));
+		}
+
+		Writer.Add(Corner(Extent.X, Extent.Y, Extent.Z), Corner(Extent.X, Extent.Y, -Extent.Z));
+		Writer.Add(Corner(Extent.X, -Extent.Y, Extent.Z), Corner(Extent.X, -Extent.Y, -Extent.Z));
+		Writer.Add(Corner(-Extent.X, -Extent.Y, Extent.Z), Corner(-Extent.X, -Extent.Y, -Extent.Z));
+		Writer.Add(Corner(-Extent.X, Extent.Y, Extent.Z), Corner(-Extent.X, Extent.Y, -Extent.Z));
+	}
+
+	static void AppendShapeLines(const FOmniDebugCircle& Shape, const FLineWriter& Writer)
+	{
+		AppendArc(Writer, Shape.Center, Shape.Rotation.GetAxisY(), Shape.Rotation.GetAxisZ(), Shape.Radius, NumRoundSegments);
+	}
+
+	static void AppendShapeLines(const FOmniDebugLine& Shape, const FLineWriter& Writer)
+	{
+		Writer.Add(Shape.Start, Shape.End);
+	}
+
+	static void AppendShapeLines(const FOmniDebugBox& Shape, const FLineWriter& Writer)
+	{
+		AppendBox(Writer, Shape.Center, Shape.Extent, FQuat::Identity);
+	}
+
+	static void AppendShapeLines(const FOmniDebugRotatedBox& Shape, const FLineWriter& Writer)
+	{
+		AppendBox(Writer, Shape.Center, Shape.Extent, Shape.Rotation);
+	}
+
+	/**Every sphere has the same lines, only scaled and moved.
+	 * Built once as pairs of line start and end points on a unit sphere.*/
+	static const TArray<FVector>& GetUnitSphereLines()
+	{
+		static const TArray<FVector> UnitSphereLines = []()
+		{
+			//Rings of latitude, each connected to the next one
+			const FVector2D* UnitCircle = GetUnitCircle();
+			TArray<FVector> Points;
+			Points.Reserve(NumRoundSegments * NumRoundSegments * 4);
+			for(int32 Latitude = 0; Latitude < NumRoundSegments; ++Latitude)
 			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugSphere(GetWorld(), Command.Location, Command.Radius, 16, Command.Color.ToFColor(true),
-						false, 0, Command.DepthPriority, Command.Thickness);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::SphereLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Command.Location, Command.Radius, Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
+				const double SinY1 = UnitCircle[Latitude].Y;
+				const double CosY1 = UnitCircle[Latitude].X;
+				const double SinY2 = UnitCircle[Latitude + 1].Y;
+				const double CosY2 = UnitCircle[Latitude + 1].X;
+
+				FVector Vertex1 = FVector(SinY1, 0, CosY1);
+				FVector Vertex3 = FVector(SinY2, 0, CosY2);
+				for(int32 Longitude = 1; Longitude <= NumRoundSegments; ++Longitude)
 				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogSphere: '%s' - Center: (%s) | Radius: %f"), *Command.Text, *Command.Location.ToString(), Command.Radius);
+					const double SinX = UnitCircle[Longitude].Y;
+					const double CosX = UnitCircle[Longitude].X;
+					const FVector Vertex2 = FVector(CosX * SinY1, SinX * SinY1, CosY1);
+					const FVector Vertex4 = FVector(CosX * SinY2, SinX * SinY2, CosY2);
+					Points.Append({ Vertex1, Vertex2, Vertex1, Vertex3 });
+					Vertex1 = Vertex2;
+					Vertex3 = Vertex4;
 				}
-				break;
 			}
-			
-		case Capsule:
+			return Points;
+		}();
+		return UnitSphereLines;
+	}
+
+	static void AppendShapeLines(const FOmniDebugSphere& Shape, const FLineWriter& Writer)
+	{
+		const TArray<FVector>& UnitSphereLines = GetUnitSphereLines();
+		for(int32 PointIndex = 0; PointIndex + 1 < UnitSphereLines.Num(); PointIndex += 2)
+		{
+			Writer.Add(UnitSphereLines[PointIndex] * Shape.Radius + Shape.Center, UnitSphereLines[PointIndex + 1] * Shape.Radius + Shape.Center);
+		}
+	}
+
+	/**Circles, spheres and single lines are built straight from the shared unit circle and sphere,
+	 * which is about as cheap as copying cached lines. Caching them would only cost memory.*/
+	template<typename ShapeType>
+	static constexpr bool ShouldCacheLines()
+	{
+		return !std::is_same_v<ShapeType, FOmniDebugCircle>
+			&& !std::is_same_v<ShapeType, FOmniDebugSphere>
+			&& !std::is_same_v<ShapeType, FOmniDebugLine>;
+	}
+
+	/**Shapes that are gone within a few frames are tessellated every frame instead,
+	 * their cached lines would barely be reused before they are thrown away.*/
+	static constexpr int32 MinCachedFrames = 4;
+
+	static void AppendShapeLines(const FOmniDebugCapsule& Shape, const FLineWriter& Writer)
+	{
+		const FVector Center = FVector(Shape.Base.X, Shape.Base.Y, Shape.Base.Z + Shape.HalfHeight);
+		const FVector XAxis = Shape.Rotation.GetAxisX();
+		const FVector YAxis = Shape.Rotation.GetAxisY();
+		const FVector ZAxis = Shape.Rotation.GetAxisZ();
+
+		const float HalfAxis = FMath::Max(Shape.HalfHeight - Shape.Radius, 1.f);
+		const FVector TopEnd = Center + HalfAxis * ZAxis;
+		const FVector BottomEnd = Center - HalfAxis * ZAxis;
+
+		AppendArc(Writer, TopEnd, XAxis, YAxis, Shape.Radius, NumRoundSegments);
+		AppendArc(Writer, BottomEnd, XAxis, YAxis, Shape.Radius, NumRoundSegments);
+
+		AppendArc(Writer, TopEnd, YAxis, ZAxis, Shape.Radius, NumRoundSegments / 2);
+		AppendArc(Writer, TopEnd, XAxis, ZAxis, Shape.Radius, NumRoundSegments / 2);
+		AppendArc(Writer, BottomEnd, YAxis, -ZAxis, Shape.Radius, NumRoundSegments / 2);
+		AppendArc(Writer, BottomEnd, XAxis, -ZAxis, Shape.Radius, NumRoundSegments / 2);
+
+		Writer.Add(TopEnd + Shape.Radius * XAxis, BottomEnd + Shape.Radius * XAxis);
+		Writer.Add(TopEnd - Shape.Radius * XAxis, BottomEnd - Shape.Radius * XAxis);
+		Writer.Add(TopEnd + Shape.Radius * YAxis, BottomEnd + Shape.Radius * YAxis);
+		Writer.Add(TopEnd - Shape.Radius * YAxis, BottomEnd - Shape.Radius * YAxis);
+	}
+
+	static void AppendShapeLines(const FOmniDebugArrow& Shape, const FLineWriter& Writer)
+	{
+		const FVector Direction = (Shape.End - Shape.Start).GetSafeNormal();
+		FVector Up(0, 0, 1);
+		FVector Right = Direction ^ Up;
+		if(!Right.IsNormalized())
+		{
+			Direction.FindBestAxisVectors(Up, Right);
+		}
+
+		const float ArrowSqrt = FMath::Sqrt(Shape.ArrowSize);
+		Writer.Add(Shape.Start, Shape.End);
+		Writer.Add(Shape.End, Shape.End - Direction * ArrowSqrt + Right * ArrowSqrt);
+		Writer.Add(Shape.End, Shape.End - Direction * ArrowSqrt - Right * ArrowSqrt);
+	}
+
+	static void AppendShapeLines(const FOmniDebugCone& Shape, const FLineWriter& Writer)
+	{
+		const float Angle1 = FMath::Clamp<float>(FMath::DegreesToRadians(Shape.AngleHeight), UE_KINDA_SMALL_NUMBER, UE_PI - UE_KINDA_SMALL_NUMBER);
+		const float Angle2 = FMath::Clamp<float>(FMath::DegreesToRadians(Shape.AngleWidth), UE_KINDA_SMALL_NUMBER, UE_PI - UE_KINDA_SMALL_NUMBER);
+		const float SinX_2 = FMath::Sin(0.5f * Angle1);
+		const float SinY_2 = FMath::Sin(0.5f * Angle2);
+		const float SinSqX_2 = SinX_2 * SinX_2;
+		const float SinSqY_2 = SinY_2 * SinY_2;
+
+		FVector YAxis, ZAxis;
+		const FVector DirectionNorm = Shape.Direction.GetSafeNormal();
+		DirectionNorm.FindBestAxisVectors(YAxis, ZAxis);
+
+		const FVector2D* UnitCircle = GetUnitCircle();
+		FVector FirstPoint, PreviousPoint;
+		for(int32 Side = 0; Side < NumRoundSegments; ++Side)
+		{
+			//Elliptical cone, the same way DrawDebugCone builds it
+			const float Phi = FMath::Atan2(UnitCircle[Side].Y * SinY_2, UnitCircle[Side].X * SinX_2);
+			float SinPhi, CosPhi;
+			FMath::SinCos(&SinPhi, &CosPhi, Phi);
+			const float RSq = SinSqX_2 * SinSqY_2 / (SinSqX_2 * SinPhi * SinPhi + SinSqY_2 * CosPhi * CosPhi);
+			const float R = FMath::Sqrt(RSq);
+			const float Sqr = FMath::Sqrt(1 - RSq);
+			const FVector LocalPoint(1 - 2 * RSq, 2 * Sqr * R * CosPhi, 2 * Sqr * R * SinPhi);
+
+			const FVector Point = Shape.Origin + (DirectionNorm * LocalPoint.X + YAxis * LocalPoint.Y + ZAxis * LocalPoint.Z) * Shape.Length;
+			Writer.Add(Shape.Origin, Point);
+			if(Side > 0)
 			{
-				if(DrawDebugShapes)
-				{
-					/**We have to offset the center, because Vislog capsule does not use the center. And I think this is far more useful*/
-					DrawDebugCapsule(GetWorld(), FVector(Command.Location.X, Command.Location.Y, Command.Location.Z + Command.HalfHeight), Command.HalfHeight, Command.Radius, Command.Rotation, Command.Color.ToFColor(true),
-						false, 0, 0, Command.Thickness);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::CapsuleLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Command.Location, Command.HalfHeight, Command.Radius, Command.Rotation, Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogCapsule: '%s' - Base: (%s) | HalfHeight: %f | Radius: %f | Rotation: (%s)"), *Command.Text, *Command.Location.ToString(), Command.HalfHeight, Command.Radius, *Command.Rotation.ToString());
-				}
-				break;
+				Writer.Add(PreviousPoint, Point);
 			}
-			
-		case Arrow:
+			else
 			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugDirectionalArrow(GetWorld(), Command.Location, Command.End, Command.ArrowSize, Command.Color.ToFColor(true), false, 0, Command.DepthPriority, Command.Thickness);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::ArrowLineLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log,
-					Command.Location, Command.End, Command.Color.ToFColor(true), Command.ArrowSize, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogText: '%s'"), *Command.Text);
-				}
-				break;
+				FirstPoint = Point;
 			}
-			
-		case Text:
+			PreviousPoint = Point;
+		}
+		Writer.Add(PreviousPoint, FirstPoint);
+	}
+
+	static void AppendShapeLines(const FOmniDebugPolyline& Shape, const FLineWriter& Writer)
+	{
+		for(int32 PointIndex = 0; PointIndex + 1 < Shape.Points.Num(); ++PointIndex)
+		{
+			Writer.Add(Shape.Points[PointIndex], Shape.Points[PointIndex + 1]);
+		}
+	}
+}
+
+template<typename FunctorType>
+void UOmniDebugDrawSubsystem::VisitPool(EOmniDebugDrawType Type, FunctorType&& Functor)
+{
+	switch(Type) {
+	case Circle: Functor(Circles); break;
+	case Line: Functor(Lines); break;
+	case Box: Functor(Boxes); break;
+	case RotatedBox: Functor(RotatedBoxes); break;
+	case Sphere: Functor(Spheres); break;
+	case Capsule: Functor(Capsules); break;
+	case Arrow: Functor(Arrows); break;
+	case Text: Functor(Texts); break;
+	case Cone: Functor(Cones); break;
+	case Polyline: Functor(Polylines); break;
+	}
+}
+
+template<typename ShapeType>
+void UOmniDebugDrawSubsystem::AddToPool(TOmniDebugShapePool<ShapeType>& Pool, ShapeType&& Shape, FOmniDebugDrawCommand& Command, int32 SlotIndex)
+{
+	FOmniDebugShapeStyle Style;
+	Style.Color = Command.Color.ToFColor(true);
+	Style.DepthPriority = Command.DepthPriority;
+	Style.Thickness = Command.Thickness;
+
+	FOmniDebugShapeLog Log;
+	Log.Owner = Command.Owner;
+	Log.LogCategory = Command.LogCategory;
+	Log.Text = MoveTemp(Command.Text);
+	Log.AddMessageToLog = Command.AddMessageToLog;
+	Log.Wireframe = Command.Wireframe;
+
+	const uint32 ContentHash = OmniDebugDraw::GetContentHash(Shape, Style, Log);
+
+	FOmniDebugShapeSlot& Slot = ShapeSlots[SlotIndex];
+	if(Slot.Index != INDEX_NONE)
+	{
+		if(Slot.Type == ShapeType::Type)
+		{
+			Pool.Set(Slot.Index, MoveTemp(Shape), Style, MoveTemp(Log), Command.Lifetime, ContentHash);
+			return;
+		}
+
+		//The slot is getting a different type of shape
+		VisitPool(Slot.Type, [&](auto& OldPool)
+		{
+			RemoveFromPool(OldPool, Slot.Index, false);
+		});
+	}
+
+	Slot.Type = ShapeType::Type;
+	Slot.Index = Pool.Add(MoveTemp(Shape), Style, MoveTemp(Log), Command.Lifetime, SlotIndex, ContentHash);
+}
+
+template<typename ShapeType>
+void UOmniDebugDrawSubsystem::RemoveFromPool(TOmniDebugShapePool<ShapeType>& Pool, int32 Index, bool bReleaseSlot)
+{
+	const int32 SlotIndex = Pool.SlotIndices[Index];
+
+	Pool.RemoveAtSwap(Index);
+
+	//The last shape has been moved into the removed shapes place
+	if(Pool.SlotIndices.IsValidIndex(Index))
+	{
+		ShapeSlots[Pool.SlotIndices[Index]].Index = Index;
+	}
+
+	FOmniDebugShapeSlot& Slot = ShapeSlots[SlotIndex];
+	Slot.Index = INDEX_NONE;
+	if(bReleaseSlot)
+	{
+		if(!Slot.Key.IsNone())
+		{
+			KeyedShapes.Remove(Slot.Key);
+			Slot.Key = NAME_None;
+		}
+
+		//Invalidates every handle to the old shape. 0 is skipped, since that's what an unset handle has
+		if(++Slot.Generation == 0)
+		{
+			Slot.Generation = 1;
+		}
+		FreeShapeSlots.Add(SlotIndex);
+	}
+}
+
+int32 UOmniDebugDrawSubsystem::AllocateSlot()
+{
+	if(!FreeShapeSlots.IsEmpty())
+	{
+		return FreeShapeSlots.Pop(EAllowShrinking::No);
+	}
+
+	return ShapeSlots.AddDefaulted();
+}
+
+const FOmniDebugShapeSlot* UOmniDebugDrawSubsystem::FindSlot(FOmniDebugShapeHandle Handle) const
+{
+	if(!ShapeSlots.IsValidIndex(Handle.SlotIndex))
+	{
+		return nullptr;
+	}
+
+	const FOmniDebugShapeSlot& Slot = ShapeSlots[Handle.SlotIndex];
+	return Slot.Generation == Handle.Generation && Slot.Index != INDEX_NONE ? &Slot : nullptr;
+}
+
+FOmniDebugShapeHandle UOmniDebugDrawSubsystem::MakeHandle(int32 SlotIndex) const
+{
+	FOmniDebugShapeHandle Handle;
+	Handle.SlotIndex = SlotIndex;
+	Handle.Generation = ShapeSlots[SlotIndex].Generation;
+	return Handle;
+}
+
+template<typename ShapeType>
+void UOmniDebugDrawSubsystem::TickPool(TOmniDebugShapePool<ShapeType>& Pool, float DeltaTime, const FOmniDebugDrawFrame& Frame)
+{
+	if(Pool.Num() == 0)
+	{
+		return;
+	}
+
+	//Text can't be turned into lines
+	constexpr bool bCanBatch = !std::is_same_v<ShapeType, FOmniDebugText>;
+	if constexpr(bCanBatch)
+	{
+		if(Frame.bDraw && Frame.bBatchLines)
+		{
+			const float MinCachedLifetime = DeltaTime * OmniDebugDraw::MinCachedFrames;
+			for(int32 Index = 0; Index < Pool.Num(); ++Index)
 			{
-				if(DrawDebugShapes)
+				const FOmniDebugShapeStyle& Style = Pool.Styles[Index];
+				const bool bForeground = Style.DepthPriority == SDPG_Foreground;
+				TArray<FBatchedLine>& FrameLines = bForeground ? ForegroundLines : WorldLines;
+				TArray<FBatchedLine>& CachedLines = Pool.CachedLines[Index];
+				if(!CachedLines.IsEmpty())
 				{
-					DrawDebugString(GetWorld(), Command.Location, Command.Text, nullptr, Command.Color.ToFColor(true), 0, false, Command.Thickness);
+					FrameLines.Append(CachedLines);
+					continue;
 				}
-				#if ENABLE_VISUAL_LOG
-				/**There is no "Log text" in a way that draws text in the world like we have for the other shapes.
-				 * Fake it by making a sphere with 0 radius. This lets us hijack the text system that comes with
-				 * other shapes */
-				FVisualLogger::SphereLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Command.Location, 0, Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-				/**Majority of the time when you log text, you also want it to appear in the log section*/
-				FVisualLogger::CategorizedLogf(Command.Owner.Get(), Command.LogCategory, DefaultVerbosity
-					, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
+
+				const bool bCache = OmniDebugDraw::ShouldCacheLines<ShapeType>()
+					&& Pool.Lifetimes[Index] >= MinCachedLifetime && CachedLineBudget > 0;
+				const int32 FirstLine = FrameLines.Num();
+				const OmniDebugDraw::FLineWriter Writer { FrameLines, FLinearColor(Style.Color),
+					bForeground ? Frame.ForegroundLineLifetime : Frame.WorldLineLifetime, Style.Thickness, Style.DepthPriority };
+				OmniDebugDraw::AppendShapeLines(Pool.Shapes[Index], Writer);
+
+				const int32 NumLines = FrameLines.Num() - FirstLine;
+				if(bCache && NumLines <= CachedLineBudget)
 				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogText: '%s'"), *Command.Text);
+					CachedLines.Append(FrameLines.GetData() + FirstLine, NumLines);
+					Pool.NumCachedLines += NumLines;
+					CachedLineBudget -= NumLines;
 				}
-				break;
 			}
-			
-		case Cone:
+		}
+	}
+
+	if(Frame.bDraw && (!bCanBatch || !Frame.bBatchLines))
+	{
+		UWorld* World = GetWorld();
+		for(int32 Index = 0; Index < Pool.Num(); ++Index)
+		{
+			OmniDebugDraw::DrawShape(World, Pool.Shapes[Index], Pool.Styles[Index], Pool.Logs[Index]);
+		}
+	}
+
+	for(int32 Index = 0; Index < Pool.Num(); ++Index)
+	{
+		const FOmniDebugShapeLog& Log = Pool.Logs[Index];
+		if(Frame.bIsVislogRecording)
+		{
+			Pool.TimeSinceLogged[Index] += DeltaTime;
+			const bool bShouldLog = Frame.bLogAllShapes
+				|| Pool.ContentHashes[Index] != Pool.LoggedHashes[Index]
+				|| (Frame.VislogKeyframeInterval > 0 && Pool.TimeSinceLogged[Index] >= Frame.VislogKeyframeInterval);
+			//A suppressed category keeps its pending changes until its next sample
+			if(bShouldLog && (SuppressedVislogCategories.IsEmpty() || !SuppressedVislogCategories.Contains(Log.LogCategory)))
 			{
-				if(DrawDebugShapes)
-				{
-					DrawDebugCone(GetWorld(), Command.Location, Command.Direction, Command.Length, FMath::DegreesToRadians(Command.AngleWidth), FMath::DegreesToRadians(Command.AngleHeight), 
-					16, Command.Color.ToFColor(true), false, 0, Command.DepthPriority, Command.Thickness);
-				}
-				#if ENABLE_VISUAL_LOG
-				FVisualLogger::ConeLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-					, Command.Location, Command.Direction, Command.Length, Command.AngleHeight, Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-				#endif
-				if(Command.AddMessageToLog)
-				{
-					VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogCone: '%s' - Origin: (%s) | Direction: (%s) | Length: %f | Angle: %f"), *Command.Text, *Command.Location.ToString(), *Command.Direction.ToString(), Command.Length, Command.AngleHeight);
-				}
-				
-				break;
+				OmniDebugDraw::LogShape(Pool.Shapes[Index], Pool.Styles[Index], Log);
+				Pool.LoggedHashes[Index] = Pool.ContentHashes[Index];
+				Pool.TimeSinceLogged[Index] = 0;
 			}
-		case RotatedBox:
-			if(DrawDebugShapes)
+		}
+		if(Log.AddMessageToLog)
+		{
+			OmniDebugDraw::AddShapeToMessageLog(Pool.Shapes[Index], Log);
+		}
+	}
+
+	//Walk backwards, so the shape that gets swapped in has already been updated
+	for(int32 Index = Pool.Num() - 1; Index >= 0; --Index)
+	{
+		Pool.Lifetimes[Index] -= DeltaTime;
+		if(Pool.Lifetimes[Index] <= 0.0f)
+		{
+			RemoveFromPool(Pool, Index);
+		}
+	}
+}
+
+FOmniDebugShapeHandle UOmniDebugDrawSubsystem::AddShape(FOmniDebugDrawCommand Command, FName Key)
+{
+	int32 SlotIndex;
+	if(const int32* ExistingSlot = Key.IsNone() ? nullptr : KeyedShapes.Find(Key))
+	{
+		SlotIndex = *ExistingSlot;
+	}
+	else
+	{
+		SlotIndex = AllocateSlot();
+		if(!Key.IsNone())
+		{
+			ShapeSlots[SlotIndex].Key = Key;
+			KeyedShapes.Add(Key, SlotIndex);
+		}
+	}
+
+	SetShape(SlotIndex, Command);
+	return MakeHandle(SlotIndex);
+}
+
+void UOmniDebugDrawSubsystem::SetShape(int32 SlotIndex, FOmniDebugDrawCommand& Command)
+{
+	switch(Command.Type) {
+	case Circle:
+		AddToPool(Circles, FOmniDebugCircle{ Command.Location, Command.Rotation, Command.Radius }, Command, SlotIndex);
+		break;
+	case Line:
+		AddToPool(Lines, FOmniDebugLine{ Command.Location, Command.End }, Command, SlotIndex);
+		break;
+	case Box:
+		AddToPool(Boxes, FOmniDebugBox{ Command.Location, Command.Extent }, Command, SlotIndex);
+		break;
+	case RotatedBox:
+		AddToPool(RotatedBoxes, FOmniDebugRotatedBox{ Command.Location, Command.Extent, Command.Rotation }, Command, SlotIndex);
+		break;
+	case Sphere:
+		AddToPool(Spheres, FOmniDebugSphere{ Command.Location, Command.Radius }, Command, SlotIndex);
+		break;
+	case Capsule:
+		//Capsules have always been drawn in the world depth group
+		Command.DepthPriority = SDPG_World;
+		AddToPool(Capsules, FOmniDebugCapsule{ Command.Location, Command.Rotation, Command.HalfHeight, Command.Radius }, Command, SlotIndex);
+		break;
+	case Arrow:
+		AddToPool(Arrows, FOmniDebugArrow{ Command.Location, Command.End, Command.ArrowSize }, Command, SlotIndex);
+		break;
+	case Text:
+		AddToPool(Texts, FOmniDebugText{ Command.Location }, Command, SlotIndex);
+		break;
+	case Cone:
+		AddToPool(Cones, FOmniDebugCone{ Command.Location, Command.Direction, Command.Length, Command.AngleWidth, Command.AngleHeight }, Command, SlotIndex);
+		break;
+	case Polyline:
+		AddToPool(Polylines, FOmniDebugPolyline{ MoveTemp(Command.Points) }, Command, SlotIndex);
+		break;
+	}
+}
+
+void UOmniDebugDrawSubsystem::QueueShape(FOmniDebugDrawCommand&& Command, FName Key)
+{
+	QueuedShapes.Enqueue({ MoveTemp(Command), Key });
+}
+
+bool UOmniDebugDrawSubsystem::QueueShapeForWorld(const UWorld* World, FOmniDebugDrawCommand&& Command, FName Key)
+{
+	FReadScopeLock ReadLock(OmniDebugDraw::WorldSubsystemsLock);
+	UOmniDebugDrawSubsystem* const* DrawSubsystem = OmniDebugDraw::WorldSubsystems.Find(World);
+	if(!DrawSubsystem)
+	{
+		return false;
+	}
+
+	(*DrawSubsystem)->QueueShape(MoveTemp(Command), Key);
+	return true;
+}
+
+void UOmniDebugDrawSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FWriteScopeLock WriteLock(OmniDebugDraw::WorldSubsystemsLock);
+	OmniDebugDraw::WorldSubsystems.Add(GetWorld(), this);
+}
+
+void UOmniDebugDrawSubsystem::Deinitialize()
+{
+	{
+		FWriteScopeLock WriteLock(OmniDebugDraw::WorldSubsystemsLock);
+		OmniDebugDraw::WorldSubsystems.Remove(GetWorld());
+	}
+
+	Super::Deinitialize();
+}
+
+void UOmniDebugDrawSubsystem::DrainQueuedShapes()
+{
+	FOmniQueuedDebugDraw QueuedShape;
+	while(QueuedShapes.Dequeue(QueuedShape))
+	{
+		AddShape(MoveTemp(QueuedShape.Command), QueuedShape.Key);
+	}
+}
+
+int32 UOmniDebugDrawSubsystem::GetNumShapes() const
+{
+	return Circles.Num() + Lines.Num() + Boxes.Num() + RotatedBoxes.Num() + Spheres.Num()
+		+ Capsules.Num() + Arrows.Num() + Texts.Num() + Cones.Num() + Polylines.Num();
+}
+
+bool UOmniDebugDrawSubsystem::IsShapeValid(FOmniDebugShapeHandle Handle) const
+{
+	return FindSlot(Handle) != nullptr;
+}
+
+FOmniDebugShapeHandle UOmniDebugDrawSubsystem::FindShape(FName Key) const
+{
+	const int32* SlotIndex = KeyedShapes.Find(Key);
+	return SlotIndex ? MakeHandle(*SlotIndex) : FOmniDebugShapeHandle();
+}
+
+bool UOmniDebugDrawSubsystem::UpdateShape(FOmniDebugShapeHandle Handle, FOmniDebugDrawCommand Command)
+{
+	if(!FindSlot(Handle))
+	{
+		return false;
+	}
+
+	SetShape(Handle.SlotIndex, Command);
+	return true;
+}
+
+bool UOmniDebugDrawSubsystem::MoveShape(FOmniDebugShapeHandle Handle, const FVector& Location)
+{
+	const FOmniDebugShapeSlot* Slot = FindSlot(Handle);
+	if(!Slot)
+	{
+		return false;
+	}
+
+	const int32 Index = Slot->Index;
+	VisitPool(Slot->Type, [&](auto& Pool)
+	{
+		auto& Shape = Pool.Shapes[Index];
+		const FVector Delta = Location - OmniDebugDraw::GetShapeLocation(Shape);
+		OmniDebugDraw::TranslateShape(Shape, Delta);
+
+		//Move the cached lines along, instead of tessellating the shape again
+		for(FBatchedLine& CachedLine : Pool.CachedLines[Index])
+		{
+			CachedLine.Start += Delta;
+			CachedLine.End += Delta;
+		}
+		Pool.ContentHashes[Index] = OmniDebugDraw::GetContentHash(Shape, Pool.Styles[Index], Pool.Logs[Index]);
+	});
+	return true;
+}
+
+bool UOmniDebugDrawSubsystem::RecolorShape(FOmniDebugShapeHandle Handle, const FLinearColor& Color)
+{
+	const FOmniDebugShapeSlot* Slot = FindSlot(Handle);
+	if(!Slot)
+	{
+		return false;
+	}
+
+	const int32 Index = Slot->Index;
+	VisitPool(Slot->Type, [&](auto& Pool)
+	{
+		FOmniDebugShapeStyle& Style = Pool.Styles[Index];
+		Style.Color = Color.ToFColor(true);
+
+		const FLinearColor LineColor(Style.Color);
+		for(FBatchedLine& CachedLine : Pool.CachedLines[Index])
+		{
+			CachedLine.Color = LineColor;
+		}
+		Pool.ContentHashes[Index] = OmniDebugDraw::GetContentHash(Pool.Shapes[Index], Style, Pool.Logs[Index]);
+	});
+	return true;
+}
+
+bool UOmniDebugDrawSubsystem::ExtendShapeLifetime(FOmniDebugShapeHandle Handle, float Seconds)
+{
+	const FOmniDebugShapeSlot* Slot = FindSlot(Handle);
+	if(!Slot)
+	{
+		return false;
+	}
+
+	const int32 Index = Slot->Index;
+	VisitPool(Slot->Type, [&](auto& Pool)
+	{
+		Pool.Lifetimes[Index] += Seconds;
+	});
+	return true;
+}
+
+bool UOmniDebugDrawSubsystem::RemoveShape(FOmniDebugShapeHandle Handle)
+{
+	const FOmniDebugShapeSlot* Slot = FindSlot(Handle);
+	if(!Slot)
+	{
+		return false;
+	}
+
+	const int32 Index = Slot->Index;
+	VisitPool(Slot->Type, [&](auto& Pool)
+	{
+		RemoveFromPool(Pool, Index);
+	});
+	return true;
+}
+
+void UOmniDebugDrawSubsystem::Tick(float DeltaTime)
+{
+	Omni_InsightsTrace()
+
+	DrainQueuedShapes();
+
+	UWorld* World = GetWorld();
+	ULineBatchComponent* WorldLineBatcher = World->GetLineBatcher(UWorld::ELineBatcherType::World);
+	ULineBatchComponent* ForegroundLineBatcher = World->GetLineBatcher(UWorld::ELineBatcherType::Foreground);
+
+	FOmniDebugDrawFrame Frame;
+	Frame.bDraw = DrawDebugShapes;
+	//Same conditions the DrawDebug* helpers use before they touch the line batchers
+	Frame.bBatchLines = ENABLE_DRAW_DEBUG && BatchDebugShapes && WorldLineBatcher && ForegroundLineBatcher
+		&& World->GetNetMode() != NM_DedicatedServer;
+	if(Frame.bBatchLines)
+	{
+		Frame.WorldLineLifetime = WorldLineBatcher->DefaultLifeTime;
+		Frame.ForegroundLineLifetime = ForegroundLineBatcher->DefaultLifeTime;
+	}
+
+	//Checked once, instead of letting every shape find out the visual logger isn't recording
+	#if ENABLE_VISUAL_LOG
+	Frame.bIsVislogRecording = FVisualLogger::IsRecording();
+	#endif
+	//Everything is logged on the first frame of a recording, otherwise unchanged shapes would be missing from it
+	Frame.bLogAllShapes = !VislogChangesOnly || (Frame.bIsVislogRecording && !bWasVislogRecording);
+	Frame.VislogKeyframeInterval = VislogKeyframeInterval;
+	bWasVislogRecording = Frame.bIsVislogRecording;
+
+	SuppressedVislogCategories.Reset();
+	if(Frame.bIsVislogRecording)
+	{
+		const double Now = World->GetTimeSeconds();
+		for(const TPair<FName, float>& Rate : VislogCategoryRates)
+		{
+			double& NextSampleTime = NextVislogCategorySampleTimes.FindOrAdd(Rate.Key, 0);
+			if(Now < NextSampleTime)
 			{
-				DrawDebugBox(GetWorld(), Command.Location, Command.Extent, Command.Rotation, Command.Color.ToFColor(true),
-					false, 0, Command.DepthPriority, Command.Thickness);
+				SuppressedVislogCategories.Add(Rate.Key);
 			}
-			FBox Box = FBox(Command.Location - Command.Extent, Command.Location + Command.Extent);
-			#if ENABLE_VISUAL_LOG
-			FVisualLogger::BoxLogf(Command.Owner.Get(), Command.LogCategory, ELogVerbosity::Log
-				, Box, Command.Rotation.ToMatrix(), 
-				Command.Color.ToFColor(true), Command.Wireframe, TEXT("%s"), *Command.Text);
-			#endif
-			if(Command.AddMessageToLog)
+			else
 			{
-				VLOG_BP_LIBRARY_ADD_TO_LOG(Command.LogCategory, TEXT("LogBox: '%s' - BoxMin: (%s) | BoxMax: (%s)"), *Command.Text, *Box.Min.ToString(), *Box.Max.ToString());
+				NextSampleTime = Now + 1.0 / Rate.Value;
 			}
-			break;
-		}
-		
-		Command.Lifetime -= DeltaTime;
-		if(Command.Lifetime <= 0.0f)
-		{
-			ShapesToRemove.Add(CurrentCommand.Key);
 		}
 	}
-	
-	for(auto& ShapeToRemove : ShapesToRemove)
+
+	WorldLines.Reset();
+	ForegroundLines.Reset();
+
+	const int32 NumCachedLines = Circles.NumCachedLines + Lines.NumCachedLines + Boxes.NumCachedLines
+		+ RotatedBoxes.NumCachedLines + Spheres.NumCachedLines + Capsules.NumCachedLines + Arrows.NumCachedLines
+		+ Texts.NumCachedLines + Cones.NumCachedLines + Polylines.NumCachedLines;
+	CachedLineBudget = MaxCachedDebugLines - NumCachedLines;
+
+	TickPool(Circles, DeltaTime, Frame);
+	TickPool(Lines, DeltaTime, Frame);
+	TickPool(Boxes, DeltaTime, Frame);
+	TickPool(RotatedBoxes, DeltaTime, Frame);
+	TickPool(Spheres, DeltaTime, Frame);
+	TickPool(Capsules, DeltaTime, Frame);
+	TickPool(Arrows, DeltaTime, Frame);
+	TickPool(Texts, DeltaTime, Frame);
+	TickPool(Cones, DeltaTime, Frame);
+	TickPool(Polylines, DeltaTime, Frame);
+
+	if(!WorldLines.IsEmpty())
+	{
+		WorldLineBatcher->DrawLines(WorldLines);
+	}
+	if(!ForegroundLines.IsEmpty())
 	{
-		ShapesToDraw.Remove(ShapeToRemove);
+		ForegroundLineBatcher->DrawLines(ForegroundLines);
 	}
 }
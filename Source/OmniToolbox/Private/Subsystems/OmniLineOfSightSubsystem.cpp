@@ -0,0 +1,190 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniLineOfSightSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Line Of Sight Pairs Traced"), STAT_OmniLineOfSightTraced, STATGROUP_OmniTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Line Of Sight Pairs"), STAT_OmniLineOfSightPairs, STATGROUP_OmniTrace);
+
+FOmniLineOfSightHandle UOmniLineOfSightSubsystem::RegisterPair(AActor* Observer, AActor* Target,
+	const FOmniTraceQuery& Query, FVector ObserverOffset, FVector TargetOffset, float MoveThreshold, float Timeout)
+{
+	if(!Observer || !Target)
+	{
+		return FOmniLineOfSightHandle();
+	}
+
+	FOmniLineOfSightPair Pair;
+	Pair.Observer = Observer;
+	Pair.Target = Target;
+	Pair.ObserverOffset = ObserverOffset;
+	Pair.TargetOffset = TargetOffset;
+	Pair.MoveThresholdSquared = FMath::Square(FMath::Max(MoveThreshold, 0.f));
+	Pair.Timeout = Timeout;
+	Pair.Serial = NextSerial++;
+
+	Pair.Query = Query;
+	Pair.Query.IgnoredActors.AddUnique(Observer);
+	Pair.Query.Compile();
+
+	FOmniLineOfSightHandle Handle;
+	Handle.Serial = Pair.Serial;
+	Handle.Index = Pairs.Add(MoveTemp(Pair));
+
+	SET_DWORD_STAT(STAT_OmniLineOfSightPairs, Pairs.Num());
+	return Handle;
+}
+
+void UOmniLineOfSightSubsystem::UnregisterPair(FOmniLineOfSightHandle Handle)
+{
+	if(FindPair(Handle))
+	{
+		Pairs.RemoveAt(Handle.Index);
+		SET_DWORD_STAT(STAT_OmniLineOfSightPairs, Pairs.Num());
+	}
+}
+
+bool UOmniLineOfSightSubsystem::HasLineOfSight(FOmniLineOfSightHandle Handle) const
+{
+	const FOmniLineOfSightPair* Pair = FindPair(Handle);
+	return Pair && Pair->bHasLineOfSight;
+}
+
+bool UOmniLineOfSightSubsystem::IsPairValid(FOmniLineOfSightHandle Handle) const
+{
+	return FindPair(Handle) != nullptr;
+}
+
+void UOmniLineOfSightSubsystem::Tick(float DeltaTime)
+{
+	if(Pairs.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniLineOfSightSubsystem::Tick);
+
+	UWorld* World = GetWorld();
+	GatherDirtyPairs(World->GetTimeSeconds());
+
+	for(const int32 PairIndex : PairsToRemove)
+	{
+		Pairs.RemoveAt(PairIndex);
+	}
+	SET_DWORD_STAT(STAT_OmniLineOfSightPairs, Pairs.Num());
+
+	if(DirtyPairs.IsEmpty())
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_OmniLineOfSightTraced, DirtyPairs.Num());
+
+	DirtyResults.SetNumUninitialized(DirtyPairs.Num(), EAllowShrinking::No);
+	ParallelFor(TEXT("UOmniLineOfSightSubsystem::Tick"), DirtyPairs.Num(), 16, [&](int32 DirtyIndex)
+	{
+		const FOmniTraceQuery& Query = Pairs[DirtyPairs[DirtyIndex]].Query;
+
+		FHitResult HitResult;
+		const bool bHit = World->LineTraceSingleByChannel(HitResult, DirtyObserverLocations[DirtyIndex], DirtyTargetLocations[DirtyIndex],
+			Query.GetChannel(), Query.GetQueryParams(), Query.GetResponseParams());
+
+		DirtyResults[DirtyIndex] = !bHit || HitResult.GetActor() == DirtyTargets[DirtyIndex];
+	});
+
+	/**Apply every result before broadcasting, a listener
+	 * might register or unregister pairs while we're iterating.*/
+	TArray<FOmniLineOfSightHandle, TInlineAllocator<16>> ChangedPairs;
+	const double CurrentTime = World->GetTimeSeconds();
+	for(int32 DirtyIndex = 0; DirtyIndex < DirtyPairs.Num(); ++DirtyIndex)
+	{
+		const int32 PairIndex = DirtyPairs[DirtyIndex];
+		FOmniLineOfSightPair& Pair = Pairs[PairIndex];
+		Pair.LastObserverLocation = DirtyObserverLocations[DirtyIndex];
+		Pair.LastTargetLocation = DirtyTargetLocations[DirtyIndex];
+		Pair.LastTraceTime = CurrentTime;
+
+		const bool bHadLineOfSight = Pair.bHasLineOfSight;
+		const bool bWasTraced = Pair.bHasBeenTraced;
+		Pair.bHasLineOfSight = DirtyResults[DirtyIndex];
+		Pair.bHasBeenTraced = true;
+
+		if(Pair.bHasLineOfSight != bHadLineOfSight || (!bWasTraced && Pair.bHasLineOfSight))
+		{
+			FOmniLineOfSightHandle& Handle = ChangedPairs.AddDefaulted_GetRef();
+			Handle.Index = PairIndex;
+			Handle.Serial = Pair.Serial;
+		}
+	}
+
+	for(const FOmniLineOfSightHandle& Handle : ChangedPairs)
+	{
+		//Might have been removed by a previous listener
+		if(const FOmniLineOfSightPair* Pair = FindPair(Handle))
+		{
+			OnLineOfSightChanged.Broadcast(Handle, Pair->Observer.Get(), Pair->Target.Get(), Pair->bHasLineOfSight);
+		}
+	}
+}
+
+void UOmniLineOfSightSubsystem::Deinitialize()
+{
+	Pairs.Empty();
+	SET_DWORD_STAT(STAT_OmniLineOfSightPairs, 0);
+
+	Super::Deinitialize();
+}
+
+const FOmniLineOfSightPair* UOmniLineOfSightSubsystem::FindPair(FOmniLineOfSightHandle Handle) const
+{
+	if(!Handle.IsValid() || !Pairs.IsValidIndex(Handle.Index))
+	{
+		return nullptr;
+	}
+
+	const FOmniLineOfSightPair& Pair = Pairs[Handle.Index];
+	return Pair.Serial == Handle.Serial ? &Pair : nullptr;
+}
+
+void UOmniLineOfSightSubsystem::GatherDirtyPairs(double CurrentTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniLineOfSightSubsystem::GatherDirtyPairs);
+
+	DirtyPairs.Reset();
+	DirtyObserverLocations.Reset();
+	DirtyTargetLocations.Reset();
+	DirtyTargets.Reset();
+	PairsToRemove.Reset();
+
+	for(auto It = Pairs.CreateConstIterator(); It; ++It)
+	{
+		const FOmniLineOfSightPair& Pair = *It;
+		const AActor* Observer = Pair.Observer.Get();
+		const AActor* Target = Pair.Target.Get();
+		if(!Observer || !Target)
+		{
+			PairsToRemove.Add(It.GetIndex());
+			continue;
+		}
+
+		const FVector ObserverLocation = Observer->GetActorLocation() + Pair.ObserverOffset;
+		const FVector TargetLocation = Target->GetActorLocation() + Pair.TargetOffset;
+
+		const bool bIsDirty = !Pair.bHasBeenTraced
+			|| FVector::DistSquared(ObserverLocation, Pair.LastObserverLocation) > Pair.MoveThresholdSquared
+			|| FVector::DistSquared(TargetLocation, Pair.LastTargetLocation) > Pair.MoveThresholdSquared
+			|| (Pair.Timeout > 0 && CurrentTime - Pair.LastTraceTime >= Pair.Timeout);
+
+		if(bIsDirty)
+		{
+			DirtyPairs.Add(It.GetIndex());
+			DirtyObserverLocations.Add(ObserverLocation);
+			DirtyTargetLocations.Add(TargetLocation);
+			DirtyTargets.Add(Target);
+		}
+	}
+}
@@ -0,0 +1,315 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniStaticBVHSubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "OmniRuntimeMacros.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, EnableStaticBVH, false,
+	"OmniToolbox.Trace.StaticBVH",
+	"Build a static geometry BVH for game worlds, which traces can use instead of the physics scene. Only read when a world is created");
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Static BVH Items"), STAT_OmniStaticBVHItems, STATGROUP_OmniTrace);
+
+namespace OmniStaticBVHGather
+{
+	void AddTriangle(FOmniStaticBVHBuildInput& Input, int32 PrimitiveIndex, const FVector& A, const FVector& B, const FVector& C)
+	{
+		FOmniBVHItem& Item = Input.Items.AddDefaulted_GetRef();
+		Item.A = FVector3f(A);
+		Item.B = FVector3f(B);
+		Item.C = FVector3f(C);
+		Item.PrimitiveIndex = PrimitiveIndex;
+	}
+
+	void AddBox(FOmniStaticBVHBuildInput& Input, int32 PrimitiveIndex, const FBox& Box)
+	{
+		FOmniBVHItem& Item = Input.Items.AddDefaulted_GetRef();
+		Item.A = FVector3f(Box.Min);
+		Item.B = FVector3f(Box.Max);
+		Item.PrimitiveIndex = PrimitiveIndex;
+		Item.bIsBox = true;
+	}
+
+	/**Adds the simple collision of the body setup.
+	 * Returns false if there was nothing that could be added.*/
+	bool AddSimpleCollision(FOmniStaticBVHBuildInput& Input, int32 PrimitiveIndex, const UBodySetup& BodySetup,
+		const FTransform& ComponentTransform)
+	{
+		const FKAggregateGeom& AggGeom = BodySetup.AggGeom;
+		const int32 NumItemsBefore = Input.Items.Num();
+
+		for(const FKConvexElem& Convex : AggGeom.ConvexElems)
+		{
+			const FTransform ElemTransform = Convex.GetTransform() * ComponentTransform;
+			for(int32 Index = 0; Index + 2 < Convex.IndexData.Num(); Index += 3)
+			{
+				AddTriangle(Input, PrimitiveIndex,
+					ElemTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index]]),
+					ElemTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index + 1]]),
+					ElemTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index + 2]]));
+			}
+		}
+
+		for(const FKBoxElem& Box : AggGeom.BoxElems)
+		{
+			const FTransform ElemTransform = FTransform(Box.Rotation, Box.Center) * ComponentTransform;
+			const FVector HalfExtent(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+
+			FVector Corners[8];
+			for(int32 Corner = 0; Corner < 8; ++Corner)
+			{
+				Corners[Corner] = ElemTransform.TransformPosition(FVector(
+					Corner & 1 ? HalfExtent.X : -HalfExtent.X,
+					Corner & 2 ? HalfExtent.Y : -HalfExtent.Y,
+					Corner & 4 ? HalfExtent.Z : -HalfExtent.Z));
+			}
+
+			//Two triangles per face
+			static constexpr int32 Faces[6][4] = {{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+			for(const int32 (&Face)[4] : Faces)
+			{
+				AddTriangle(Input, PrimitiveIndex, Corners[Face[0]], Corners[Face[1]], Corners[Face[2]]);
+				AddTriangle(Input, PrimitiveIndex, Corners[Face[0]], Corners[Face[2]], Corners[Face[3]]);
+			}
+		}
+
+		//Round shapes fall back to their bounds
+		const double MaxScale = ComponentTransform.GetMaximumAxisScale();
+		for(const FKSphereElem& Sphere : AggGeom.SphereElems)
+		{
+			AddBox(Input, PrimitiveIndex, FBox::BuildAABB(ComponentTransform.TransformPosition(Sphere.Center), FVector(Sphere.Radius * MaxScale)));
+		}
+
+		for(const FKSphylElem& Sphyl : AggGeom.SphylElems)
+		{
+			const double Extent = (Sphyl.Radius + Sphyl.Length * 0.5) * MaxScale;
+			AddBox(Input, PrimitiveIndex, FBox::BuildAABB(ComponentTransform.TransformPosition(Sphyl.Center), FVector(Extent)));
+		}
+
+		return Input.Items.Num() > NumItemsBefore;
+	}
+}
+
+FOmniStaticBVHSnapshotPtr UOmniStaticBVHSubsystem::GetSnapshot() const
+{
+	FReadScopeLock ReadLock(SnapshotLock);
+	return Snapshot;
+}
+
+void UOmniStaticBVHSubsystem::RebuildLevel(ULevel* Level)
+{
+	if(!Level)
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniStaticBVHSubsystem::RebuildLevel);
+
+	FOmniStaticBVHBuildInput Input;
+	GatherLevel(Level, Input);
+
+	//A newer build replaces any build that is still running for the level
+	PendingBuilds.RemoveAll([Level](const FPendingBuild& Build)
+	{
+		return Build.Level == Level;
+	});
+
+	FPendingBuild& Build = PendingBuilds.AddDefaulted_GetRef();
+	Build.Level = Level;
+	Build.Task = UE::Tasks::Launch(TEXT("UOmniStaticBVHSubsystem::BuildLevel"), [Input = MoveTemp(Input)]() mutable
+	{
+		return TSharedRef<const FOmniStaticBVH, ESPMode::ThreadSafe>(MakeShared<FOmniStaticBVH, ESPMode::ThreadSafe>(MoveTemp(Input)));
+	});
+}
+
+void UOmniStaticBVHSubsystem::RebuildAllLevels()
+{
+	for(ULevel* Level : GetWorld()->GetLevels())
+	{
+		if(Level && Level->bIsVisible)
+		{
+			RebuildLevel(Level);
+		}
+	}
+}
+
+bool UOmniStaticBVHSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if(!EnableStaticBVH || !Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UOmniStaticBVHSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UOmniStaticBVHSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UOmniStaticBVHSubsystem::OnLevelRemoved);
+}
+
+void UOmniStaticBVHSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	RebuildAllLevels();
+}
+
+void UOmniStaticBVHSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	//The tasks only touch their own input, there's no need to wait for them
+	PendingBuilds.Empty();
+	LevelBVHs.Empty();
+
+	{
+		FWriteScopeLock WriteLock(SnapshotLock);
+		Snapshot.Reset();
+	}
+
+	SET_DWORD_STAT(STAT_OmniStaticBVHItems, 0);
+
+	Super::Deinitialize();
+}
+
+void UOmniStaticBVHSubsystem::Tick(float DeltaTime)
+{
+	if(PendingBuilds.IsEmpty())
+	{
+		return;
+	}
+
+	bool bAnyCompleted = false;
+	for(int32 Index = PendingBuilds.Num() - 1; Index >= 0; --Index)
+	{
+		FPendingBuild& Build = PendingBuilds[Index];
+		if(!Build.Task.IsCompleted())
+		{
+			continue;
+		}
+
+		if(Build.Level.IsValid())
+		{
+			LevelBVHs.Add(Build.Level, Build.Task.GetResult());
+			bAnyCompleted = true;
+		}
+		PendingBuilds.RemoveAtSwap(Index, EAllowShrinking::No);
+	}
+
+	if(bAnyCompleted)
+	{
+		PublishSnapshot();
+	}
+}
+
+void UOmniStaticBVHSubsystem::GatherLevel(const ULevel* Level, FOmniStaticBVHBuildInput& OutInput)
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniStaticBVHSubsystem::GatherLevel);
+
+	TInlineComponentArray<UPrimitiveComponent*> Components;
+	for(AActor* Actor : Level->Actors)
+	{
+		if(!Actor)
+		{
+			continue;
+		}
+
+		Actor->GetComponents(Components);
+		for(UPrimitiveComponent* Component : Components)
+		{
+			if(!Component->IsRegistered() || Component->Mobility != EComponentMobility::Static
+				|| !CollisionEnabledHasQuery(Component->GetCollisionEnabled()))
+			{
+				continue;
+			}
+
+			const int32 PrimitiveIndex = OutInput.Primitives.AddDefaulted();
+			FOmniBVHPrimitive& Primitive = OutInput.Primitives[PrimitiveIndex];
+			Primitive.Component = Component;
+			Primitive.Actor = Actor;
+			Primitive.ActorId = Actor->GetUniqueID();
+			Primitive.ObjectType = Component->GetCollisionObjectType();
+			Primitive.Responses = Component->GetCollisionResponseToChannels();
+
+			const UBodySetup* BodySetup = Component->GetBodySetup();
+			if(!BodySetup || !OmniStaticBVHGather::AddSimpleCollision(OutInput, PrimitiveIndex, *BodySetup, Component->GetComponentTransform()))
+			{
+				OmniStaticBVHGather::AddBox(OutInput, PrimitiveIndex, Component->Bounds.GetBox());
+			}
+		}
+	}
+}
+
+void UOmniStaticBVHSubsystem::OnLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if(InWorld == GetWorld())
+	{
+		RebuildLevel(Level);
+	}
+}
+
+void UOmniStaticBVHSubsystem::OnLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	if(InWorld != GetWorld())
+	{
+		return;
+	}
+
+	//A null level means every level is being removed
+	if(!Level)
+	{
+		PendingBuilds.Empty();
+		LevelBVHs.Empty();
+		PublishSnapshot();
+		return;
+	}
+
+	PendingBuilds.RemoveAll([Level](const FPendingBuild& Build)
+	{
+		return Build.Level == Level;
+	});
+
+	if(LevelBVHs.Remove(Level) > 0)
+	{
+		PublishSnapshot();
+	}
+}
+
+void UOmniStaticBVHSubsystem::PublishSnapshot()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniStaticBVHSubsystem::PublishSnapshot);
+
+	TSharedRef<FOmniStaticBVHSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FOmniStaticBVHSnapshot, ESPMode::ThreadSafe>();
+	int32 NumItems = 0;
+	for(auto It = LevelBVHs.CreateIterator(); It; ++It)
+	{
+		//Levels can be garbage collected without being removed from the world first
+		if(!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		NewSnapshot->LevelBVHs.Add(It.Value());
+		NumItems += It.Value()->GetNumItems();
+	}
+
+	SET_DWORD_STAT(STAT_OmniStaticBVHItems, NumItems);
+
+	FWriteScopeLock WriteLock(SnapshotLock);
+	Snapshot = NewSnapshot;
+}
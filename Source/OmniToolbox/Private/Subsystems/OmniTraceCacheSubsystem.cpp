@@ -0,0 +1,137 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniTraceCacheSubsystem.h"
+#include "OmniRuntimeMacros.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, EnableTraceCache, true,
+	"OmniToolbox.Trace.EnableCache",
+	"Allow traces whose query has CacheFrames above 0 to be served from the trace cache");
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, float, TraceCacheQuantization, 1.f,
+	"OmniToolbox.Trace.CacheQuantization",
+	"Size of the grid that trace start and end locations are snapped to when looking up cached traces");
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cache Hits"), STAT_OmniTraceCacheHits, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cache Misses"), STAT_OmniTraceCacheMisses, STATGROUP_OmniTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Traces"), STAT_OmniTraceCachedTraces, STATGROUP_OmniTrace);
+
+namespace OmniTraceCache
+{
+	FIntVector Quantize(const FVector& Vector, double GridSize)
+	{
+		return FIntVector(
+			FMath::RoundToInt32(Vector.X / GridSize),
+			FMath::RoundToInt32(Vector.Y / GridSize),
+			FMath::RoundToInt32(Vector.Z / GridSize));
+	}
+}
+
+bool UOmniTraceCacheSubsystem::IsCacheEnabled()
+{
+	return EnableTraceCache;
+}
+
+FOmniTraceCacheKey UOmniTraceCacheSubsystem::MakeKey(EOmniTraceShape Shape, const FVector& Start,
+	const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+	const FOmniTraceQuery& Query)
+{
+	const double GridSize = FMath::Max(static_cast<double>(TraceCacheQuantization), UE_KINDA_SMALL_NUMBER);
+
+	FOmniTraceCacheKey Key;
+	Key.Start = OmniTraceCache::Quantize(Start, GridSize);
+	Key.End = OmniTraceCache::Quantize(End, GridSize);
+	Key.Shape = Shape;
+	Key.ResultType = static_cast<uint8>(ResultType);
+	Key.Channel = static_cast<uint8>(Query.GetChannel());
+	Key.QueryFlags = (Query.GetQueryParams().bTraceComplex ? FOmniTraceCacheKey::TraceComplex : 0)
+		| (Query.UseStaticBVH ? FOmniTraceCacheKey::UseStaticBVH : 0);
+	Key.Responses = Query.GetResponseParams().CollisionResponse;
+	Key.IgnoredActorIds.Append(Query.GetSortedIgnoredActorIds());
+	Key.QueryHash = Query.GetCacheHash();
+
+	//Lines ignore the rotation and the shape, so don't let them affect the key
+	if(Shape != EOmniTraceShape::Line)
+	{
+		const FQuat Normalized = Rotation.GetNormalized();
+		Key.Rotation = FIntVector4(
+			FMath::RoundToInt32(Normalized.X * 1000.0),
+			FMath::RoundToInt32(Normalized.Y * 1000.0),
+			FMath::RoundToInt32(Normalized.Z * 1000.0),
+			FMath::RoundToInt32(Normalized.W * 1000.0));
+		Key.ShapeExtent = OmniTraceCache::Quantize(CollisionShape.GetExtent(), GridSize);
+	}
+
+	return Key;
+}
+
+bool UOmniTraceCacheSubsystem::FindCachedTrace(const FOmniTraceCacheKey& Key, TArray<FHitResult>& OutHitResults)
+{
+	PruneExpiredEntries();
+
+	const FOmniTraceCacheEntry* Entry = Entries.Find(Key);
+	if(!Entry || Entry->ExpireFrame <= GFrameCounter)
+	{
+		CacheMisses++;
+		INC_DWORD_STAT(STAT_OmniTraceCacheMisses);
+		return false;
+	}
+
+	CacheHits++;
+	INC_DWORD_STAT(STAT_OmniTraceCacheHits);
+	OutHitResults = Entry->HitResults;
+	return true;
+}
+
+void UOmniTraceCacheSubsystem::AddCachedTrace(const FOmniTraceCacheKey& Key, const TArray<FHitResult>& HitResults,
+	int32 CacheFrames)
+{
+	if(CacheFrames <= 0)
+	{
+		return;
+	}
+
+	FOmniTraceCacheEntry& Entry = Entries.FindOrAdd(Key);
+	Entry.HitResults = HitResults;
+	Entry.ExpireFrame = GFrameCounter + CacheFrames;
+
+	SET_DWORD_STAT(STAT_OmniTraceCachedTraces, Entries.Num());
+}
+
+void UOmniTraceCacheSubsystem::ClearCache()
+{
+	Entries.Reset();
+	SET_DWORD_STAT(STAT_OmniTraceCachedTraces, 0);
+}
+
+void UOmniTraceCacheSubsystem::Deinitialize()
+{
+	Entries.Empty();
+	SET_DWORD_STAT(STAT_OmniTraceCachedTraces, 0);
+
+	Super::Deinitialize();
+}
+
+void UOmniTraceCacheSubsystem::PruneExpiredEntries()
+{
+	if(LastPruneFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceCacheSubsystem::PruneExpiredEntries);
+
+	LastPruneFrame = GFrameCounter;
+	for(auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if(It.Value().ExpireFrame <= GFrameCounter)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_OmniTraceCachedTraces, Entries.Num());
+}
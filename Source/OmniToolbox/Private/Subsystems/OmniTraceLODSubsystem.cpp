@@ -0,0 +1,274 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniTraceLODSubsystem.h"
+#include "OmniToolbox.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Simplified Traces"), STAT_OmniTraceLODSimplified, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Downgraded Results"), STAT_OmniTraceLODDowngraded, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Reused Results"), STAT_OmniTraceLODReused, STATGROUP_OmniTrace);
+
+static FAutoConsoleCommand LogTraceLODStatsCommand(
+	TEXT("OmniToolbox.Trace.LODStats"),
+	TEXT("Log how many traces every LOD level of every trace LOD policy has downgraded or skipped, per world"),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		for(TObjectIterator<UOmniTraceLODSubsystem> It; It; ++It)
+		{
+			It->LogCounters();
+		}
+	}));
+
+namespace OmniTraceLOD
+{
+	FIntVector Quantize(const FVector& Vector, double GridSize)
+	{
+		return FIntVector(
+			FMath::RoundToInt32(Vector.X / GridSize),
+			FMath::RoundToInt32(Vector.Y / GridSize),
+			FMath::RoundToInt32(Vector.Z / GridSize));
+	}
+}
+
+void UOmniTraceLODSubsystem::SetReferencePoint(const UOmniTraceLODPolicy* Policy, const FVector& Location)
+{
+	if(!Policy)
+	{
+		return;
+	}
+
+	FPolicyState& State = PolicyStates.FindOrAdd(Policy);
+	State.ReferencePoint = Location;
+	State.bUseReferencePoint = true;
+}
+
+void UOmniTraceLODSubsystem::ClearReferencePoint(const UOmniTraceLODPolicy* Policy)
+{
+	if(FPolicyState* State = PolicyStates.Find(Policy))
+	{
+		State->bUseReferencePoint = false;
+	}
+}
+
+FOmniTraceLODCounters UOmniTraceLODSubsystem::GetLevelCounters(const UOmniTraceLODPolicy* Policy, int32 Level) const
+{
+	const FPolicyState* State = PolicyStates.Find(Policy);
+	return State && State->LevelCounters.IsValidIndex(Level) ? State->LevelCounters[Level] : FOmniTraceLODCounters();
+}
+
+void UOmniTraceLODSubsystem::ResetCounters(const UOmniTraceLODPolicy* Policy)
+{
+	if(FPolicyState* State = PolicyStates.Find(Policy))
+	{
+		State->LevelCounters.Reset();
+	}
+}
+
+FOmniTraceLODDecision UOmniTraceLODSubsystem::Evaluate(const UOmniTraceLODPolicy& Policy, EOmniTraceShape Shape, const FVector& Start,
+	const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType,
+	const FOmniTraceQuery& Query)
+{
+	FOmniTraceLODDecision Decision;
+	Decision.ResultType = ResultType;
+
+	if(Policy.Levels.IsEmpty())
+	{
+		return Decision;
+	}
+
+	FPolicyState& State = PolicyStates.FindOrAdd(&Policy);
+
+	double Distance = TNumericLimits<double>::Max();
+	if(State.bUseReferencePoint)
+	{
+		Distance = FMath::PointDistToSegment(State.ReferencePoint, Start, End);
+	}
+	else
+	{
+		UpdateViewLocations();
+		if(ViewLocations.IsEmpty())
+		{
+			return Decision;
+		}
+
+		for(const FVector& ViewLocation : ViewLocations)
+		{
+			Distance = FMath::Min(Distance, FMath::PointDistToSegment(ViewLocation, Start, End));
+		}
+	}
+
+	Decision.Level = Policy.FindLevel(Distance);
+	if(Decision.Level == INDEX_NONE)
+	{
+		return Decision;
+	}
+
+	const FOmniTraceLODLevel& Level = Policy.Levels[Decision.Level];
+	FOmniTraceLODCounters& Counters = GetCounters(Policy, State, Decision.Level);
+	Counters.Traces++;
+
+	if(Level.ForceSimpleCollision && Query.GetQueryParams().bTraceComplex)
+	{
+		Decision.bForceSimpleCollision = true;
+		Counters.SimplifiedTraces++;
+		INC_DWORD_STAT(STAT_OmniTraceLODSimplified);
+	}
+
+	if(Level.DowngradeMultiToSingle && Decision.ResultType == MultiResult)
+	{
+		Decision.ResultType = SingleResult;
+	}
+
+	if(Level.DowngradeSingleToTest && Decision.ResultType == SingleResult)
+	{
+		Decision.ResultType = TestResult;
+	}
+
+	if(Decision.ResultType != ResultType)
+	{
+		Counters.DowngradedResults++;
+		INC_DWORD_STAT(STAT_OmniTraceLODDowngraded);
+	}
+
+	if(Level.ReuseCooldown > 0)
+	{
+		const double GridSize = FMath::Max(static_cast<double>(Level.ReuseTolerance), 1.0);
+
+		/**Same as the trace cache key, which compares the full query, but with the level's own tolerance.
+		 * The key describes the trace that is actually performed, so simplified traces
+		 * only ever reuse the results of other simple traces.*/
+		Decision.ReuseKey = UOmniTraceCacheSubsystem::MakeKey(Shape, Start, End, Rotation, CollisionShape, Decision.ResultType, Query);
+		Decision.ReuseKey.Start = OmniTraceLOD::Quantize(Start, GridSize);
+		Decision.ReuseKey.End = OmniTraceLOD::Quantize(End, GridSize);
+		if(Decision.bForceSimpleCollision)
+		{
+			Decision.ReuseKey.QueryFlags &= ~FOmniTraceCacheKey::TraceComplex;
+		}
+		Decision.bCanReuse = true;
+	}
+
+	return Decision;
+}
+
+bool UOmniTraceLODSubsystem::FindReusableResult(const UOmniTraceLODPolicy& Policy, const FOmniTraceLODDecision& Decision,
+	TArray<FHitResult>& OutHitResults)
+{
+	if(!Decision.bCanReuse)
+	{
+		return false;
+	}
+
+	FPolicyState* State = PolicyStates.Find(&Policy);
+	if(!State)
+	{
+		return false;
+	}
+
+	PruneReuseEntries(*State);
+
+	const FReuseEntry* Entry = State->ReuseEntries.Find(Decision.ReuseKey);
+	if(!Entry || Entry->ExpireTime <= GetWorld()->GetTimeSeconds())
+	{
+		return false;
+	}
+
+	GetCounters(Policy, *State, Decision.Level).ReusedResults++;
+	INC_DWORD_STAT(STAT_OmniTraceLODReused);
+	OutHitResults = Entry->HitResults;
+	return true;
+}
+
+void UOmniTraceLODSubsystem::StoreResult(const UOmniTraceLODPolicy& Policy, const FOmniTraceLODDecision& Decision,
+	const TArray<FHitResult>& HitResults)
+{
+	if(!Decision.bCanReuse)
+	{
+		return;
+	}
+
+	FReuseEntry& Entry = PolicyStates.FindOrAdd(&Policy).ReuseEntries.FindOrAdd(Decision.ReuseKey);
+	Entry.HitResults = HitResults;
+	Entry.ExpireTime = GetWorld()->GetTimeSeconds() + Policy.Levels[Decision.Level].ReuseCooldown;
+}
+
+void UOmniTraceLODSubsystem::LogCounters() const
+{
+	for(const TPair<TObjectKey<UOmniTraceLODPolicy>, FPolicyState>& PolicyState : PolicyStates)
+	{
+		const UOmniTraceLODPolicy* Policy = PolicyState.Key.ResolveObjectPtr();
+		if(!Policy)
+		{
+			continue;
+		}
+
+		UE_LOG(LogOmniToolbox, Log, TEXT("Trace LOD policy %s in %s:"), *Policy->GetPathName(), *GetWorld()->GetName());
+		for(int32 LevelIndex = 0; LevelIndex < Policy->Levels.Num(); ++LevelIndex)
+		{
+			const FOmniTraceLODCounters Counters = GetLevelCounters(Policy, LevelIndex);
+			UE_LOG(LogOmniToolbox, Log, TEXT("    Level %d (%.0fcm): %lld traces, %lld simplified, %lld downgraded, %lld reused"),
+				LevelIndex, Policy->Levels[LevelIndex].MinDistance, Counters.Traces, Counters.SimplifiedTraces, Counters.DowngradedResults,
+				Counters.ReusedResults);
+		}
+	}
+}
+
+void UOmniTraceLODSubsystem::Deinitialize()
+{
+	PolicyStates.Empty();
+	ViewLocations.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOmniTraceLODSubsystem::UpdateViewLocations()
+{
+	if(ViewFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	ViewFrame = GFrameCounter;
+	ViewLocations.Reset();
+	for(FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if(PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+}
+
+void UOmniTraceLODSubsystem::PruneReuseEntries(FPolicyState& State) const
+{
+	if(State.LastPruneFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	State.LastPruneFrame = GFrameCounter;
+	const double TimeSeconds = GetWorld()->GetTimeSeconds();
+	for(auto It = State.ReuseEntries.CreateIterator(); It; ++It)
+	{
+		if(It.Value().ExpireTime <= TimeSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FOmniTraceLODCounters& UOmniTraceLODSubsystem::GetCounters(const UOmniTraceLODPolicy& Policy, FPolicyState& State, int32 Level)
+{
+	if(State.LevelCounters.Num() < Policy.Levels.Num())
+	{
+		State.LevelCounters.SetNum(Policy.Levels.Num());
+	}
+
+	return State.LevelCounters[Level];
+}
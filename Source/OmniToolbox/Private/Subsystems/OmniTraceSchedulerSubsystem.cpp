@@ -0,0 +1,165 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Subsystems/OmniTraceSchedulerSubsystem.h"
+#include "Engine/World.h"
+#include "OmniRuntimeMacros.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, int32, TraceSchedulerBudget, 64,
+	"OmniToolbox.Trace.SchedulerBudget",
+	"How many traces the trace scheduler is allowed to issue per frame");
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduler Queue Depth"), STAT_OmniTraceSchedulerQueueDepth, STATGROUP_OmniTrace);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Scheduler Average Wait Frames"), STAT_OmniTraceSchedulerAverageWait, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduler Issued Traces"), STAT_OmniTraceSchedulerIssued, STATGROUP_OmniTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduler Dropped Traces"), STAT_OmniTraceSchedulerDropped, STATGROUP_OmniTrace);
+
+namespace OmniTraceScheduler
+{
+	struct FPriorityPredicate
+	{
+		bool operator()(const FOmniScheduledTrace& A, const FOmniScheduledTrace& B) const
+		{
+			if(A.Priority != B.Priority)
+			{
+				return A.Priority > B.Priority;
+			}
+
+			return A.Sequence < B.Sequence;
+		}
+	};
+
+	bool IsStale(const FOmniScheduledTrace& Trace)
+	{
+		return Trace.MaxStaleFrames >= 0 && GFrameCounter - Trace.SubmitFrame > static_cast<uint64>(Trace.MaxStaleFrames);
+	}
+}
+
+void UOmniTraceSchedulerSubsystem::ScheduleTrace(const FOmniTraceRequest& Request, const FOmniTraceQuery& Query,
+	FAsyncTraceResultDelegate OnTraceCompleted, int32 Priority, int32 MaxStaleFrames, FTraceDebug DebugOptions)
+{
+	/**Bursts are usually scheduled with the same query, so only the first trace of a burst copies and compiles it.
+	 * Precompiled queries can have been compiled from anything, so their compiled params have to match as well.*/
+	const bool bReuseLastQuery = LastQuery.IsValid() && bLastQueryWasCompiled == Query.IsCompiled()
+		&& (!Query.IsCompiled() || (Query.GetCacheHash() == LastQuery->GetCacheHash() && Query.GetChannel() == LastQuery->GetChannel()))
+		&& FOmniTraceQuery::StaticStruct()->CompareScriptStruct(&Query, LastQuery.Get(), PPF_None);
+
+	if(!bReuseLastQuery)
+	{
+		//Compile now, so it's not compiled again when it's issued
+		const TSharedRef<FOmniTraceQuery> SharedQuery = MakeShared<FOmniTraceQuery>(Query);
+		if(!SharedQuery->IsCompiled())
+		{
+			SharedQuery->Compile();
+		}
+		LastQuery = SharedQuery;
+		bLastQueryWasCompiled = Query.IsCompiled();
+	}
+
+	ScheduleTraceShared(Request, LastQuery.ToSharedRef(), OnTraceCompleted, Priority, MaxStaleFrames, DebugOptions);
+}
+
+void UOmniTraceSchedulerSubsystem::ScheduleTraceShared(const FOmniTraceRequest& Request, const TSharedRef<const FOmniTraceQuery>& Query,
+	const FAsyncTraceResultDelegate& OnTraceCompleted, int32 Priority, int32 MaxStaleFrames, const FTraceDebug& DebugOptions)
+{
+	checkf(Query->IsCompiled(), TEXT("ScheduleTraceShared requires a query that has already been compiled"));
+
+	FOmniScheduledTrace Trace;
+	Trace.Request = Request;
+	Trace.Query = Query;
+	Trace.OnTraceCompleted = OnTraceCompleted;
+	Trace.DebugOptions = DebugOptions;
+	Trace.Priority = Priority;
+	Trace.MaxStaleFrames = MaxStaleFrames;
+	Trace.SubmitFrame = GFrameCounter;
+	Trace.Sequence = NextSequence++;
+
+	Queue.HeapPush(MoveTemp(Trace), OmniTraceScheduler::FPriorityPredicate());
+	SET_DWORD_STAT(STAT_OmniTraceSchedulerQueueDepth, Queue.Num());
+}
+
+int32 UOmniTraceSchedulerSubsystem::GetBudget() const
+{
+	return FMath::Max(0, BudgetOverride >= 0 ? BudgetOverride : TraceSchedulerBudget);
+}
+
+float UOmniTraceSchedulerSubsystem::GetAverageWaitFrames() const
+{
+	return IssuedTraces > 0 ? static_cast<float>(static_cast<double>(TotalWaitFrames) / IssuedTraces) : 0.f;
+}
+
+void UOmniTraceSchedulerSubsystem::Tick(float DeltaTime)
+{
+	if(Queue.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UOmniTraceSchedulerSubsystem::Tick);
+
+	DropStaleTraces();
+
+	UWorld* World = GetWorld();
+	const OmniTraceScheduler::FPriorityPredicate Predicate;
+
+	for(int32 Budget = GetBudget(); Budget > 0 && !Queue.IsEmpty(); --Budget)
+	{
+		FOmniScheduledTrace Trace;
+		Queue.HeapPop(Trace, Predicate, EAllowShrinking::No);
+
+		TotalWaitFrames += GFrameCounter - Trace.SubmitFrame;
+		IssuedTraces++;
+		INC_DWORD_STAT(STAT_OmniTraceSchedulerIssued);
+
+		const FOmniTraceRequest& Request = Trace.Request;
+		UOmniTraceLibrary::AsyncTraceByQuery(World, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+			Request.MakeCollisionShape(), Request.ResultType, *Trace.Query, Trace.OnTraceCompleted, Trace.DebugOptions);
+	}
+
+	SET_DWORD_STAT(STAT_OmniTraceSchedulerQueueDepth, Queue.Num());
+	SET_FLOAT_STAT(STAT_OmniTraceSchedulerAverageWait, GetAverageWaitFrames());
+}
+
+void UOmniTraceSchedulerSubsystem::Deinitialize()
+{
+	Queue.Empty();
+	LastQuery.Reset();
+	DroppedDelegates.Empty();
+	SET_DWORD_STAT(STAT_OmniTraceSchedulerQueueDepth, 0);
+
+	Super::Deinitialize();
+}
+
+void UOmniTraceSchedulerSubsystem::DropStaleTraces()
+{
+	DroppedDelegates.Reset();
+	const int32 NumDropped = Queue.RemoveAllSwap([this](FOmniScheduledTrace& Trace)
+	{
+		if(!OmniTraceScheduler::IsStale(Trace))
+		{
+			return false;
+		}
+
+		DroppedDelegates.Add(MoveTemp(Trace.OnTraceCompleted));
+		return true;
+	}, EAllowShrinking::No);
+	if(NumDropped == 0)
+	{
+		return;
+	}
+
+	DroppedTraces += NumDropped;
+	INC_DWORD_STAT_BY(STAT_OmniTraceSchedulerDropped, NumDropped);
+
+	//Swapping has broken the heap
+	Queue.Heapify(OmniTraceScheduler::FPriorityPredicate());
+
+	//The heap has to be intact before the callbacks get a chance to schedule new traces
+	const TArray<FHitResult> NoHits;
+	for(const FAsyncTraceResultDelegate& OnTraceCompleted : DroppedDelegates)
+	{
+		OnTraceCompleted.ExecuteIfBound(NoHits);
+	}
+}
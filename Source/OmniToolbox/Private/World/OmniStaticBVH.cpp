@@ -0,0 +1,620 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "World/OmniStaticBVH.h"
+#include "Math/VectorRegister.h"
+#include "Algo/Sort.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace OmniStaticBVH
+{
+	constexpr int32 MaxItemsPerLeaf = 4;
+	constexpr int32 MaxStackDepth = 64;
+
+	/**Everything about a single cast that doesn't change while traversing the tree*/
+	struct FCastContext
+	{
+		FVector3f Origin;
+		FVector3f Direction;
+		float Length = 0;
+		float Radius = 0;
+
+		VectorRegister4Float OriginRegister;
+		VectorRegister4Float InverseDirectionRegister;
+		VectorRegister4Float RadiusRegister;
+	};
+
+	/**Slab test of the ray against the node bounds, grown by the cast radius.
+	 * Returns the entry distance, or a negative value if the node is missed.*/
+	FORCEINLINE float IntersectNode(const FOmniBVHNode& Node, const FCastContext& Context, float MaxDistance)
+	{
+		const VectorRegister4Float Min = VectorSubtract(VectorLoadAligned(Node.Min), Context.RadiusRegister);
+		const VectorRegister4Float Max = VectorAdd(VectorLoadAligned(Node.Max), Context.RadiusRegister);
+
+		const VectorRegister4Float T0 = VectorMultiply(VectorSubtract(Min, Context.OriginRegister), Context.InverseDirectionRegister);
+		const VectorRegister4Float T1 = VectorMultiply(VectorSubtract(Max, Context.OriginRegister), Context.InverseDirectionRegister);
+
+		alignas(16) float Near[4];
+		alignas(16) float Far[4];
+		VectorStoreAligned(VectorMin(T0, T1), Near);
+		VectorStoreAligned(VectorMax(T0, T1), Far);
+
+		const float Enter = FMath::Max3(Near[0], Near[1], FMath::Max(Near[2], 0.f));
+		const float Exit = FMath::Min3(Far[0], Far[1], FMath::Min(Far[2], MaxDistance));
+		return Enter <= Exit ? Enter : -1.f;
+	}
+
+	/**Ray against an axis aligned box grown by the cast radius*/
+	bool IntersectBox(const FVector3f& Min, const FVector3f& Max, const FCastContext& Context, float MaxDistance,
+		float& OutDistance, FVector3f& OutNormal)
+	{
+		float Enter = 0;
+		float Exit = MaxDistance;
+		int32 EnterAxis = INDEX_NONE;
+		for(int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const float AxisMin = Min[Axis] - Context.Radius;
+			const float AxisMax = Max[Axis] + Context.Radius;
+			if(FMath::IsNearlyZero(Context.Direction[Axis]))
+			{
+				if(Context.Origin[Axis] < AxisMin || Context.Origin[Axis] > AxisMax)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const float InverseDirection = 1.f / Context.Direction[Axis];
+			float T0 = (AxisMin - Context.Origin[Axis]) * InverseDirection;
+			float T1 = (AxisMax - Context.Origin[Axis]) * InverseDirection;
+			if(T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+
+			if(T0 > Enter)
+			{
+				Enter = T0;
+				EnterAxis = Axis;
+			}
+			Exit = FMath::Min(Exit, T1);
+			if(Enter > Exit)
+			{
+				return false;
+			}
+		}
+
+		OutDistance = Enter;
+		OutNormal = FVector3f::ZeroVector;
+		if(EnterAxis != INDEX_NONE)
+		{
+			OutNormal[EnterAxis] = Context.Direction[EnterAxis] > 0 ? -1.f : 1.f;
+		}
+		else
+		{
+			//Started inside of the box
+			OutNormal = -Context.Direction;
+		}
+		return true;
+	}
+
+	/**Möller-Trumbore ray triangle intersection, culling nothing*/
+	bool IntersectTriangle(const FVector3f& A, const FVector3f& B, const FVector3f& C, const FVector3f& Origin,
+		const FVector3f& Direction, float MaxDistance, float& OutDistance)
+	{
+		const FVector3f EdgeA = B - A;
+		const FVector3f EdgeB = C - A;
+		const FVector3f P = FVector3f::CrossProduct(Direction, EdgeB);
+		const float Determinant = FVector3f::DotProduct(EdgeA, P);
+		if(FMath::Abs(Determinant) < UE_SMALL_NUMBER)
+		{
+			return false;
+		}
+
+		const float InverseDeterminant = 1.f / Determinant;
+		const FVector3f T = Origin - A;
+		const float U = FVector3f::DotProduct(T, P) * InverseDeterminant;
+		if(U < 0.f || U > 1.f)
+		{
+			return false;
+		}
+
+		const FVector3f Q = FVector3f::CrossProduct(T, EdgeA);
+		const float V = FVector3f::DotProduct(Direction, Q) * InverseDeterminant;
+		if(V < 0.f || U + V > 1.f)
+		{
+			return false;
+		}
+
+		const float Distance = FVector3f::DotProduct(EdgeB, Q) * InverseDeterminant;
+		if(Distance < 0.f || Distance > MaxDistance)
+		{
+			return false;
+		}
+
+		OutDistance = Distance;
+		return true;
+	}
+
+	/**Sphere sweep against a single point. Solves |Origin + Direction * T - Point| = Radius*/
+	bool SweepSphereAgainstPoint(const FVector3f& Point, const FCastContext& Context, float MaxDistance, float& OutDistance)
+	{
+		const FVector3f M = Context.Origin - Point;
+		const float B = FVector3f::DotProduct(M, Context.Direction);
+		const float C = M.SizeSquared() - FMath::Square(Context.Radius);
+		if(C > 0 && B > 0)
+		{
+			//Outside of the sphere and moving away from it
+			return false;
+		}
+
+		const float Discriminant = B * B - C;
+		if(Discriminant < 0)
+		{
+			return false;
+		}
+
+		const float Distance = FMath::Max(-B - FMath::Sqrt(Discriminant), 0.f);
+		if(Distance > MaxDistance)
+		{
+			return false;
+		}
+
+		OutDistance = Distance;
+		return true;
+	}
+
+	/**Sphere sweep against the side of the capsule around the edge @A - @B.
+	 * The rounded ends are left to SweepSphereAgainstPoint.*/
+	bool SweepSphereAgainstEdge(const FVector3f& A, const FVector3f& B, const FCastContext& Context, float MaxDistance,
+		float& OutDistance)
+	{
+		const FVector3f Edge = B - A;
+		const FVector3f M = Context.Origin - A;
+		const float EdgeEdge = Edge.SizeSquared();
+		const float EdgeDirection = FVector3f::DotProduct(Edge, Context.Direction);
+		const float EdgeM = FVector3f::DotProduct(Edge, M);
+		if(EdgeEdge < UE_SMALL_NUMBER)
+		{
+			return false;
+		}
+
+		const float QuadA = EdgeEdge - EdgeDirection * EdgeDirection;
+		const float QuadB = EdgeEdge * FVector3f::DotProduct(M, Context.Direction) - EdgeM * EdgeDirection;
+		const float QuadC = EdgeEdge * (M.SizeSquared() - FMath::Square(Context.Radius)) - EdgeM * EdgeM;
+
+		if(QuadC < 0)
+		{
+			//Started inside of the infinite cylinder, only a hit if it's within the edge
+			const float Along = EdgeM / EdgeEdge;
+			if(Along < 0 || Along > 1)
+			{
+				return false;
+			}
+			OutDistance = 0;
+			return true;
+		}
+
+		if(QuadA < UE_SMALL_NUMBER)
+		{
+			//Moving parallel to the edge, only the end points can be hit
+			return false;
+		}
+
+		const float Discriminant = QuadB * QuadB - QuadA * QuadC;
+		if(Discriminant < 0)
+		{
+			return false;
+		}
+
+		const float Distance = (-QuadB - FMath::Sqrt(Discriminant)) / QuadA;
+		if(Distance < 0 || Distance > MaxDistance)
+		{
+			return false;
+		}
+
+		const float Along = (EdgeM + Distance * EdgeDirection) / EdgeEdge;
+		if(Along < 0 || Along > 1)
+		{
+			return false;
+		}
+
+		OutDistance = Distance;
+		return true;
+	}
+
+	bool IntersectItem(const FOmniBVHItem& Item, const FCastContext& Context, float MaxDistance, float& OutDistance,
+		FVector3f& OutNormal)
+	{
+		if(Item.bIsBox)
+		{
+			return IntersectBox(Item.A, Item.B, Context, MaxDistance, OutDistance, OutNormal);
+		}
+
+		FVector3f Normal = FVector3f::CrossProduct(Item.B - Item.A, Item.C - Item.A).GetSafeNormal();
+		if(FVector3f::DotProduct(Normal, Context.Direction) > 0)
+		{
+			Normal = -Normal;
+		}
+		OutNormal = Normal;
+
+		if(Context.Radius <= 0)
+		{
+			return IntersectTriangle(Item.A, Item.B, Item.C, Context.Origin, Context.Direction, MaxDistance, OutDistance);
+		}
+
+		//Already touching the triangle at the start of the cast
+		const FVector ClosestToStart = FMath::ClosestPointOnTriangleToPoint(FVector(Context.Origin), FVector(Item.A), FVector(Item.B), FVector(Item.C));
+		const FVector3f StartOffset = Context.Origin - FVector3f(ClosestToStart);
+		if(StartOffset.SizeSquared() <= FMath::Square(Context.Radius))
+		{
+			OutDistance = 0;
+			OutNormal = StartOffset.IsNearlyZero() ? Normal : StartOffset.GetSafeNormal();
+			return true;
+		}
+
+		/**The sphere touches the face once its center reaches the triangle pushed out by the radius.
+		 * If it doesn't, it can only touch an edge or a corner, which is the ray against
+		 * a capsule around each edge and a sphere around each corner.*/
+		const FVector3f Offset = Normal * Context.Radius;
+		if(IntersectTriangle(Item.A + Offset, Item.B + Offset, Item.C + Offset, Context.Origin, Context.Direction, MaxDistance, OutDistance))
+		{
+			return true;
+		}
+
+		const FVector3f* Corners[3] = {&Item.A, &Item.B, &Item.C};
+		float ClosestDistance = MaxDistance;
+		bool bHit = false;
+		for(int32 Index = 0; Index < 3; ++Index)
+		{
+			const FVector3f& Corner = *Corners[Index];
+			const FVector3f& NextCorner = *Corners[(Index + 1) % 3];
+			float Distance;
+			if(SweepSphereAgainstEdge(Corner, NextCorner, Context, ClosestDistance, Distance))
+			{
+				ClosestDistance = Distance;
+				bHit = true;
+			}
+			if(SweepSphereAgainstPoint(Corner, Context, ClosestDistance, Distance))
+			{
+				ClosestDistance = Distance;
+				bHit = true;
+			}
+		}
+
+		if(!bHit)
+		{
+			return false;
+		}
+
+		//The normal points from the closest point on the triangle to the center of the sphere
+		const FVector Center = FVector(Context.Origin + Context.Direction * ClosestDistance);
+		const FVector Closest = FMath::ClosestPointOnTriangleToPoint(Center, FVector(Item.A), FVector(Item.B), FVector(Item.C));
+		const FVector3f ContactNormal = FVector3f(Center - Closest).GetSafeNormal();
+		OutNormal = ContactNormal.IsNearlyZero() ? Normal : ContactNormal;
+		OutDistance = ClosestDistance;
+		return true;
+	}
+}
+
+FBox3f FOmniBVHItem::GetBounds() const
+{
+	if(bIsBox)
+	{
+		return FBox3f(A, B);
+	}
+
+	FBox3f Bounds(ForceInit);
+	Bounds += A;
+	Bounds += B;
+	Bounds += C;
+	return Bounds;
+}
+
+FVector3f FOmniBVHItem::GetCentroid() const
+{
+	return bIsBox ? (A + B) * 0.5f : (A + B + C) / 3.f;
+}
+
+FOmniBVHQueryFilter::FOmniBVHQueryFilter(ECollisionChannel InChannel, const FCollisionQueryParams& QueryParams,
+	const FCollisionResponseParams& ResponseParams)
+	: Channel(InChannel)
+	, Responses(ResponseParams.CollisionResponse)
+{
+	IgnoredActorIds.Append(QueryParams.GetIgnoredActors());
+}
+
+FOmniStaticBVH::FOmniStaticBVH(FOmniStaticBVHBuildInput&& Input)
+	: Primitives(MoveTemp(Input.Primitives))
+	, Items(MoveTemp(Input.Items))
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniStaticBVH::Build);
+
+	if(Items.IsEmpty())
+	{
+		return;
+	}
+
+	//A binary tree with leaves of at least one item never has more than this many nodes
+	Nodes.Reserve(Items.Num() * 2);
+	BuildRecursive(0, Items.Num());
+
+	const FOmniBVHNode& Root = Nodes[0];
+	Bounds = FBox(FVector(Root.Min[0], Root.Min[1], Root.Min[2]), FVector(Root.Max[0], Root.Max[1], Root.Max[2]));
+}
+
+int32 FOmniStaticBVH::BuildRecursive(int32 First, int32 Count)
+{
+	const int32 NodeIndex = Nodes.AddDefaulted();
+
+	FBox3f NodeBounds(ForceInit);
+	FBox3f CentroidBounds(ForceInit);
+	for(int32 Index = First; Index < First + Count; ++Index)
+	{
+		NodeBounds += Items[Index].GetBounds();
+		CentroidBounds += Items[Index].GetCentroid();
+	}
+
+	{
+		FOmniBVHNode& Node = Nodes[NodeIndex];
+		Node.Min[0] = NodeBounds.Min.X; Node.Min[1] = NodeBounds.Min.Y; Node.Min[2] = NodeBounds.Min.Z;
+		Node.Max[0] = NodeBounds.Max.X; Node.Max[1] = NodeBounds.Max.Y; Node.Max[2] = NodeBounds.Max.Z;
+	}
+
+	if(Count <= OmniStaticBVH::MaxItemsPerLeaf)
+	{
+		Nodes[NodeIndex].FirstIndex = First;
+		Nodes[NodeIndex].Count = Count;
+		return NodeIndex;
+	}
+
+	//Median split along the axis the centroids are spread out the most
+	const FVector3f CentroidExtent = CentroidBounds.GetSize();
+	const int32 Axis = CentroidExtent.X >= CentroidExtent.Y && CentroidExtent.X >= CentroidExtent.Z ? 0
+		: CentroidExtent.Y >= CentroidExtent.Z ? 1 : 2;
+
+	const int32 Half = Count / 2;
+	TArrayView<FOmniBVHItem> Range(Items.GetData() + First, Count);
+	Algo::Sort(Range, [Axis](const FOmniBVHItem& A, const FOmniBVHItem& B)
+	{
+		return A.GetCentroid()[Axis] < B.GetCentroid()[Axis];
+	});
+
+	BuildRecursive(First, Half);
+	const int32 RightChild = BuildRecursive(First + Half, Count - Half);
+
+	//Don't hold on to the node reference, the recursion might have grown the array
+	Nodes[NodeIndex].FirstIndex = RightChild;
+	Nodes[NodeIndex].Count = 0;
+	return NodeIndex;
+}
+
+ECollisionResponse FOmniStaticBVH::GetResponse(const FOmniBVHItem& Item, const FOmniBVHQueryFilter& Filter) const
+{
+	const FOmniBVHPrimitive& Primitive = Primitives[Item.PrimitiveIndex];
+	if(Filter.IgnoredActorIds.Contains(Primitive.ActorId))
+	{
+		return ECR_Ignore;
+	}
+
+	return FMath::Min(Primitive.Responses.GetResponse(Filter.Channel), Filter.Responses.GetResponse(Primitive.ObjectType));
+}
+
+void FOmniStaticBVH::Cast(const FVector& Start, const FVector& End, float Radius, const FOmniBVHQueryFilter& Filter,
+	bool bMultiHit, bool bStopAtFirstHit, TArray<FHitResult>& OutHits) const
+{
+	if(Nodes.IsEmpty())
+	{
+		return;
+	}
+
+	const FVector Delta = End - Start;
+	const double Length = Delta.Size();
+	if(Length <= UE_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	OmniStaticBVH::FCastContext Context;
+	Context.Origin = FVector3f(Start);
+	Context.Direction = FVector3f(Delta / Length);
+	Context.Length = static_cast<float>(Length);
+	Context.Radius = FMath::Max(Radius, 0.f);
+
+	//Avoid dividing by zero, a huge value still gives the correct slab result
+	auto SafeInverse = [](float Value) { return 1.f / (FMath::Abs(Value) > UE_SMALL_NUMBER ? Value : (Value < 0 ? -UE_SMALL_NUMBER : UE_SMALL_NUMBER)); };
+	Context.OriginRegister = VectorLoadFloat3_W0(&Context.Origin.X);
+	Context.InverseDirectionRegister = MakeVectorRegisterFloat(SafeInverse(Context.Direction.X), SafeInverse(Context.Direction.Y), SafeInverse(Context.Direction.Z), 0.f);
+	Context.RadiusRegister = MakeVectorRegisterFloat(Context.Radius, Context.Radius, Context.Radius, 0.f);
+
+	float ClosestDistance = Context.Length;
+	int32 ClosestItem = INDEX_NONE;
+	FVector3f ClosestNormal = FVector3f::ZeroVector;
+
+	/**Overlapping primitives found so far, only the closest hit of each primitive is kept*/
+	struct FTouch
+	{
+		int32 ItemIndex;
+		float Distance;
+		FVector3f Normal;
+	};
+	TArray<FTouch, TInlineAllocator<8>> Touches;
+
+	auto AddHit = [&](int32 ItemIndex, float Distance, const FVector3f& Normal, bool bBlockingHit)
+	{
+		const FOmniBVHPrimitive& Primitive = Primitives[Items[ItemIndex].PrimitiveIndex];
+		const FVector Location = Start + FVector(Context.Direction) * Distance;
+
+		FHitResult& HitResult = OutHits.AddDefaulted_GetRef();
+		HitResult.bBlockingHit = bBlockingHit;
+		HitResult.bStartPenetrating = Distance <= 0;
+		HitResult.TraceStart = Start;
+		HitResult.TraceEnd = End;
+		HitResult.Distance = Distance;
+		HitResult.Time = Distance / Context.Length;
+		HitResult.Location = Location;
+		HitResult.ImpactNormal = FVector(Normal);
+		HitResult.Normal = FVector(Normal);
+		HitResult.ImpactPoint = Location - FVector(Normal) * Context.Radius;
+		HitResult.Component = Primitive.Component;
+		HitResult.HitObjectHandle = FActorInstanceHandle(Primitive.Actor.GetEvenIfUnreachable());
+	};
+
+	int32 Stack[OmniStaticBVH::MaxStackDepth];
+	int32 StackSize = 0;
+	Stack[StackSize++] = 0;
+
+	while(StackSize > 0)
+	{
+		const int32 NodeIndex = Stack[--StackSize];
+		const FOmniBVHNode& Node = Nodes[NodeIndex];
+		//Multi hits stop at the first block too, so everything past it can be skipped
+		const float MaxDistance = ClosestDistance;
+		if(OmniStaticBVH::IntersectNode(Node, Context, MaxDistance) < 0)
+		{
+			continue;
+		}
+
+		if(Node.Count > 0)
+		{
+			for(int32 ItemIndex = Node.FirstIndex; ItemIndex < Node.FirstIndex + Node.Count; ++ItemIndex)
+			{
+				const FOmniBVHItem& Item = Items[ItemIndex];
+				float Distance;
+				FVector3f Normal;
+				const ECollisionResponse Response = GetResponse(Item, Filter);
+				if(Response == ECR_Ignore || (Response == ECR_Overlap && !bMultiHit)
+					|| !OmniStaticBVH::IntersectItem(Item, Context, ClosestDistance, Distance, Normal))
+				{
+					continue;
+				}
+
+				if(Response == ECR_Overlap)
+				{
+					FTouch* Touch = Touches.FindByPredicate([this, &Item](const FTouch& Other)
+					{
+						return Items[Other.ItemIndex].PrimitiveIndex == Item.PrimitiveIndex;
+					});
+					if(!Touch)
+					{
+						Touches.Add({ItemIndex, Distance, Normal});
+					}
+					else if(Distance < Touch->Distance)
+					{
+						*Touch = {ItemIndex, Distance, Normal};
+					}
+					continue;
+				}
+
+				if(bStopAtFirstHit)
+				{
+					AddHit(ItemIndex, Distance, Normal, true);
+					return;
+				}
+
+				if(Distance < ClosestDistance || ClosestItem == INDEX_NONE)
+				{
+					ClosestDistance = Distance;
+					ClosestItem = ItemIndex;
+					ClosestNormal = Normal;
+				}
+			}
+			continue;
+		}
+
+		//Visit the nearest child first, so the closest hit shrinks the search as early as possible
+		const int32 LeftChild = NodeIndex + 1;
+		const int32 RightChild = Node.FirstIndex;
+		const float LeftDistance = OmniStaticBVH::IntersectNode(Nodes[LeftChild], Context, MaxDistance);
+		const float RightDistance = OmniStaticBVH::IntersectNode(Nodes[RightChild], Context, MaxDistance);
+		if(StackSize + 2 > OmniStaticBVH::MaxStackDepth)
+		{
+			checkNoEntry();
+			break;
+		}
+
+		if(LeftDistance >= 0 && RightDistance >= 0)
+		{
+			const bool bLeftFirst = LeftDistance <= RightDistance;
+			Stack[StackSize++] = bLeftFirst ? RightChild : LeftChild;
+			Stack[StackSize++] = bLeftFirst ? LeftChild : RightChild;
+		}
+		else if(LeftDistance >= 0)
+		{
+			Stack[StackSize++] = LeftChild;
+		}
+		else if(RightDistance >= 0)
+		{
+			Stack[StackSize++] = RightChild;
+		}
+	}
+
+	//Touches that were found before a closer block was known are dropped here
+	for(const FTouch& Touch : Touches)
+	{
+		if(Touch.Distance <= ClosestDistance)
+		{
+			AddHit(Touch.ItemIndex, Touch.Distance, Touch.Normal, false);
+		}
+	}
+
+	if(ClosestItem != INDEX_NONE)
+	{
+		AddHit(ClosestItem, ClosestDistance, ClosestNormal, true);
+	}
+}
+
+void FOmniStaticBVHSnapshot::Trace(const FVector& Start, const FVector& End, float Radius, EAsyncTraceType TraceType,
+	const FOmniBVHQueryFilter& Filter, TArray<FHitResult>& OutHits) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FOmniStaticBVHSnapshot::Trace);
+
+	//Only the hits of this trace are sorted and truncated, whatever the caller already had is left alone
+	const int32 FirstHit = OutHits.Num();
+
+	for(const TSharedRef<const FOmniStaticBVH, ESPMode::ThreadSafe>& LevelBVH : LevelBVHs)
+	{
+		if(TraceType == EAsyncTraceType::Test)
+		{
+			LevelBVH->Cast(Start, End, Radius, Filter, false, true, OutHits);
+			if(OutHits.Num() > FirstHit)
+			{
+				//Test traces only report that something was hit, same as UOmniTraceLibrary
+				OutHits.SetNum(FirstHit, EAllowShrinking::No);
+				OutHits.Add(FHitResult());
+				return;
+			}
+			continue;
+		}
+
+		LevelBVH->Cast(Start, End, Radius, Filter, TraceType == EAsyncTraceType::Multi, false, OutHits);
+	}
+
+	const TArrayView<FHitResult> Hits = MakeArrayView(OutHits).RightChop(FirstHit);
+	if(Hits.Num() <= 1)
+	{
+		return;
+	}
+
+	//Touches go before a block at the same distance, physics reports the block last
+	Hits.Sort([](const FHitResult& A, const FHitResult& B)
+	{
+		return A.Distance < B.Distance || (A.Distance == B.Distance && !A.bBlockingHit && B.bBlockingHit);
+	});
+
+	if(TraceType == EAsyncTraceType::Single)
+	{
+		OutHits.SetNum(FirstHit + 1, EAllowShrinking::No);
+		return;
+	}
+
+	//Every level stops at its own first block, only the closest one across all levels counts
+	const int32 FirstBlock = Hits.IndexOfByPredicate([](const FHitResult& HitResult)
+	{
+		return HitResult.bBlockingHit;
+	});
+	if(FirstBlock != INDEX_NONE)
+	{
+		OutHits.SetNum(FirstHit + FirstBlock + 1, EAllowShrinking::No);
+	}
+}
@@ -0,0 +1,30 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "World/OmniTraceLODPolicy.h"
+#include "OmniRuntimeMacros.h"
+
+Omni_ConsoleVariable(
+	OMNITOOLBOX_API, bool, EnableTraceLOD, true,
+	"OmniToolbox.Trace.LOD",
+	"Allow traces whose query has a LOD policy to be downgraded based on their distance to the viewer");
+
+bool UOmniTraceLODPolicy::IsLODEnabled()
+{
+	return EnableTraceLOD;
+}
+
+int32 UOmniTraceLODPolicy::FindLevel(double Distance) const
+{
+	int32 FoundLevel = INDEX_NONE;
+	for(int32 LevelIndex = 0; LevelIndex < Levels.Num(); ++LevelIndex)
+	{
+		if(Distance >= Levels[LevelIndex].MinDistance
+			&& (FoundLevel == INDEX_NONE || Levels[LevelIndex].MinDistance > Levels[FoundLevel].MinDistance))
+		{
+			FoundLevel = LevelIndex;
+		}
+	}
+
+	return FoundLevel;
+}
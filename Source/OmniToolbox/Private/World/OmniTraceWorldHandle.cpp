@@ -0,0 +1,87 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "World/OmniTraceWorldHandle.h"
+#include "Engine/World.h"
+#include "OmniRuntimeMacros.h"
+#include "Subsystems/OmniStaticBVHSubsystem.h"
+
+namespace OmniTraceWorldHandle
+{
+	/**Only accessed on the game thread*/
+	TMap<const UWorld*, TSharedPtr<FOmniTraceWorldLifetime, ESPMode::ThreadSafe>> Lifetimes;
+
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+	{
+		TSharedPtr<FOmniTraceWorldLifetime, ESPMode::ThreadSafe> Lifetime;
+		if(!Lifetimes.RemoveAndCopyValue(World, Lifetime))
+		{
+			return;
+		}
+
+		//Waits for every trace that is still running on this world
+		FWriteScopeLock WriteLock(Lifetime->Lock);
+		Lifetime->bIsAlive = false;
+	}
+}
+
+Omni_OnPostEngineInit()
+{
+	FWorldDelegates::OnWorldCleanup.AddStatic(&OmniTraceWorldHandle::OnWorldCleanup);
+}
+
+FOmniTraceWorldHandle::FOmniTraceWorldHandle(const UObject* WorldContextObject)
+{
+	checkf(IsInGameThread(), TEXT("FOmniTraceWorldHandle has to be created on the game thread"));
+
+	World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if(!World)
+	{
+		return;
+	}
+
+	PhysicsScene = World->GetPhysicsScene();
+
+	if(const UOmniStaticBVHSubsystem* StaticBVHSubsystem = World->GetSubsystem<UOmniStaticBVHSubsystem>())
+	{
+		StaticBVH = StaticBVHSubsystem->GetSnapshot();
+	}
+
+	TSharedPtr<FOmniTraceWorldLifetime, ESPMode::ThreadSafe>& WorldLifetime = OmniTraceWorldHandle::Lifetimes.FindOrAdd(World);
+	if(!WorldLifetime.IsValid())
+	{
+		WorldLifetime = MakeShared<FOmniTraceWorldLifetime, ESPMode::ThreadSafe>();
+	}
+	Lifetime = WorldLifetime;
+}
+
+bool FOmniTraceWorldHandle::IsValid() const
+{
+	if(!Lifetime.IsValid())
+	{
+		return false;
+	}
+
+	FReadScopeLock ReadLock(Lifetime->Lock);
+	return Lifetime->bIsAlive;
+}
+
+bool FOmniTraceWorldHandle::ExecuteRead(TFunctionRef<void(const UWorld& World)> Callable) const
+{
+	if(!Lifetime.IsValid())
+	{
+		return false;
+	}
+
+	FReadScopeLock ReadLock(Lifetime->Lock);
+	if(!Lifetime->bIsAlive)
+	{
+		return false;
+	}
+
+	//The physics scene is only swapped out when the world is torn down, which the lifetime already guards against
+	checkSlow(World->GetPhysicsScene() == PhysicsScene);
+
+	Callable(*World);
+	return true;
+}
@@ -0,0 +1,77 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**What a heatmap cell has counted*/
+enum class EOmniTraceHeatmapChannel : uint8
+{
+	Start,
+	End,
+	Hit,
+	Num
+};
+
+/**A single cell of the heatmap, as returned by FOmniTraceHeatmap::GatherCells*/
+struct FOmniTraceHeatmapCell
+{
+	FName TraceTag;
+	FIntVector Cell = FIntVector::ZeroValue;
+	uint32 Counts[static_cast<int32>(EOmniTraceHeatmapChannel::Num)] = {};
+
+	uint32 GetTotal() const { return Counts[0] + Counts[1] + Counts[2]; }
+};
+
+/**
+ * Bins the start, end and hit points of every trace into a sparse 3D grid per TraceTag,
+ * to find out where in the world traces are concentrated.
+ *
+ * The grid is a fixed size open addressing hash table of atomic counters, so recording
+ * never takes a lock and is safe from any thread, including ParallelFor batches.
+ * Once the table or the tag slots are full, new cells and tags are counted as dropped.
+ *
+ * Opt-in through OmniToolbox.Trace.Heatmap, the cell size is set through
+ * OmniToolbox.Trace.HeatmapCellSize. Change the cell size before recording,
+ * or clear the heatmap after changing it.
+ *
+ * Console commands:
+ * - OmniToolbox.Trace.HeatmapExport writes a CSV, or a PNG slice, to Saved/OmniTrace.
+ * - OmniToolbox.Trace.HeatmapDraw draws the busiest cells through the debug draw subsystem.
+ * - OmniToolbox.Trace.HeatmapClear resets every counter.
+ */
+class OMNITOOLBOX_API FOmniTraceHeatmap
+{
+public:
+
+	/**Controlled through OmniToolbox.Trace.Heatmap*/
+	static bool IsEnabled();
+
+	/**Record a trace. Only call this after checking IsEnabled.*/
+	static void RecordTrace(FName TraceTag, const FVector& Start, const FVector& End, TConstArrayView<FHitResult> HitResults);
+
+	/**Record a single point. Only call this after checking IsEnabled.*/
+	static void RecordPoint(FName TraceTag, const FVector& Location, EOmniTraceHeatmapChannel Channel);
+
+	/**Copy every cell that has been recorded. Leave @TraceTag unset to get every tag.
+	 * Not synchronized with recording, cells that are being written may be slightly off.*/
+	static void GatherCells(TArray<FOmniTraceHeatmapCell>& OutCells, TOptional<FName> TraceTag = TOptional<FName>());
+
+	/**Reset every counter. Traces that are running at the same time may still end up in the old cells.*/
+	static void Clear();
+
+	/**Cells and tags that could not be added because the heatmap was full*/
+	static int64 GetNumDroppedPoints();
+
+	static float GetCellSize();
+
+	/**Returns the path of the written file, or an empty string if it failed*/
+	static FString ExportCsv(TOptional<FName> TraceTag);
+
+	/**Sums every cell whose Z cell index is within @MinCellZ and @MaxCellZ into a top down PNG.
+	 * Returns the path of the written file, or an empty string if it failed*/
+	static FString ExportPng(TOptional<FName> TraceTag, int32 MinCellZ, int32 MaxCellZ);
+
+	/**Draw the @MaxCells busiest cells as boxes, colored by how busy they are*/
+	static void DrawCells(UWorld* World, TOptional<FName> TraceTag, int32 MaxCells, float Lifetime);
+};
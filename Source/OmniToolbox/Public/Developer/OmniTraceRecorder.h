@@ -0,0 +1,104 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+
+/**Which of the UOmniTraceLibrary paths a recorded trace originally went through*/
+enum class EOmniRecordedTracePath : uint8
+{
+	Sync,
+	Async,
+	Batch
+};
+
+/**Channel and responses shared by any amount of recorded traces.
+ * Ignored actors are not recorded, they can't be resolved when replaying.*/
+struct FOmniRecordedQuery
+{
+	ECollisionChannel Channel = ECC_WorldStatic;
+	FCollisionResponseContainer Responses;
+	bool bTraceComplex = false;
+	FName TraceTag;
+
+	bool operator==(const FOmniRecordedQuery& Other) const
+	{
+		return Channel == Other.Channel && FMemory::Memcmp(&Responses, &Other.Responses, sizeof(FCollisionResponseContainer)) == 0
+			&& bTraceComplex == Other.bTraceComplex && TraceTag == Other.TraceTag;
+	}
+
+	friend uint32 GetTypeHash(const FOmniRecordedQuery& Query)
+	{
+		uint32 Hash = HashCombineFast(GetTypeHash(static_cast<uint8>(Query.Channel)), FCrc::MemCrc32(&Query.Responses, sizeof(FCollisionResponseContainer)));
+		Hash = HashCombineFast(Hash, GetTypeHash(Query.bTraceComplex));
+		return HashCombineFast(Hash, GetTypeHash(Query.TraceTag));
+	}
+};
+
+struct FOmniRecordedTrace
+{
+	EOmniRecordedTracePath Path = EOmniRecordedTracePath::Sync;
+	EOmniTraceShape Shape = EOmniTraceShape::Line;
+	EAsyncTraceResultType ResultType = SingleResult;
+
+	/**Index into FOmniTraceRecording::Queries*/
+	uint16 QueryIndex = 0;
+
+	/**Frame the trace was recorded in, counted from the start of the recording*/
+	uint32 Frame = 0;
+
+	FVector3f Start = FVector3f::ZeroVector;
+	FVector3f End = FVector3f::ZeroVector;
+	FQuat4f Rotation = FQuat4f::Identity;
+
+	/**Radius for spheres, radius and half height for capsules, the extent for boxes*/
+	FVector3f ShapeParams = FVector3f::ZeroVector;
+
+	FCollisionShape MakeCollisionShape() const;
+};
+
+struct FOmniTraceRecording
+{
+	TArray<FOmniRecordedQuery> Queries;
+	TArray<FOmniRecordedTrace> Traces;
+	uint32 NumFrames = 0;
+};
+
+/**
+ * Records every trace that goes through the UOmniTraceLibrary into a compact
+ * binary file, so the exact same mix of queries can be replayed later
+ * through FOmniTraceReplay or the OmniTraceReplay commandlet.
+ *
+ * Unique channel and response combinations are only written once,
+ * every trace after that refers to them by index.
+ *
+ * Started and stopped through OmniToolbox.Trace.StartRecording and
+ * OmniToolbox.Trace.StopRecording.
+ */
+class OMNITOOLBOX_API FOmniTraceRecorder
+{
+public:
+
+	static bool IsRecording();
+
+	/**Start writing every trace to @FilePath. When empty, a new file
+	 * is created inside of Saved/OmniTrace.
+	 * Returns false if the file could not be created.*/
+	static bool StartRecording(const FString& FilePath = FString());
+
+	/**Returns the path of the recording that was stopped, or an empty string if nothing was being recorded*/
+	static FString StopRecording();
+
+	/**Safe to call from any thread. Every trace is written to the same file in the order
+	 * it was traced, so recording serializes traces from worker threads on a shared lock.
+	 * Expect parallel traces to slow down while recording.*/
+	static void RecordTrace(EOmniRecordedTracePath Path, EOmniTraceShape Shape, const FVector& Start, const FVector& End,
+		const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, ECollisionChannel Channel,
+		const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams);
+
+	static bool LoadRecording(const FString& FilePath, FOmniTraceRecording& OutRecording);
+
+	/**Marks the end of a frame in the recording, called at the end of every frame*/
+	static void OnEndFrame();
+};
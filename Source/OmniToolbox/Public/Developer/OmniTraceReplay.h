@@ -0,0 +1,111 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Developer/OmniTraceRecorder.h"
+#include "OmniTraceReplay.generated.h"
+
+/**Throughput and latency of replaying a recording through one of the trace paths.
+ * What a single latency sample covers depends on the path:
+ * - Sync: a single trace.
+ * - Batched: a single BatchTraceByQuery call.
+ * - Async: from queuing a trace until its callback is executed.*/
+struct OMNITOOLBOX_API FOmniTraceReplayReport
+{
+	FString Path;
+	int32 NumTraces = 0;
+	int32 NumResults = 0;
+	double TotalSeconds = 0;
+
+	double P50Ms = 0;
+	double P90Ms = 0;
+	double P99Ms = 0;
+	double MaxMs = 0;
+
+	/**Async traces that never completed*/
+	int32 NumLost = 0;
+
+	double GetTracesPerSecond() const { return TotalSeconds > 0 ? NumTraces / TotalSeconds : 0.0; }
+
+	/**Sorts @LatenciesMs and fills in the percentiles*/
+	void SetLatencies(TArray<double>& LatenciesMs);
+
+	FString ToString() const;
+};
+
+/**Receives the callbacks of async traces during a replay*/
+UCLASS(Transient)
+class OMNITOOLBOX_API UOmniTraceReplayListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Start tracking a frame worth of async traces that were just queued*/
+	void AddFrame(int32 NumTraces);
+
+	bool HasPendingTraces() const { return NumPending > 0; }
+
+	UFUNCTION()
+	void OnTraceCompleted(const TArray<FHitResult>& HitResults);
+
+	TArray<double> LatenciesMs;
+	int32 NumResults = 0;
+	int32 NumPending = 0;
+
+private:
+
+	/**Every trace of a frame is dispatched before any trace of the frame after it,
+	 * so callbacks always belong to the oldest frame that still has pending traces.*/
+	struct FPendingFrame
+	{
+		double QueueTime = 0;
+		int32 NumRemaining = 0;
+	};
+
+	TArray<FPendingFrame> PendingFrames;
+	int32 OldestFrame = 0;
+};
+
+/**
+ * Replays a recording made by FOmniTraceRecorder through the sync,
+ * batched and async paths of the UOmniTraceLibrary, so the performance
+ * of the paths can be compared using the exact same mix of queries.
+ *
+ * Sync and batched replays can be started in game through
+ * OmniToolbox.Trace.Replay. The async replay needs control over the
+ * world's ticking, which the OmniTraceReplay commandlet provides.
+ */
+class OMNITOOLBOX_API FOmniTraceReplay
+{
+public:
+
+	explicit FOmniTraceReplay(const FOmniTraceRecording& InRecording);
+
+	FOmniTraceReplayReport RunSync(UWorld* World) const;
+
+	/**Every recorded frame is replayed as one batch per query*/
+	FOmniTraceReplayReport RunBatched(UWorld* World) const;
+
+	/**Queues every recorded frame and calls @StepFrame to advance the world
+	 * by one frame, until every trace has completed.
+	 * @MaxExtraFrames How many frames to wait after the last frame has been queued,
+	 * before the remaining traces are considered lost.*/
+	FOmniTraceReplayReport RunAsync(UWorld* World, TFunctionRef<void()> StepFrame, int32 MaxExtraFrames = 60) const;
+
+	/**Write the reports into a CSV file inside of Saved/OmniTrace.
+	 * Returns the path of the file, or an empty string if it failed.*/
+	static FString WriteReportsToCsv(TConstArrayView<FOmniTraceReplayReport> Reports);
+
+private:
+
+	const FOmniTraceRecording& Recording;
+
+	/**Compiled version of every recorded query*/
+	TArray<FOmniTraceQuery> Queries;
+
+	/**Index of the first trace of every frame, with one extra entry at the end*/
+	TArray<int32> FrameStarts;
+};
@@ -0,0 +1,85 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+
+/**Everything that has been recorded for a single TraceTag*/
+struct FOmniTraceTagStats
+{
+	static constexpr int32 NumShapes = static_cast<int32>(EOmniTraceShape::Box) + 1;
+	static constexpr int32 NumResultTypes = TestResult + 1;
+
+	int64 Calls = 0;
+
+	/**Async traces are counted, but their time is spent
+	 * inside of the async trace system and can't be measured.*/
+	int64 AsyncCalls = 0;
+
+	/**Calls that returned at least one result*/
+	int64 CallsWithHits = 0;
+	int64 TotalResults = 0;
+
+	uint64 TotalCycles = 0;
+	uint64 MaxCycles = 0;
+
+	int64 CallsByShape[NumShapes] = {};
+	int64 ResultsByShape[NumShapes] = {};
+	int64 CallsByResultType[NumResultTypes] = {};
+	int64 ResultsByResultType[NumResultTypes] = {};
+
+	/**Calls since the last frame ended, used for the Insights counters*/
+	int64 CallsThisFrame = 0;
+
+	double GetHitRatio() const { return Calls > 0 ? static_cast<double>(CallsWithHits) / Calls : 0.0; }
+};
+
+/**
+ * Collects statistics for every trace that goes through the UOmniTraceLibrary,
+ * grouped by the TraceTag of the trace. Useful for finding out which systems
+ * are using up the physics query budget.
+ *
+ * The results are available through:
+ * - "stat OmniTrace", which has a cycle counter for every tag.
+ * - Unreal Insights, which has an OmniTrace/<Tag> counter track with the calls per frame.
+ * - "OmniToolbox.Trace.DumpTagStats", which writes everything to a CSV file.
+ *
+ * Off by default, since every game thread trace takes a shared lock while recording.
+ * Worker threads record into a buffer of their own instead, which is merged into
+ * the shared stats at the end of every frame, or when the stats are read.
+ * Turn it on through OmniToolbox.Trace.TagStats while profiling.
+ */
+class OMNITOOLBOX_API FOmniTraceStats
+{
+public:
+
+	static bool IsEnabled();
+
+	/**Record a single trace. Safe to call from any thread, worker threads
+	 * only show up in the stats once their buffer has been merged.
+	 * @Cycles should be 0 for async traces.*/
+	static void RecordTrace(FName TraceTag, EOmniTraceShape Shape, EAsyncTraceResultType ResultType, int32 NumResults,
+		uint64 Cycles, bool bAsync = false);
+
+	/**Record every request of a batch trace at once, always through the shared lock.
+	 * The cycles of the whole batch are spread evenly over the requests.*/
+	static void RecordBatch(FName TraceTag, TConstArrayView<FOmniTraceRequest> Requests, const FOmniBatchTraceResult& Results,
+		uint64 Cycles);
+
+#if STATS
+	/**Dynamic cycle stat for the tag, so it shows up under "stat OmniTrace"*/
+	static TStatId GetTagStatId(FName TraceTag);
+#endif
+
+	static TMap<FName, FOmniTraceTagStats> GetSnapshot();
+
+	static void Reset();
+
+	/**Write every recorded tag into a CSV file inside of Saved/OmniTrace.
+	 * Returns the path of the file, or an empty string if it failed.*/
+	static FString DumpToCsv();
+
+	/**Pushes the calls of this frame to Insights, called at the end of every frame*/
+	static void OnEndFrame();
+};
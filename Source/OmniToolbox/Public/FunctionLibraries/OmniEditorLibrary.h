@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Subsystems/OmniDebugDrawSubsystem.h"
 #include "OmniEditorLibrary.generated.h"
 
 #define Omni_Notification(Message) UOmniEditorLibrary::SendNotification(#Message);
@@ -61,42 +62,73 @@ public:
 	
 	UFUNCTION(BlueprintCallable, Category = "OmniToolbox|Editor", meta = (CallableWithoutWorldContext, DevelopmentOnly))
 	static void EnableVislogRecordingToFile(bool bEnabled);
+
+	/**Every DrawAndLog function ends up here.
+	 * From the game thread the shape is added right away and its handle is returned.
+	 * Any other thread queues the shape and gets an unset handle back. */
+	static FOmniDebugShapeHandle DrawAndLogShape(UObject* WorldContextObject, FOmniDebugDrawCommand&& Command, FName Key);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=7))
-	static void DrawAndLogCapsule(UObject* WorldContextObject, FVector Center, float HalfHeight, float Radius, FQuat Rotation, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, 
+	static FOmniDebugShapeHandle DrawAndLogCapsule(UObject* WorldContextObject, FVector Center, float HalfHeight, float Radius, FQuat Rotation, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, 
 		FName LogCategory = TEXT("VisLog"), float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogLine(UObject* WorldContextObject, FVector Start, FVector End, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"),
+	static FOmniDebugShapeHandle DrawAndLogLine(UObject* WorldContextObject, FVector Start, FVector End, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"),
+		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
+	
+	/**Draws a line through every point in order, as a single shape*/
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=5))
+	static FOmniDebugShapeHandle DrawAndLogPolyline(UObject* WorldContextObject, const TArray<FVector>& Points, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"),
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogCone(UObject* WorldContextObject, FVector Start, FVector Direction, float Length, float Angle, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"),
+	static FOmniDebugShapeHandle DrawAndLogCone(UObject* WorldContextObject, FVector Start, FVector Direction, float Length, float Angle, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"),
 	                           float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogCircle(UObject* WorldContextObject, FVector Center, FVector UpAxis, float Radius, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogCircle(UObject* WorldContextObject, FVector Center, FVector UpAxis, float Radius, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogBox(UObject* WorldContextObject, FVector Center, FVector Extent, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogBox(UObject* WorldContextObject, FVector Center, FVector Extent, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogRotatedBox(UObject* WorldContextObject, FVector Center, FVector Extent, FQuat Rotation, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogRotatedBox(UObject* WorldContextObject, FVector Center, FVector Extent, FQuat Rotation, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogSphere(UObject* WorldContextObject, FVector Center, float Radius, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogSphere(UObject* WorldContextObject, FVector Center, float Radius, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogArrow(UObject* WorldContextObject, FVector Start, FVector End, float ArrowSize, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogArrow(UObject* WorldContextObject, FVector Start, FVector End, float ArrowSize, FString Key = "", FString Text = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float Thickness = 1.5);
 	
 	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject", AdvancedDisplay=6))
-	static void DrawAndLogText(UObject* WorldContextObject, FVector Location, FString Text = "", FString Key = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
+	static FOmniDebugShapeHandle DrawAndLogText(UObject* WorldContextObject, FVector Location, FString Text = "", FString Key = "", FLinearColor Color = FLinearColor::White, FName LogCategory = TEXT("VisLog"), 
 		float Lifetime = 3, bool bAddToMessageLog = false, bool bWireframe = true, EDrawDebugSceneDepthPriorityGroup DepthPriority = EDrawDebugSceneDepthPriorityGroup::World, float FontSize = 1);
+
+	/**False once the shape has expired or has been removed*/
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintPure, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static bool IsDebugShapeValid(UObject* WorldContextObject, FOmniDebugShapeHandle Handle);
+
+	/**Get the handle of a shape that was drawn with @Key*/
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintPure, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static FOmniDebugShapeHandle FindDebugShape(UObject* WorldContextObject, FString Key);
+
+	/**Move the entire shape so its center, start or first point is at @Location*/
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static bool MoveDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, FVector Location);
+
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static bool RecolorDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, FLinearColor Color);
+
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static bool ExtendDebugShapeLifetime(UObject* WorldContextObject, FOmniDebugShapeHandle Handle, float Seconds);
+
+	UFUNCTION(Category = "OmniToolbox|Draw Debug", BlueprintCallable, meta = (DevelopmentOnly, WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+	static bool RemoveDebugShape(UObject* WorldContextObject, FOmniDebugShapeHandle Handle);
 	
 #pragma endregion
 };
@@ -5,9 +5,19 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Engine/EngineTypes.h"
+#include "CollisionShape.h"
+#include "CollisionQueryParams.h"
+#include "Engine/OverlapResult.h"
+#include "Engine/NetSerialization.h"
+#include "Stats/Stats.h"
+#include "World/OmniTraceWorldHandle.h"
 #include "OmniTraceLibrary.generated.h"
 
+DECLARE_STATS_GROUP(TEXT("OmniTrace"), STATGROUP_OmniTrace, STATCAT_Advanced);
+
 struct FTraceSetting;
+class UOmniTraceLODPolicy;
+class USplineComponent;
 
 // Define a struct for trace debugging options
 USTRUCT(BlueprintType)
@@ -117,8 +127,605 @@ struct FOmniTraceChannelSettings
     TEnumAsByte<ETraceTypeQuery> TraceType;
 };
 
+/**A reusable trace setup.
+ * The profile, channel override, custom responses and ignored actors
+ * are resolved once when the query is made, instead of every time
+ * a trace is performed. Create one through @MakeTraceQuery and pass it
+ * to the "ByQuery" trace functions.
+ *
+ * If any of the settings are changed after the query has been made,
+ * @Compile has to be called again. */
+USTRUCT(BlueprintType)
+struct OMNITOOLBOX_API FOmniTraceQuery
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames"))
+    FName Profile;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FOmniTraceChannelSettings TraceSettings;
+
+    /**Assign unique responses to specific channels on top of the profile*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FTraceChannelAndResponseContainer CustomChannelResponses;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    bool TraceComplex = false;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    TArray<TObjectPtr<AActor>> IgnoredActors;
+
+    /**Tag used to provide extra information or filtering for debugging of the trace (e.g. Collision Analyzer)*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FName TraceTag;
+
+    /**How many frames the results of traces using this query are cached for.
+     * Identical traces performed within that time are served from the cache
+     * instead of going back to physics. 1 means only the current frame.
+     * 0 disables caching. */
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+    int32 CacheFrames = 0;
+
+    /**Line and sphere traces go through the UOmniStaticBVHSubsystem instead of physics,
+     * which only contains static geometry and simple collision.
+     * Falls back to physics when the BVH is disabled, has not been built yet
+     * or @TraceComplex is enabled.*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    bool UseStaticBVH = false;
+
+    /**Downgrades or skips traces based on their distance to the viewer.
+     * Only used by the sync and async trace functions.*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    TObjectPtr<UOmniTraceLODPolicy> LODPolicy;
+
+    /**Resolve the settings above into the channel and params used by the traces.*/
+    void Compile();
+
+    /**Compile the query from a channel and params that have already been resolved,
+     * skipping the profile entirely. Used when replaying recorded traces.*/
+    void CompileFrom(ECollisionChannel InChannel, const FCollisionQueryParams& InQueryParams, const FCollisionResponseParams& InResponseParams);
+
+    bool IsCompiled() const { return bCompiled; }
+
+    ECollisionChannel GetChannel() const { return Channel; }
+    const FCollisionResponseParams& GetResponseParams() const { return ResponseParams; }
+    const FCollisionQueryParams& GetQueryParams() const { return QueryParams; }
+
+    /**Hash of the channel, responses and ignored actors.
+     * Only used to find cache entries, the trace cache compares the full query.*/
+    uint32 GetCacheHash() const { return CacheHash; }
+
+    /**Unique IDs of the ignored actors, sorted so the order they were added in doesn't matter*/
+    TConstArrayView<uint32> GetSortedIgnoredActorIds() const { return SortedIgnoredActorIds; }
+
+private:
+
+    /**Shared by Compile and CompileFrom, so both produce the same hash for the same query*/
+    void UpdateCacheHash();
+
+    bool bCompiled = false;
+    ECollisionChannel Channel = ECC_WorldStatic;
+    FCollisionResponseParams ResponseParams;
+    FCollisionQueryParams QueryParams;
+    TArray<uint32, TInlineAllocator<8>> SortedIgnoredActorIds;
+    uint32 CacheHash = 0;
+};
+
+UENUM(BlueprintType)
+enum class EOmniTraceShape : uint8
+{
+    Line,
+    Sphere,
+    Capsule,
+    Box
+};
+
+/**A single entry for @BatchTrace. Which shape parameters are
+ * used depends on the @Shape, the rest is ignored.*/
+USTRUCT(BlueprintType)
+struct FOmniTraceRequest
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    EOmniTraceShape Shape = EOmniTraceShape::Line;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FVector Start = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FVector End = FVector::ZeroVector;
+
+    /**Used by capsule and box traces*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    /**Used by sphere and capsule traces*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    float Radius = 0;
+
+    /**Used by capsule traces*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    float HalfHeight = 0;
+
+    /**Used by box traces*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FVector Extent = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    TEnumAsByte<EAsyncTraceResultType> ResultType = SingleResult;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames"))
+    FName Profile;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FOmniTraceChannelSettings TraceSettings;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    bool TraceComplex = false;
+
+    FCollisionShape MakeCollisionShape() const;
+};
+
+/**Where the hit results for a request are stored inside of
+ * FOmniBatchTraceResult::HitResults */
+USTRUCT(BlueprintType)
+struct FOmniTraceResultRange
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 Offset = 0;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 Num = 0;
+};
+
+/**Results of a @BatchTrace. All hits are stored in one
+ * contiguous buffer, @Ranges has one entry per request
+ * which points into that buffer.
+ * Reusing the same result struct between calls will reuse
+ * the memory that has already been allocated. */
+USTRUCT(BlueprintType)
+struct FOmniBatchTraceResult
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FHitResult> HitResults;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniTraceResultRange> Ranges;
+
+    TArrayView<const FHitResult> GetHitResultsForRequest(int32 RequestIndex) const
+    {
+        if(!Ranges.IsValidIndex(RequestIndex))
+        {
+            return TArrayView<const FHitResult>();
+        }
+
+        return TArrayView<const FHitResult>(HitResults.GetData() + Ranges[RequestIndex].Offset, Ranges[RequestIndex].Num);
+    }
+};
+
+/**A single overlapping component, a Blueprint friendly version of FOverlapResult*/
+USTRUCT(BlueprintType)
+struct FOmniOverlapResult
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TObjectPtr<UPrimitiveComponent> Component;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TObjectPtr<AActor> Actor;
+
+    /**Index of the body that was overlapped, for components with multiple bodies*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 ItemIndex = INDEX_NONE;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    bool bBlockingHit = false;
+
+    FOmniOverlapResult() = default;
+    explicit FOmniOverlapResult(const FOverlapResult& Overlap);
+};
+
+/**A single overlap query. Which shape parameters are
+ * used depends on the @Shape. Lines can't overlap anything
+ * and are ignored.*/
+USTRUCT(BlueprintType)
+struct FOmniOverlapRequest
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    EOmniTraceShape Shape = EOmniTraceShape::Sphere;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FVector Location = FVector::ZeroVector;
+
+    /**Used by capsule and box overlaps*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    /**Used by sphere and capsule overlaps*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    float Radius = 50;
+
+    /**Used by capsule overlaps*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    float HalfHeight = 100;
+
+    /**Used by box overlaps*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FVector Extent = FVector(50);
+
+    FCollisionShape MakeCollisionShape() const;
+};
+
+/**Results of a @BatchOverlap.
+ * Reusing the same result struct between calls will reuse
+ * the memory that has already been allocated. */
+USTRUCT(BlueprintType)
+struct FOmniBatchOverlapResult
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniOverlapResult> Overlaps;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniTraceResultRange> Ranges;
+
+    TArrayView<const FOmniOverlapResult> GetOverlapsForRequest(int32 RequestIndex) const
+    {
+        if(!Ranges.IsValidIndex(RequestIndex))
+        {
+            return TArrayView<const FOmniOverlapResult>();
+        }
+
+        return TArrayView<const FOmniOverlapResult>(Overlaps.GetData() + Ranges[RequestIndex].Offset, Ranges[RequestIndex].Num);
+    }
+
+    /**Per request scratch memory, kept around so it can be reused*/
+    TArray<TArray<FOverlapResult>> ScratchOverlaps;
+};
+
+/**A single entry for @MassTrace. Multiple requests
+ * can share the same GUID, their results are grouped together.*/
+USTRUCT(BlueprintType)
+struct FOmniMassTraceRequest
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FGuid TraceGUID;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    FOmniTraceRequest Trace;
+};
+
+/**Results of a @MassTrace, grouped by GUID.
+ * Every hit result lives in a single array, @Ranges has one
+ * range per entry in @TraceGUIDs pointing into that array.*/
+USTRUCT(BlueprintType)
+struct FOmniMassTraceResults
+{
+    GENERATED_BODY()
+
+    /**Every unique GUID, in the order they first appeared in the requests*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FGuid> TraceGUIDs;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FHitResult> HitResults;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniTraceResultRange> Ranges;
+
+    TArrayView<const FHitResult> GetHitResultsForGUID(const FGuid& TraceGUID) const
+    {
+        const int32* GuidIndex = GuidIndices.Find(TraceGUID);
+        if(!GuidIndex)
+        {
+            return TArrayView<const FHitResult>();
+        }
+
+        return TArrayView<const FHitResult>(HitResults.GetData() + Ranges[*GuidIndex].Offset, Ranges[*GuidIndex].Num);
+    }
+
+    void Reset()
+    {
+        TraceGUIDs.Reset();
+        HitResults.Reset();
+        Ranges.Reset();
+        GuidIndices.Reset();
+    }
+
+    TMap<FGuid, int32> GuidIndices;
+};
+
+/**A much smaller version of FHitResult for bulk traces.
+ * The component is stored as an index into the
+ * FOmniCompactTraceResults::Components array.*/
+USTRUCT(BlueprintType)
+struct FOmniCompactHit
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    float Distance = 0;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FVector ImpactPoint = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FVector ImpactNormal = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 ComponentIndex = INDEX_NONE;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    bool bBlockingHit = false;
+};
+
+/**A hit result that is cheap to replicate.
+ * The impact point and location are quantized to 0.1cm, the normal to 16 bits per axis
+ * and the distance to 0.1cm. Everything else is sent as bit packed flags.
+ * The actor is only sent when the component can't be referenced over the network,
+ * otherwise it's taken from the component's owner.*/
+USTRUCT(BlueprintType)
+struct OMNITOOLBOX_API FOmniNetHit
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TWeakObjectPtr<AActor> Actor;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TWeakObjectPtr<UPrimitiveComponent> Component;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FVector_NetQuantize10 ImpactPoint = FVector::ZeroVector;
+
+    /**Where the shape ended up. Only sent when it differs from the impact point, which is always the case for sweeps.*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FVector_NetQuantize10 Location = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FVector_NetQuantizeNormal ImpactNormal = FVector::ZeroVector;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    float Distance = 0;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    bool bBlockingHit = false;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    bool bStartPenetrating = false;
+
+    FOmniNetHit() = default;
+    explicit FOmniNetHit(const FHitResult& HitResult);
+
+    /**Anything that isn't replicated, such as the face index or bone name, is left at its default.*/
+    FHitResult ToHitResult() const;
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FOmniNetHit> : public TStructOpsTypeTraitsBase2<FOmniNetHit>
+{
+    enum
+    {
+        WithNetSerializer = true
+    };
+};
+
+/**Array of FOmniNetHit that serializes its size packed,
+ * meant to be used as a replicated property or RPC parameter.*/
+USTRUCT(BlueprintType)
+struct OMNITOOLBOX_API FOmniNetHitArray
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniNetHit> Hits;
+
+    /**Arrays received with more hits than this are rejected*/
+    static constexpr int32 MaxHits = 1024;
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FOmniNetHitArray> : public TStructOpsTypeTraitsBase2<FOmniNetHitArray>
+{
+    enum
+    {
+        WithNetSerializer = true
+    };
+};
+
+/**Results of a @BatchTraceCompact.
+ * @TestResults has one bit per request, which is set if the request hit anything.
+ * Test traces only write to @TestResults, single and multi traces also
+ * write their hits into @Hits, with @Ranges pointing into that buffer.
+ *
+ * Pass the same results into every call. Once the buffers have grown
+ * large enough, no more memory will be allocated. */
+USTRUCT(BlueprintType)
+struct FOmniCompactTraceResults
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniCompactHit> Hits;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FOmniTraceResultRange> Ranges;
+
+    /**Every unique component that was hit*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly, Transient)
+    TArray<TObjectPtr<UPrimitiveComponent>> Components;
+
+    TBitArray<> TestResults;
+
+    bool WasHit(int32 RequestIndex) const
+    {
+        return TestResults.IsValidIndex(RequestIndex) && TestResults[RequestIndex];
+    }
+
+    TArrayView<const FOmniCompactHit> GetHitsForRequest(int32 RequestIndex) const
+    {
+        if(!Ranges.IsValidIndex(RequestIndex))
+        {
+            return TArrayView<const FOmniCompactHit>();
+        }
+
+        return TArrayView<const FOmniCompactHit>(Hits.GetData() + Ranges[RequestIndex].Offset, Ranges[RequestIndex].Num);
+    }
+
+    /**Clears the results without releasing any memory*/
+    void Reset()
+    {
+        Hits.Reset();
+        Ranges.Reset();
+        Components.Reset();
+        TestResults.SetNumUninitialized(0);
+    }
+};
+
+UENUM(BlueprintType)
+enum class EOmniFanTracePattern : uint8
+{
+    /**A flat arc on the horizontal plane of the rotation, @Angle degrees to either side*/
+    Fan,
+    /**A cone around the forward vector with a half angle of @Angle degrees*/
+    Cone,
+    /**Every direction in front of the rotation, @Angle is ignored*/
+    Hemisphere
+};
+
+UENUM(BlueprintType)
+enum class EOmniFanTraceDistribution : uint8
+{
+    /**Evenly spaced, the same directions every call*/
+    Uniform,
+    /**Low discrepancy spiral, covers the area more evenly than Uniform at low ray counts*/
+    GoldenSpiral,
+    /**Every ray is randomly offset inside of its own slice of the area*/
+    Jittered
+};
+
+USTRUCT(BlueprintType)
+struct FOmniFanTraceSettings
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    EOmniFanTracePattern Pattern = EOmniFanTracePattern::Cone;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    EOmniFanTraceDistribution Distribution = EOmniFanTraceDistribution::GoldenSpiral;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 1))
+    int32 NumRays = 64;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 180, Units = "Degrees"))
+    float Angle = 45;
+
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+    float Range = 1000;
+
+    /**Only used by the jittered distribution. The same seed always produces the same rays.*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    int32 Seed = 0;
+};
+
+/**Results of a fan trace. Every array has one entry per ray.
+ * Reusing the same result struct between calls will reuse
+ * the memory that has already been allocated. */
+USTRUCT(BlueprintType)
+struct FOmniFanTraceResult
+{
+    GENERATED_BODY()
+
+    /**World space direction of every ray*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<FVector> Directions;
+
+    /**Distance to the first blocking hit of every ray, or the range if nothing was hit*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    TArray<float> Distances;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 NumBlockingHits = 0;
+
+    /**Fraction of the rays that did not hit anything, 1 means the entire area is visible*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    float VisibleFraction = 1;
+
+    /**Index of the ray with the closest blocking hit, INDEX_NONE if nothing was hit*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 NearestRayIndex = INDEX_NONE;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FHitResult NearestHit;
+
+    TArray<FOmniTraceRequest> Requests;
+    FOmniBatchTraceResult BatchResults;
+};
+
+/**A single path for @BatchPolylineTraceByQuery*/
+USTRUCT(BlueprintType)
+struct FOmniPolylineTraceRequest
+{
+    GENERATED_BODY()
+
+    /**Every segment between two points is swept in order*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+    TArray<FVector> Points;
+
+    /**0 performs line traces, anything above sweeps a sphere*/
+    UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+    float Radius = 0;
+};
+
+/**Result of a polyline or spline trace. Only the first
+ * blocking hit along the path is reported.*/
+USTRUCT(BlueprintType)
+struct FOmniPolylineTraceResult
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    bool bBlockingHit = false;
+
+    /**Index of the segment that was hit, segment 0 goes from point 0 to point 1.
+     * INDEX_NONE if nothing was hit.*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    int32 SegmentIndex = INDEX_NONE;
+
+    /**How far along the hit segment the hit happened, from 0 to 1*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    float SegmentAlpha = 0;
+
+    /**Distance along the entire path until the hit, or the length of the path if nothing was hit*/
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    float Distance = 0;
+
+    UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+    FHitResult HitResult;
+};
+
 DECLARE_DYNAMIC_DELEGATE_OneParam(FAsyncTraceResultDelegate, const TArray<FHitResult>&, HitResult);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FMassTraceResultDelegate, FMassTraceResult, TraceResult);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FAsyncOverlapResultDelegate, const TArray<FOmniOverlapResult>&, Overlaps);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FMassTraceCompletedDelegate, const FOmniMassTraceResults&, TraceResults);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FPolylineTraceCompletedDelegate, const TArray<FOmniPolylineTraceResult>&, Results);
 
 /**
  * 
@@ -147,7 +754,20 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
     static void FilterHitResultsByLineOfSight(TArray<FHitResult>& HitResultsToFilter, UObject* WorldContextObject, const FVector& Start,
         UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
-    
+
+    /**Async version of FilterHitResultsByLineOfSight.
+     * Every line of sight trace is submitted to the async trace system together,
+     * @OnFilterCompleted receives the filtered hit results the frame after.
+     * Every line of sight trace is drawn once it has completed, if @DebugOptions has debugging enabled. */
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncFilterHitResultsByLineOfSight(const TArray<FHitResult>& HitResultsToFilter, UObject* WorldContextObject, const FVector& Start,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors,
+        FAsyncTraceResultDelegate OnFilterCompleted, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Removes every hit result whose entry in @HasLineOfSight is false,
+     * while keeping the order of the remaining hit results.*/
+    static void RemoveHitResultsWithoutLineOfSight(TArray<FHitResult>& HitResults, TConstArrayView<bool> HasLineOfSight);
+
     /**Perform a line trace.
      * @ResultType Is this a multi, single or test trace?
      * @CustomChannelResponses Allows you to assign unique responses to specific channels.
@@ -219,18 +839,293 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
     static void AsyncBoxTrace(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const FVector& Extent, TEnumAsByte<EAsyncTraceResultType> ResultType,
         const TArray<AActor*>& IgnoredActors, UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, FAsyncTraceResultDelegate OnTraceCompleted, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
-    
 
+#pragma region Query
+
+    /**Create a reusable trace query. Resolving the profile and the ignored actors
+     * only happens once here, instead of for every trace.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static FOmniTraceQuery MakeTraceQuery(UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings,
+        const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceChannelAndResponseContainer CustomChannelResponses = FTraceChannelAndResponseContainer(), FName TraceTag = NAME_None);
+
+    /**Same as FilterHitResultsByLineOfSight, but with a precompiled query.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void FilterHitResultsByLineOfSightByQuery(TArray<FHitResult>& HitResultsToFilter, UObject* WorldContextObject, const FVector& Start,
+        const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Same as AsyncFilterHitResultsByLineOfSight, but with a precompiled query.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncFilterHitResultsByLineOfSightByQuery(const TArray<FHitResult>& HitResultsToFilter, UObject* WorldContextObject, const FVector& Start,
+        const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnFilterCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FHitResult> LineTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, TEnumAsByte<EAsyncTraceResultType> ResultType,
+        const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncLineTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, TEnumAsByte<EAsyncTraceResultType> ResultType,
+        const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FHitResult> SphereTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType,
+        const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncSphereTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, const float Radius, TEnumAsByte<EAsyncTraceResultType> ResultType,
+        const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FHitResult> CapsuleTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const float Radius, const float HalfHeight,
+        TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncCapsuleTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const float Radius, const float HalfHeight,
+        TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FHitResult> BoxTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const FVector& Extent,
+        TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncBoxTraceByQuery(UObject* WorldContextObject, const FVector& Start, const FVector& End, FRotator Rotation, const FVector& Extent,
+        TEnumAsByte<EAsyncTraceResultType> ResultType, const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Same as BatchTrace, but every request uses the same query.
+     * The profile and trace settings of the requests are ignored.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void BatchTraceByQuery(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests, const FOmniTraceQuery& Query,
+        FOmniBatchTraceResult& OutResults, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Native entry point every sync "ByQuery" function goes through.
+     * Game thread only, worker threads should use TraceByQueryThreadSafe instead.*/
+    static TArray<FHitResult> TraceByQuery(const UWorld* World, EOmniTraceShape Shape, const FVector& Start, const FVector& End, const FQuat& Rotation,
+        const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query, FTraceDebug DebugOptions);
+
+    /**Same as TraceByQuery, but safe to call from any thread, such as UE::Tasks or ParallelFor bodies.
+     * @World has to be created on the game thread beforehand.
+     * @Query has to be compiled on the game thread beforehand as well.
+     *
+     * Skips the trace cache and debug drawing, since those live on the game thread.
+     * Queries with UseStaticBVH go through the snapshot @World captured when it was created.
+     * Trace stats are buffered per thread and the heatmap is lock free, but the trace
+     * recorder serializes every worker thread on its lock while it is recording.
+     * Returns false if nothing was hit, or if the world has been cleaned up in the meantime.*/
+    static bool TraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, EOmniTraceShape Shape, const FVector& Start, const FVector& End,
+        const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query,
+        TArray<FHitResult>& OutHits);
+
+    /**Line trace version of TraceByQueryThreadSafe*/
+    static bool LineTraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, const FVector& Start, const FVector& End,
+        EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query, TArray<FHitResult>& OutHits);
+
+    /**Native entry point every async "ByQuery" function goes through.*/
+    static void AsyncTraceByQuery(UWorld* World, EOmniTraceShape Shape, const FVector& Start, const FVector& End, const FQuat& Rotation,
+        const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query, const FAsyncTraceResultDelegate& OnTraceCompleted, FTraceDebug DebugOptions);
+
+#pragma endregion
+
+    /**Perform a batch of traces of any shape in parallel.
+     * Collision profiles are only resolved once per unique profile and
+     * the query params are shared between every request.
+     * Results are written into @OutResults, which has one range per request.
+     * Pass in the same result struct every frame to avoid reallocating it.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void BatchTrace(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests, const TArray<AActor*>& IgnoredActors,
+        FOmniBatchTraceResult& OutResults, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Perform a batch of traces in parallel and store the results in the much
+     * smaller FOmniCompactHit format. Test traces only set a bit in
+     * FOmniCompactTraceResults::TestResults and never produce a hit.
+     * Every request uses the same query, the profile and trace settings of the
+     * requests are ignored.
+     * @Results should be reused between calls. Its buffers, and the scratch memory
+     * kept per calling thread, stop allocating once they are large enough.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void BatchTraceCompact(UObject* WorldContextObject, const TArray<FOmniTraceRequest>& Requests, const FOmniTraceQuery& Query,
+        UPARAM(ref) FOmniCompactTraceResults& Results);
+
+    /**Did a request of a compact batch trace hit anything?*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static bool WasCompactTraceHit(const FOmniCompactTraceResults& Results, int32 RequestIndex);
+
+    /**Returns a copy of the compact hits that belong to a specific request of a compact batch trace.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static TArray<FOmniCompactHit> GetCompactTraceHits(const FOmniCompactTraceResults& Results, int32 RequestIndex);
+
+    /**Perform a batch of traces in parallel, grouping the results by their GUID.
+     * Works the same as @BatchTrace, but every request that shares a GUID
+     * ends up in the same range of @OutResults.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void MassTrace(UObject* WorldContextObject, const TArray<FOmniMassTraceRequest>& Requests, const TArray<AActor*>& IgnoredActors,
+        FOmniMassTraceResults& OutResults, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Async version of @MassTrace. Every GUID is traced by its own task on a worker thread.
+     * The results are delivered on the game thread by the UOmniAsyncTraceSubsystem:
+     * @OnGroupCompleted is executed for every GUID as soon as its traces are done and
+     * @OnTraceCompleted is executed once with the results of every request.
+     * Both are executed with empty results if there is nothing to trace with.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncMassTrace(UObject* WorldContextObject, const TArray<FOmniMassTraceRequest>& Requests, const TArray<AActor*>& IgnoredActors,
+        FMassTraceCompletedDelegate OnTraceCompleted, FMassTraceResultDelegate OnGroupCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Returns a copy of the hit results that belong to a specific GUID of a mass trace.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static FMassTraceResult GetMassTraceResult(const FOmniMassTraceResults& MassResults, FGuid TraceGUID);
+
+    /**Returns a copy of the hit results that belong to a specific request of a batch trace.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static TArray<FHitResult> GetBatchTraceHitResults(const FOmniBatchTraceResult& BatchResult, int32 RequestIndex);
+
+    /**Convert hit results into their replicated form, to send them to clients.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static FOmniNetHitArray MakeNetHits(const TArray<FHitResult>& HitResults);
+
+    /**Convert replicated hits back into regular hit results.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static TArray<FHitResult> BreakNetHits(const FOmniNetHitArray& NetHits);
+
+    /**Native versions of @MakeNetHits and @BreakNetHits that reuse the output arrays*/
+    static void ToNetHits(TConstArrayView<FHitResult> HitResults, TArray<FOmniNetHit>& OutNetHits);
+    static void FromNetHits(TConstArrayView<FOmniNetHit> NetHits, TArray<FHitResult>& OutHitResults);
+
+    /**Trace a fan, cone or hemisphere of rays from @Origin in the direction of @Rotation.
+     * Every ray is a single line trace and they're all performed as one batch.
+     * @Result receives the distance of every ray, along with the nearest hit
+     * and how much of the area is visible. Pass in the same result every frame
+     * to avoid reallocating it.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void FanTrace(UObject* WorldContextObject, const FVector& Origin, FRotator Rotation, const FOmniFanTraceSettings& Settings,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings,
+        const TArray<AActor*>& IgnoredActors, UPARAM(ref) FOmniFanTraceResult& Result, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void FanTraceByQuery(UObject* WorldContextObject, const FVector& Origin, FRotator Rotation, const FOmniFanTraceSettings& Settings,
+        const FOmniTraceQuery& Query, UPARAM(ref) FOmniFanTraceResult& Result, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Generate the world space ray directions used by @FanTrace, without tracing anything.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static TArray<FVector> GetFanTraceDirections(FRotator Rotation, const FOmniFanTraceSettings& Settings);
+
+    static void GenerateFanTraceDirections(const FQuat& Rotation, const FOmniFanTraceSettings& Settings, TArray<FVector>& OutDirections);
+
+    /**Sweep every segment of a path in order, stopping at the first blocking hit.
+     * Useful for projectile arcs and other paths that would otherwise need one trace per segment.
+     * A @Radius of 0 performs line traces.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static FOmniPolylineTraceResult PolylineTrace(UObject* WorldContextObject, const TArray<FVector>& Points, float Radius,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings,
+        const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static FOmniPolylineTraceResult PolylineTraceByQuery(UObject* WorldContextObject, const TArray<FVector>& Points, float Radius,
+        const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Same as @PolylineTraceByQuery, the path is sampled along @Spline every @SampleDistance.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static FOmniPolylineTraceResult SplineTraceByQuery(UObject* WorldContextObject, const USplineComponent* Spline, float SampleDistance, float Radius,
+        const FOmniTraceQuery& Query, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**World space points along @Spline, every @SampleDistance. The last point is always the end of the spline.*/
+    static void GetSplineTracePoints(const USplineComponent* Spline, float SampleDistance, TArray<FVector>& OutPoints);
+
+    /**Trace many paths in parallel, every path uses the same query.
+     * @OutResults has one entry per path.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void BatchPolylineTraceByQuery(UObject* WorldContextObject, const TArray<FOmniPolylineTraceRequest>& Paths, const FOmniTraceQuery& Query,
+        TArray<FOmniPolylineTraceResult>& OutResults, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Same as @PolylineTraceByQuery, but safe to call from any thread.
+     * Has the same requirements as TraceByQueryThreadSafe and skips debug drawing as well.*/
+    static void PolylineTraceByQueryThreadSafe(const FOmniTraceWorldHandle& World, TConstArrayView<FVector> Points, float Radius,
+        const FOmniTraceQuery& Query, FOmniPolylineTraceResult& OutResult);
+
+    /**Async version of @BatchPolylineTraceByQuery. The paths are traced in parallel on worker threads
+     * and @OnTraceCompleted is executed once with every result, during the first tick of the
+     * UOmniAsyncTraceSubsystem after they are done. It is executed with no results if there is nothing to trace with.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncBatchPolylineTraceByQuery(UObject* WorldContextObject, const TArray<FOmniPolylineTraceRequest>& Paths, const FOmniTraceQuery& Query,
+        FPolylineTraceCompletedDelegate OnTraceCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+#pragma region Overlap
+
+    /**Find every component overlapping a sphere.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FOmniOverlapResult> SphereOverlap(UObject* WorldContextObject, const FVector& Location, const float Radius,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Find every component overlapping a box.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FOmniOverlapResult> BoxOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation, const FVector& Extent,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Find every component overlapping a capsule.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FOmniOverlapResult> CapsuleOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation, const float Radius, const float HalfHeight,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, const TArray<AActor*>& IgnoredActors, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Start an async sphere overlap. @OnOverlapCompleted is executed the frame after.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncSphereOverlap(UObject* WorldContextObject, const FVector& Location, const float Radius, const TArray<AActor*>& IgnoredActors,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Start an async box overlap. @OnOverlapCompleted is executed the frame after.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncBoxOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation, const FVector& Extent, const TArray<AActor*>& IgnoredActors,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Start an async capsule overlap. @OnOverlapCompleted is executed the frame after.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncCapsuleOverlap(UObject* WorldContextObject, const FVector& Location, FRotator Rotation, const float Radius, const float HalfHeight, const TArray<AActor*>& IgnoredActors,
+        UPARAM(Meta=(GetOptions="Engine.KismetSystemLibrary.GetCollisionProfileNames")) FName Profile, FOmniTraceChannelSettings TraceSettings, FAsyncOverlapResultDelegate OnOverlapCompleted, bool TraceComplex = false, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Find every component overlapping the shape of the @Request, with a precompiled query.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static TArray<FOmniOverlapResult> OverlapByQuery(UObject* WorldContextObject, const FOmniOverlapRequest& Request, const FOmniTraceQuery& Query,
+        FTraceDebug DebugOptions = FTraceDebug());
+
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void AsyncOverlapByQuery(UObject* WorldContextObject, const FOmniOverlapRequest& Request, const FOmniTraceQuery& Query,
+        FAsyncOverlapResultDelegate OnOverlapCompleted, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Perform a batch of overlaps in parallel. Every request uses the same query.
+     * Results are written into @OutResults, which has one range per request.
+     * Pass in the same result struct every frame to avoid reallocating it.*/
+    UFUNCTION(BlueprintCallable, Category = "Helpers Library|Trace Helpers", meta = (WorldContext = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
+    static void BatchOverlap(UObject* WorldContextObject, const TArray<FOmniOverlapRequest>& Requests, const FOmniTraceQuery& Query,
+        FOmniBatchOverlapResult& OutResults, FTraceDebug DebugOptions = FTraceDebug());
+
+    /**Returns a copy of the overlaps that belong to a specific request of a batch overlap.*/
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Helpers Library|Trace Helpers")
+    static TArray<FOmniOverlapResult> GetBatchOverlapResults(const FOmniBatchOverlapResult& BatchResult, int32 RequestIndex);
+
+    /**Native entry points every overlap function above ends up in.*/
+    static void OverlapShapeByQuery(const UWorld* World, EOmniTraceShape Shape, const FVector& Location, const FQuat& Rotation,
+        const FCollisionShape& CollisionShape, const FOmniTraceQuery& Query, TArray<FOmniOverlapResult>& OutOverlaps, FTraceDebug DebugOptions);
+    static void AsyncOverlapShapeByQuery(UWorld* World, EOmniTraceShape Shape, const FVector& Location, const FQuat& Rotation,
+        const FCollisionShape& CollisionShape, const FOmniTraceQuery& Query, const FAsyncOverlapResultDelegate& OnOverlapCompleted, FTraceDebug DebugOptions);
+
+#pragma endregion
 
 #pragma region Debug
 
     /**Draw debug boxes for the hit results.
      * Returns true if any blocking hit was found */
-    static bool DebugHitResults(const UObject* WorldContext, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult);
-    static void HandleLineTraceDebug(const UObject* WorldContext, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult);
-    static void HandleSphereTraceDebug(const UObject* WorldContext, const float Radius, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult);
-    static void HandleCapsuleTraceDebug(const UObject* WorldContext, const float Radius, const float HalfHeight, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult);
-    static void HandleBoxTraceDebug(const UObject* WorldContext, const FVector& Shape, const FTraceDebug& DebugOptions, TArray<FHitResult> HitResult);
+    static bool DebugHitResults(const UObject* WorldContext, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+    static void HandleLineTraceDebug(const UObject* WorldContext, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+    static void HandleSphereTraceDebug(const UObject* WorldContext, const float Radius, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+    static void HandleCapsuleTraceDebug(const UObject* WorldContext, const float Radius, const float HalfHeight, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+    static void HandleBoxTraceDebug(const UObject* WorldContext, const FVector& Shape, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+    /**Calls the debug function that matches the @Shape*/
+    static void HandleShapeTraceDebug(const UObject* WorldContext, EOmniTraceShape Shape, const FCollisionShape& CollisionShape, const FTraceDebug& DebugOptions, const TArray<FHitResult>& HitResult);
+
+    /**Draws the overlap shape at DebugOptions.Start*/
+    static void HandleOverlapDebug(const UObject* WorldContext, EOmniTraceShape Shape, const FCollisionShape& CollisionShape, const FTraceDebug& DebugOptions, TConstArrayView<FOmniOverlapResult> Overlaps);
+
+    static void HandleFanTraceDebug(const UObject* WorldContext, const FVector& Origin, const FOmniFanTraceResult& Result, const FTraceDebug& DebugOptions);
+
+    /**Draws the part of the path up until the hit with a single polyline*/
+    static void HandlePolylineTraceDebug(const UObject* WorldContext, TConstArrayView<FVector> Points, const FOmniPolylineTraceResult& Result,
+        const FTraceDebug& DebugOptions, FName Key);
     
 #pragma endregion
 };
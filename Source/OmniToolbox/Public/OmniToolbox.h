@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+OMNITOOLBOX_API DECLARE_LOG_CATEGORY_EXTERN(LogOmniToolbox, Log, All);
+
 class FOmniToolboxModule : public IModuleInterface
 {
 public:
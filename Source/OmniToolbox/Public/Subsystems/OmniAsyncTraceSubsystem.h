@@ -0,0 +1,259 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "WorldCollision.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "World/OmniTraceWorldHandle.h"
+#include "OmniAsyncTraceSubsystem.generated.h"
+
+/**Everything needed to submit an async trace and to
+ * dispatch its result once it has completed.
+ * Slots are recycled once their result has been dispatched. */
+struct FOmniAsyncTraceSlot
+{
+	EOmniTraceShape Shape = EOmniTraceShape::Line;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FCollisionShape CollisionShape;
+	EAsyncTraceType TraceType = EAsyncTraceType::Single;
+	ECollisionChannel Channel = ECC_WorldStatic;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+
+	FAsyncTraceResultDelegate OnTraceCompleted;
+	FTraceDebug DebugOptions;
+
+	FTraceHandle Handle;
+};
+
+/**Same as FOmniAsyncTraceSlot, but for async overlaps*/
+struct FOmniAsyncOverlapSlot
+{
+	EOmniTraceShape Shape = EOmniTraceShape::Sphere;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FCollisionShape CollisionShape;
+	ECollisionChannel Channel = ECC_WorldStatic;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+
+	FAsyncOverlapResultDelegate OnOverlapCompleted;
+	FTraceDebug DebugOptions;
+
+	FTraceHandle Handle;
+};
+
+/**A group of line of sight traces that are submitted together
+ * and filter @HitResults once every trace has completed.*/
+struct FOmniLineOfSightFilterJob
+{
+	TArray<FHitResult> HitResults;
+	TArray<FTraceHandle> Handles;
+	FVector Start = FVector::ZeroVector;
+	FAsyncTraceResultDelegate OnFilterCompleted;
+	FTraceDebug DebugOptions;
+};
+
+/**Everything the worker threads need to perform a mass trace.
+ * Built on the game thread and never modified afterwards,
+ * so every task of the mass trace can share it.*/
+struct FOmniMassTraceInput
+{
+	FOmniTraceWorldHandle World;
+
+	/**Sorted by GUID, every group is one contiguous range*/
+	TArray<FOmniTraceRequest> Requests;
+
+	/**Compiled once per unique profile and trace settings,
+	 * @QueryIndices has one entry per request pointing into it.*/
+	TArray<FOmniTraceQuery> Queries;
+	TArray<int32> QueryIndices;
+};
+
+/**The requests of a mass trace that share the same GUID.
+ * Each group is traced by its own task, so it can be dispatched
+ * as soon as its own traces are done.*/
+struct FOmniMassTraceGroup
+{
+	FGuid TraceGUID;
+	int32 FirstRequest = 0;
+	int32 NumRequests = 0;
+
+	/**Has one range per request of the group*/
+	UE::Tasks::TTask<FOmniBatchTraceResult> Task;
+	bool bDispatched = false;
+};
+
+struct FOmniMassTraceJob
+{
+	TSharedPtr<const FOmniMassTraceInput, ESPMode::ThreadSafe> Input;
+	TArray<FOmniMassTraceGroup> Groups;
+	int32 NumDispatchedGroups = 0;
+
+	FMassTraceCompletedDelegate OnTraceCompleted;
+	FMassTraceResultDelegate OnGroupCompleted;
+	FTraceDebug DebugOptions;
+};
+
+/**Same as FOmniMassTraceInput, but for a batch of polyline traces*/
+struct FOmniPolylineTraceInput
+{
+	FOmniTraceWorldHandle World;
+	TArray<FOmniPolylineTraceRequest> Paths;
+	FOmniTraceQuery Query;
+};
+
+struct FOmniPolylineTraceJob
+{
+	TSharedPtr<const FOmniPolylineTraceInput, ESPMode::ThreadSafe> Input;
+
+	/**Has one result per path*/
+	UE::Tasks::TTask<TArray<FOmniPolylineTraceResult>> Task;
+
+	FPolylineTraceCompletedDelegate OnTraceCompleted;
+	FTraceDebug DebugOptions;
+};
+
+/**
+ * Owns every async trace that is started through the UOmniTraceLibrary.
+ *
+ * Requests are gathered throughout the frame and submitted to the
+ * world's async trace system together during this subsystems tick.
+ * The frame after, every completed trace is dispatched in one pass.
+ *
+ * Slots are recycled instead of allocating a new FTraceDelegate for
+ * every trace, the results are polled through the trace handle instead.
+ * Async overlaps work the same way, but have their own pool of slots.
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniAsyncTraceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Queue an async trace to be submitted at the end of this frame.
+	 * @OnTraceCompleted is executed the frame after it has been submitted. */
+	void QueueTrace(EOmniTraceShape Shape, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& CollisionShape,
+		EAsyncTraceType TraceType, ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams,
+		const FAsyncTraceResultDelegate& OnTraceCompleted, const FTraceDebug& DebugOptions);
+
+	/**Queue an async overlap to be submitted at the end of this frame.
+	 * @OnOverlapCompleted is executed the frame after it has been submitted. */
+	void QueueOverlap(EOmniTraceShape Shape, const FVector& Location, const FQuat& Rotation, const FCollisionShape& CollisionShape,
+		ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams,
+		const FAsyncOverlapResultDelegate& OnOverlapCompleted, const FTraceDebug& DebugOptions);
+
+	/**Queue a line of sight trace from @Start to the impact point of every hit result.
+	 * @OnFilterCompleted receives the hit results that have line of sight,
+	 * the frame after they have been submitted. */
+	void QueueLineOfSightFilter(const TArray<FHitResult>& HitResults, const FVector& Start, ECollisionChannel Channel,
+		const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams, const FAsyncTraceResultDelegate& OnFilterCompleted,
+		const FTraceDebug& DebugOptions);
+
+	/**Start a mass trace on worker threads right away, one task per GUID.
+	 * @OnGroupCompleted is executed during the first tick after a GUID's traces are done,
+	 * @OnTraceCompleted is executed once every GUID has been dispatched.*/
+	void QueueMassTrace(const TArray<FOmniMassTraceRequest>& Requests, const TArray<AActor*>& IgnoredActors,
+		const FMassTraceCompletedDelegate& OnTraceCompleted, const FMassTraceResultDelegate& OnGroupCompleted, const FTraceDebug& DebugOptions);
+
+	/**Start a batch of polyline traces on a worker thread right away, @Query has to be compiled.
+	 * @OnTraceCompleted is executed once with the results of every path, during the first tick after they are done.*/
+	void QueuePolylineTrace(const TArray<FOmniPolylineTraceRequest>& Paths, const FOmniTraceQuery& Query,
+		const FPolylineTraceCompletedDelegate& OnTraceCompleted, const FTraceDebug& DebugOptions);
+
+	/**Amount of traces and overlaps that are waiting to be submitted to the async trace system*/
+	UFUNCTION(Category = "Omni Async Trace", BlueprintPure)
+	int32 GetNumPendingTraces() const { return PendingSlots.Num() + PendingOverlapSlots.Num(); }
+
+	/**Amount of traces and overlaps that have been submitted, but have not been dispatched yet*/
+	UFUNCTION(Category = "Omni Async Trace", BlueprintPure)
+	int32 GetNumInFlightTraces() const { return InFlightSlots.Num() + InFlightOverlapSlots.Num(); }
+
+	/**Amount of trace and overlap slots that are free and ready to be reused*/
+	UFUNCTION(Category = "Omni Async Trace", BlueprintPure)
+	int32 GetNumRecycledSlots() const { return FreeSlots.Num() + FreeOverlapSlots.Num(); }
+
+	/**Total amount of trace and overlap slots this subsystem has ever allocated*/
+	UFUNCTION(Category = "Omni Async Trace", BlueprintPure)
+	int32 GetNumAllocatedSlots() const { return Slots.Num() + OverlapSlots.Num(); }
+
+	/**How many times a trace or overlap has reused a recycled slot instead of allocating a new one*/
+	UFUNCTION(Category = "Omni Async Trace", BlueprintPure)
+	int64 GetNumSlotReuses() const { return SlotReuses; }
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UOmniAsyncTraceSubsystem, STATGROUP_Tickables);
+	}
+
+	virtual void Tick(float DeltaTime) override;
+
+	/**Editor utilities queue async traces as well, which would never complete otherwise*/
+	virtual bool IsTickableInEditor() const override { return true; }
+
+	virtual void Deinitialize() override;
+
+private:
+
+	int32 AllocateSlot();
+	void ReleaseSlot(int32 SlotIndex);
+
+	/**Dispatch every trace that has completed since the last tick*/
+	void DispatchCompletedTraces();
+
+	/**Submit every trace that has been queued this frame*/
+	void SubmitPendingTraces();
+
+	TArray<FOmniAsyncTraceSlot> Slots;
+	TArray<int32> FreeSlots;
+	TArray<int32> PendingSlots;
+	TArray<int32> InFlightSlots;
+
+	int32 AllocateOverlapSlot();
+	void ReleaseOverlapSlot(int32 SlotIndex);
+
+	void DispatchCompletedOverlaps();
+	void SubmitPendingOverlaps();
+
+	TArray<FOmniAsyncOverlapSlot> OverlapSlots;
+	TArray<int32> FreeOverlapSlots;
+	TArray<int32> PendingOverlapSlots;
+	TArray<int32> InFlightOverlapSlots;
+
+	/**Reused between frames to avoid reallocating them every tick*/
+	TArray<int32> CompletedOverlapSlots;
+	TArray<FOverlapDatum> CompletedOverlapData;
+	TArray<int32> ExpiredOverlapSlots;
+	TArray<FOmniOverlapResult> DispatchedOverlaps;
+
+	/**Line of sight filters are kept separate from the slots, since
+	 * they only dispatch once every one of their traces has completed.*/
+	void DispatchLineOfSightFilters();
+
+	TArray<FOmniLineOfSightFilterJob> LineOfSightFilters;
+
+	void DispatchMassTraces();
+
+	TArray<FOmniMassTraceJob> MassTraces;
+
+	/**Reused between mass traces to avoid reallocating them*/
+	FOmniMassTraceResults MassTraceResults;
+	TArray<FHitResult> MassTraceDebugHits;
+
+	void DispatchPolylineTraces();
+
+	TArray<FOmniPolylineTraceJob> PolylineTraces;
+
+	/**Reused between frames to avoid reallocating them every tick*/
+	TArray<int32> CompletedSlots;
+	TArray<FTraceDatum> CompletedData;
+	TArray<int32> ExpiredSlots;
+
+	int64 SlotReuses = 0;
+};
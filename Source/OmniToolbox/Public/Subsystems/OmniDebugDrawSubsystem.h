@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "Containers/Queue.h"
+#include "Components/LineBatchComponent.h"
 #include "OmniDebugDrawSubsystem.generated.h"
 
 UENUM()
@@ -17,12 +19,15 @@ enum EOmniDebugDrawType
 	Capsule,
 	Arrow,
 	Text,
-	Cone
+	Cone,
+	Polyline
 };
 
 /**In an effort to reduce development time for a debugging tool,
  * I've decided to make one monolithic struct for all debug types.
- * It's not pretty, but it's quick to implement. */
+ * It's not pretty, but it's quick to implement.
+ * This is only used to submit a shape, the subsystem stores
+ * each type in its own pool with only the data it needs. */
 USTRUCT()
 struct FOmniDebugDrawCommand
 {
@@ -34,6 +39,9 @@ struct FOmniDebugDrawCommand
 	
 	FVector End;
 	
+	/**Only used by polylines*/
+	TArray<FVector> Points;
+	
 	FVector Direction;
 	
 	FVector Extent;
@@ -70,9 +78,245 @@ struct FOmniDebugDrawCommand
 	float Lifetime = 3;
 };
 
+/**Refers to a shape in the UOmniDebugDrawSubsystem.
+ * The generation is bumped every time a slot is reused, so a handle
+ * to a shape that has expired never points at a different shape. */
+USTRUCT(BlueprintType)
+struct FOmniDebugShapeHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 SlotIndex = INDEX_NONE;
+
+	UPROPERTY()
+	uint32 Generation = 0;
+
+	bool IsSet() const { return SlotIndex != INDEX_NONE; }
+
+	bool operator==(const FOmniDebugShapeHandle& Other) const
+	{
+		return SlotIndex == Other.SlotIndex && Generation == Other.Generation;
+	}
+};
+
+/**Draw settings that every debug shape has*/
+struct FOmniDebugShapeStyle
+{
+	FColor Color = FColor::White;
+	uint8 DepthPriority = 0;
+	float Thickness = 0;
+};
+
+/**Everything a shape only needs when it's being logged.
+ * Kept apart from the geometry, so drawing doesn't have to touch it. */
+struct FOmniDebugShapeLog
+{
+	TWeakObjectPtr<UObject> Owner;
+	FName LogCategory;
+	FString Text;
+	bool AddMessageToLog = false;
+	bool Wireframe = false;
+};
+
+struct FOmniDebugCircle
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Circle;
+	FVector Center;
+	FQuat Rotation;
+	float Radius = 0;
+};
+
+struct FOmniDebugLine
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Line;
+	FVector Start;
+	FVector End;
+};
+
+struct FOmniDebugBox
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Box;
+	FVector Center;
+	FVector Extent;
+};
+
+struct FOmniDebugRotatedBox
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::RotatedBox;
+	FVector Center;
+	FVector Extent;
+	FQuat Rotation;
+};
+
+struct FOmniDebugSphere
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Sphere;
+	FVector Center;
+	float Radius = 0;
+};
+
+struct FOmniDebugCapsule
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Capsule;
+	/**Base of the capsule, not the center*/
+	FVector Base;
+	FQuat Rotation;
+	float HalfHeight = 0;
+	float Radius = 0;
+};
+
+struct FOmniDebugArrow
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Arrow;
+	FVector Start;
+	FVector End;
+	float ArrowSize = 0;
+};
+
+/**The text itself lives in FOmniDebugShapeLog*/
+struct FOmniDebugText
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Text;
+	FVector Location;
+};
+
+struct FOmniDebugCone
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Cone;
+	FVector Origin;
+	FVector Direction;
+	float Length = 0;
+	float AngleWidth = 0;
+	float AngleHeight = 0;
+};
+
+struct FOmniDebugPolyline
+{
+	static constexpr EOmniDebugDrawType Type = EOmniDebugDrawType::Polyline;
+	TArray<FVector> Points;
+};
+
+/**Dense storage for every shape of one type.
+ * Every array has the same length and shares the same index,
+ * so each pass only walks the arrays it actually needs.
+ * Shapes are removed by swapping the last shape into their place. */
+template<typename ShapeType>
+struct TOmniDebugShapePool
+{
+	TArray<ShapeType> Shapes;
+	TArray<FOmniDebugShapeStyle> Styles;
+	TArray<FOmniDebugShapeLog> Logs;
+	TArray<float> Lifetimes;
+	/**Index into UOmniDebugDrawSubsystem::ShapeSlots, which points back at this shape*/
+	TArray<int32> SlotIndices;
+	/**The lines each shape was tessellated into the last time it was drawn.
+	 * Only filled for shapes that live for several frames and fit in
+	 * OmniToolbox.Debug.MaxCachedDebugLines, cleared whenever the shape changes. */
+	TArray<TArray<FBatchedLine>> CachedLines;
+	/**Total amount of lines in @CachedLines*/
+	int32 NumCachedLines = 0;
+	/**Hash of the geometry, color and text, used to only send shapes to the visual logger when they change*/
+	TArray<uint32> ContentHashes;
+	/**Content hash at the time the shape was last sent to the visual logger*/
+	TArray<uint32> LoggedHashes;
+	TArray<float> TimeSinceLogged;
+
+	int32 Num() const { return Shapes.Num(); }
+
+	int32 Add(ShapeType&& Shape, const FOmniDebugShapeStyle& Style, FOmniDebugShapeLog&& Log, float Lifetime, int32 SlotIndex, uint32 ContentHash)
+	{
+		Styles.Add(Style);
+		Logs.Add(MoveTemp(Log));
+		Lifetimes.Add(Lifetime);
+		SlotIndices.Add(SlotIndex);
+		CachedLines.AddDefaulted();
+		ContentHashes.Add(ContentHash);
+		LoggedHashes.Add(0);
+		//New shapes are always logged on their first tick
+		TimeSinceLogged.Add(TNumericLimits<float>::Max());
+		return Shapes.Add(MoveTemp(Shape));
+	}
+
+	void Set(int32 Index, ShapeType&& Shape, const FOmniDebugShapeStyle& Style, FOmniDebugShapeLog&& Log, float Lifetime, uint32 ContentHash)
+	{
+		Shapes[Index] = MoveTemp(Shape);
+		Styles[Index] = Style;
+		Logs[Index] = MoveTemp(Log);
+		Lifetimes[Index] = Lifetime;
+		NumCachedLines -= CachedLines[Index].Num();
+		CachedLines[Index].Empty();
+		ContentHashes[Index] = ContentHash;
+	}
+
+	void RemoveAtSwap(int32 Index)
+	{
+		Shapes.RemoveAtSwap(Index, EAllowShrinking::No);
+		Styles.RemoveAtSwap(Index, EAllowShrinking::No);
+		Logs.RemoveAtSwap(Index, EAllowShrinking::No);
+		Lifetimes.RemoveAtSwap(Index, EAllowShrinking::No);
+		SlotIndices.RemoveAtSwap(Index, EAllowShrinking::No);
+		NumCachedLines -= CachedLines[Index].Num();
+		CachedLines.RemoveAtSwap(Index, EAllowShrinking::No);
+		ContentHashes.RemoveAtSwap(Index, EAllowShrinking::No);
+		LoggedHashes.RemoveAtSwap(Index, EAllowShrinking::No);
+		TimeSinceLogged.RemoveAtSwap(Index, EAllowShrinking::No);
+	}
+};
+
+/**A shape that was queued from any thread, waiting to be added during the next tick*/
+struct FOmniQueuedDebugDraw
+{
+	FOmniDebugDrawCommand Command;
+	FName Key;
+};
+
+/**Everything TickPool needs to know about the current frame*/
+struct FOmniDebugDrawFrame
+{
+	bool bDraw = false;
+	/**Submit lines to the line batchers ourselves, instead of through the DrawDebug* helpers*/
+	bool bBatchLines = false;
+	bool bIsVislogRecording = false;
+	/**Send every shape to the visual logger, regardless of whether it changed*/
+	bool bLogAllShapes = false;
+	float VislogKeyframeInterval = 0;
+	float WorldLineLifetime = 0;
+	float ForegroundLineLifetime = 0;
+};
+
+/**Where the shape of a handle currently lives.
+ * Shapes move around inside their pool, the slot keeps track of them. */
+struct FOmniDebugShapeSlot
+{
+	EOmniDebugDrawType Type = EOmniDebugDrawType::Circle;
+	/**Index inside the pool of @Type, INDEX_NONE while the slot is free*/
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 1;
+	/**NAME_None for shapes that were added without a key*/
+	FName Key;
+};
+
 /**
  * This subsystem is responsible for managing and drawing a list
- * of debug shapes and allowing them to be updated
+ * of debug shapes and allowing them to be updated.
+ *
+ * Every shape type has its own pool of packed arrays. Every shape gets
+ * a FOmniDebugShapeHandle, which can update, recolor, extend or remove it
+ * without any lookups. Shapes that were added with a key are also tracked
+ * in @KeyedShapes, so adding a shape with the same key updates it.
+ *
+ * Shapes can be queued from any thread through QueueShape. The queue
+ * is drained once at the start of every tick.
+ *
+ * Everything except text is tessellated into lines. Circles and spheres are
+ * built from a shared unit circle and sphere, other shapes that live for several
+ * frames are cached until they change, up to a budget of cached lines.
+ * The lines of every shape are gathered and handed to the world's line
+ * batcher in one call per depth priority.
+ *
+ * Shapes are only sent to the visual logger when they change, or once
+ * every keyframe interval, instead of every frame they are alive.
  */
 UCLASS()
 class OMNITOOLBOX_API UOmniDebugDrawSubsystem : public UTickableWorldSubsystem
@@ -81,9 +325,39 @@ class OMNITOOLBOX_API UOmniDebugDrawSubsystem : public UTickableWorldSubsystem
 	
 public:
 	
-	void AddShape(FOmniDebugDrawCommand Command, FName Key);
-	
-	TMap<FName, FOmniDebugDrawCommand> ShapesToDraw;
+	/**Add a shape to draw. If @Key is already in use, that shape is replaced
+	 * and keeps its handle. Game thread only. */
+	FOmniDebugShapeHandle AddShape(FOmniDebugDrawCommand Command, FName Key);
+
+	/**Same as AddShape, but safe to call from any thread.
+	 * The shape is added at the start of the next tick. */
+	void QueueShape(FOmniDebugDrawCommand&& Command, FName Key);
+
+	/**QueueShape on the subsystem of @World, for threads that can't call GetSubsystem.
+	 * Returns false if @World has no debug draw subsystem. */
+	static bool QueueShapeForWorld(const UWorld* World, FOmniDebugDrawCommand&& Command, FName Key);
+
+	/**Amount of shapes across every type*/
+	int32 GetNumShapes() const;
+
+	/**False once the shape has expired or has been removed*/
+	bool IsShapeValid(FOmniDebugShapeHandle Handle) const;
+
+	/**Find the handle of a shape that was added with @Key*/
+	FOmniDebugShapeHandle FindShape(FName Key) const;
+
+	/**Replace the shape with a new one, which can also be of a different type.
+	 * The handle and key stay the same. */
+	bool UpdateShape(FOmniDebugShapeHandle Handle, FOmniDebugDrawCommand Command);
+
+	/**Move the shape so its location, start or first point ends up at @Location*/
+	bool MoveShape(FOmniDebugShapeHandle Handle, const FVector& Location);
+
+	bool RecolorShape(FOmniDebugShapeHandle Handle, const FLinearColor& Color);
+
+	bool ExtendShapeLifetime(FOmniDebugShapeHandle Handle, float Seconds);
+
+	bool RemoveShape(FOmniDebugShapeHandle Handle);
 
 	virtual TStatId GetStatId() const override
 	{
@@ -91,8 +365,70 @@ public:
 	}
 	
 	virtual void Tick(float DeltaTime) override;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
 	
 	
 private:
-	static constexpr ELogVerbosity::Type DefaultVerbosity = ELogVerbosity::Log;
-};
+
+	/**Add every shape that has been queued since the last tick*/
+	void DrainQueuedShapes();
+
+	/**Lock free, any thread can push while only the game thread pops*/
+	TQueue<FOmniQueuedDebugDraw, EQueueMode::Mpsc> QueuedShapes;
+
+	/**Put the shape of @Command into the slot, replacing whatever shape it had*/
+	void SetShape(int32 SlotIndex, FOmniDebugDrawCommand& Command);
+
+	template<typename ShapeType>
+	void AddToPool(TOmniDebugShapePool<ShapeType>& Pool, ShapeType&& Shape, FOmniDebugDrawCommand& Command, int32 SlotIndex);
+
+	/**Remove a shape from its pool. The slot is released, unless the slot is about to get a new shape*/
+	template<typename ShapeType>
+	void RemoveFromPool(TOmniDebugShapePool<ShapeType>& Pool, int32 Index, bool bReleaseSlot = true);
+
+	/**Call @Functor with the pool of @Type*/
+	template<typename FunctorType>
+	void VisitPool(EOmniDebugDrawType Type, FunctorType&& Functor);
+
+	int32 AllocateSlot();
+
+	/**The slot of @Handle if it still refers to a shape, otherwise nullptr*/
+	const FOmniDebugShapeSlot* FindSlot(FOmniDebugShapeHandle Handle) const;
+
+	FOmniDebugShapeHandle MakeHandle(int32 SlotIndex) const;
+
+	template<typename ShapeType>
+	void TickPool(TOmniDebugShapePool<ShapeType>& Pool, float DeltaTime, const FOmniDebugDrawFrame& Frame);
+
+	TOmniDebugShapePool<FOmniDebugCircle> Circles;
+	TOmniDebugShapePool<FOmniDebugLine> Lines;
+	TOmniDebugShapePool<FOmniDebugBox> Boxes;
+	TOmniDebugShapePool<FOmniDebugRotatedBox> RotatedBoxes;
+	TOmniDebugShapePool<FOmniDebugSphere> Spheres;
+	TOmniDebugShapePool<FOmniDebugCapsule> Capsules;
+	TOmniDebugShapePool<FOmniDebugArrow> Arrows;
+	TOmniDebugShapePool<FOmniDebugText> Texts;
+	TOmniDebugShapePool<FOmniDebugCone> Cones;
+	TOmniDebugShapePool<FOmniDebugPolyline> Polylines;
+
+	TArray<FOmniDebugShapeSlot> ShapeSlots;
+	TArray<int32> FreeShapeSlots;
+
+	/**Key to index in @ShapeSlots*/
+	TMap<FName, int32> KeyedShapes;
+
+	/**Categories that have a vislog sample rate and aren't due for a sample this frame*/
+	TSet<FName> SuppressedVislogCategories;
+	TMap<FName, double> NextVislogCategorySampleTimes;
+
+	bool bWasVislogRecording = false;
+
+	/**Every line that is submitted this frame, reused between frames to avoid reallocating them*/
+	TArray<FBatchedLine> WorldLines;
+	TArray<FBatchedLine> ForegroundLines;
+
+	/**How many more lines can be cached during this tick*/
+	int32 CachedLineBudget = 0;
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "OmniLineOfSightSubsystem.generated.h"
+
+/**Identifies a pair that has been registered to the UOmniLineOfSightSubsystem*/
+USTRUCT(BlueprintType)
+struct FOmniLineOfSightHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FOmniLineOfSightHandle& Other) const { return Index == Other.Index && Serial == Other.Serial; }
+};
+
+struct FOmniLineOfSightPair
+{
+	TWeakObjectPtr<AActor> Observer;
+	TWeakObjectPtr<AActor> Target;
+	FVector ObserverOffset = FVector::ZeroVector;
+	FVector TargetOffset = FVector::ZeroVector;
+	FOmniTraceQuery Query;
+
+	float MoveThresholdSquared = 0;
+	float Timeout = 0;
+
+	FVector LastObserverLocation = FVector::ZeroVector;
+	FVector LastTargetLocation = FVector::ZeroVector;
+	double LastTraceTime = 0;
+
+	int32 Serial = 0;
+	bool bHasLineOfSight = false;
+	bool bHasBeenTraced = false;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnLineOfSightChanged, FOmniLineOfSightHandle, Handle, AActor*, Observer, AActor*, Target, bool, bHasLineOfSight);
+
+/**
+ * Keeps track of whether observers can see their targets.
+ *
+ * Pairs are only traced again once either of them has moved further
+ * than their move threshold, or once their timeout has expired.
+ * Every pair that needs to be traced is traced in one parallel batch
+ * during this subsystems tick and @OnLineOfSightChanged is broadcast
+ * for every pair whose visibility has changed.
+ *
+ * Pairs whose observer or target has been destroyed are removed automatically.
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniLineOfSightSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Start tracking whether @Observer can see @Target.
+	 * @Query The observer is always ignored, the target counts as visible if nothing is hit or if the target is hit.
+	 * @ObserverOffset @TargetOffset Added to the actor locations, for example to trace from the eyes of the observer.
+	 * @MoveThreshold How far either actor has to move before the pair is traced again.
+	 * @Timeout How many seconds can pass before the pair is traced again, even if nothing has moved. 0 or below disables the timeout.*/
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintCallable)
+	FOmniLineOfSightHandle RegisterPair(AActor* Observer, AActor* Target, const FOmniTraceQuery& Query, FVector ObserverOffset = FVector::ZeroVector,
+		FVector TargetOffset = FVector::ZeroVector, float MoveThreshold = 10, float Timeout = 0.5);
+
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintCallable)
+	void UnregisterPair(FOmniLineOfSightHandle Handle);
+
+	/**Returns the last known visibility of the pair.
+	 * Pairs are not traced until the next tick after being registered.*/
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintPure)
+	bool HasLineOfSight(FOmniLineOfSightHandle Handle) const;
+
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintPure)
+	bool IsPairValid(FOmniLineOfSightHandle Handle) const;
+
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintPure)
+	int32 GetNumPairs() const { return Pairs.Num(); }
+
+	/**How many pairs were traced during the last tick*/
+	UFUNCTION(Category = "Omni Line Of Sight", BlueprintPure)
+	int32 GetNumTracedPairsLastTick() const { return DirtyPairs.Num(); }
+
+	UPROPERTY(Category = "Omni Line Of Sight", BlueprintAssignable)
+	FOnLineOfSightChanged OnLineOfSightChanged;
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UOmniLineOfSightSubsystem, STATGROUP_Tickables);
+	}
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	const FOmniLineOfSightPair* FindPair(FOmniLineOfSightHandle Handle) const;
+
+	/**Gather every pair that has moved or timed out since it was last traced*/
+	void GatherDirtyPairs(double CurrentTime);
+
+	TSparseArray<FOmniLineOfSightPair> Pairs;
+	int32 NextSerial = 1;
+
+	/**Reused between frames to avoid reallocating them every tick*/
+	TArray<int32> DirtyPairs;
+	TArray<bool> DirtyResults;
+	TArray<FVector> DirtyObserverLocations;
+	TArray<FVector> DirtyTargetLocations;
+	TArray<const AActor*> DirtyTargets;
+	TArray<int32> PairsToRemove;
+};
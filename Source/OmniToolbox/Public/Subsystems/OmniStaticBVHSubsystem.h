@@ -0,0 +1,89 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "World/OmniStaticBVH.h"
+#include "OmniStaticBVHSubsystem.generated.h"
+
+/**
+ * Builds a FOmniStaticBVH of every static primitive for each level in the world,
+ * which can be queried from any thread without touching the physics scene.
+ *
+ * Simple collision is baked as triangles (convex and box elements),
+ * everything else falls back to its bounding box.
+ * Levels are gathered on the game thread when they're added to the world,
+ * their BVH is built on a worker thread and published in a new snapshot.
+ * Levels that are removed are dropped from the next snapshot.
+ *
+ * Grab a snapshot through @GetSnapshot and query it from any thread,
+ * or set FOmniTraceQuery::UseStaticBVH to route the trace library through it.
+ *
+ * Only created when OmniToolbox.Trace.StaticBVH is enabled.
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniStaticBVHSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Thread safe. The snapshot stays valid for as long as it is held on to,
+	 * even if a newer one has been published in the meantime.*/
+	FOmniStaticBVHSnapshotPtr GetSnapshot() const;
+
+	/**Gather the static primitives of @Level again and rebuild its BVH*/
+	void RebuildLevel(ULevel* Level);
+
+	UFUNCTION(Category = "Omni Static BVH", BlueprintCallable)
+	void RebuildAllLevels();
+
+	/**Amount of levels that are waiting for their BVH to finish building*/
+	UFUNCTION(Category = "Omni Static BVH", BlueprintPure)
+	int32 GetNumPendingBuilds() const { return PendingBuilds.Num(); }
+
+	UFUNCTION(Category = "Omni Static BVH", BlueprintPure)
+	int32 GetNumBuiltLevels() const { return LevelBVHs.Num(); }
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UOmniStaticBVHSubsystem, STATGROUP_Tickables);
+	}
+
+	virtual void Tick(float DeltaTime) override;
+
+	/**Gather every static primitive of @Level. Has to be called on the game thread.*/
+	static void GatherLevel(const ULevel* Level, FOmniStaticBVHBuildInput& OutInput);
+
+private:
+
+	void OnLevelAdded(ULevel* Level, UWorld* InWorld);
+	void OnLevelRemoved(ULevel* Level, UWorld* InWorld);
+
+	/**Publish a new snapshot with the BVH of every level*/
+	void PublishSnapshot();
+
+	struct FPendingBuild
+	{
+		TWeakObjectPtr<ULevel> Level;
+		UE::Tasks::TTask<TSharedRef<const FOmniStaticBVH, ESPMode::ThreadSafe>> Task;
+	};
+
+	TArray<FPendingBuild> PendingBuilds;
+
+	/**Only accessed on the game thread*/
+	TMap<TWeakObjectPtr<ULevel>, TSharedRef<const FOmniStaticBVH, ESPMode::ThreadSafe>> LevelBVHs;
+
+	mutable FRWLock SnapshotLock;
+	FOmniStaticBVHSnapshotPtr Snapshot;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -0,0 +1,120 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "OmniTraceCacheSubsystem.generated.h"
+
+/**Everything that makes two traces identical. Positions are
+ * quantized so traces that are practically the same still match.
+ * The query is stored in full, @QueryHash only speeds up the lookup.*/
+struct FOmniTraceCacheKey
+{
+	enum EQueryFlags : uint8
+	{
+		TraceComplex = 1 << 0,
+		UseStaticBVH = 1 << 1,
+	};
+
+	FIntVector Start = FIntVector::ZeroValue;
+	FIntVector End = FIntVector::ZeroValue;
+	FIntVector4 Rotation = FIntVector4(0, 0, 0, 0);
+	FIntVector ShapeExtent = FIntVector::ZeroValue;
+	EOmniTraceShape Shape = EOmniTraceShape::Line;
+	uint8 ResultType = 0;
+	uint8 Channel = 0;
+	uint8 QueryFlags = 0;
+	FCollisionResponseContainer Responses;
+	TArray<uint32, TInlineAllocator<8>> IgnoredActorIds;
+	uint32 QueryHash = 0;
+
+	bool operator==(const FOmniTraceCacheKey& Other) const
+	{
+		return QueryHash == Other.QueryHash
+			&& Start == Other.Start
+			&& End == Other.End
+			&& Rotation == Other.Rotation
+			&& ShapeExtent == Other.ShapeExtent
+			&& Shape == Other.Shape
+			&& ResultType == Other.ResultType
+			&& Channel == Other.Channel
+			&& QueryFlags == Other.QueryFlags
+			&& FMemory::Memcmp(&Responses, &Other.Responses, sizeof(FCollisionResponseContainer)) == 0
+			&& IgnoredActorIds == Other.IgnoredActorIds;
+	}
+
+	friend uint32 GetTypeHash(const FOmniTraceCacheKey& Key)
+	{
+		uint32 Hash = HashCombineFast(GetTypeHash(Key.Start), GetTypeHash(Key.End));
+		Hash = HashCombineFast(Hash, GetTypeHash(Key.Rotation));
+		Hash = HashCombineFast(Hash, GetTypeHash(Key.ShapeExtent));
+		Hash = HashCombineFast(Hash, static_cast<uint32>(Key.Shape) | Key.ResultType << 8 | Key.QueryFlags << 16);
+		return HashCombineFast(Hash, Key.QueryHash);
+	}
+};
+
+struct FOmniTraceCacheEntry
+{
+	TArray<FHitResult> HitResults;
+
+	/**The first frame this entry is no longer valid*/
+	uint64 ExpireFrame = 0;
+};
+
+/**
+ * Remembers the results of traces that opted into caching through
+ * FOmniTraceQuery::CacheFrames, so identical traces performed during
+ * the same frame (or the next few frames) don't go back to physics.
+ *
+ * Only traces performed on the game thread are cached.
+ * Hit and miss counters are available through "stat OmniTrace".
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniTraceCacheSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Controlled through OmniToolbox.Trace.EnableCache*/
+	static bool IsCacheEnabled();
+
+	static FOmniTraceCacheKey MakeKey(EOmniTraceShape Shape, const FVector& Start, const FVector& End, const FQuat& Rotation,
+		const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query);
+
+	/**Copies the cached hit results into @OutHitResults.
+	 * Returns false if nothing was cached for @Key, or if the entry has expired.*/
+	bool FindCachedTrace(const FOmniTraceCacheKey& Key, TArray<FHitResult>& OutHitResults);
+
+	void AddCachedTrace(const FOmniTraceCacheKey& Key, const TArray<FHitResult>& HitResults, int32 CacheFrames);
+
+	UFUNCTION(Category = "Omni Trace Cache", BlueprintCallable)
+	void ClearCache();
+
+	/**How many traces have been served from the cache since this world started*/
+	UFUNCTION(Category = "Omni Trace Cache", BlueprintPure)
+	int64 GetNumCacheHits() const { return CacheHits; }
+
+	/**How many cacheable traces had to go to physics since this world started*/
+	UFUNCTION(Category = "Omni Trace Cache", BlueprintPure)
+	int64 GetNumCacheMisses() const { return CacheMisses; }
+
+	UFUNCTION(Category = "Omni Trace Cache", BlueprintPure)
+	int32 GetNumCachedTraces() const { return Entries.Num(); }
+
+	virtual void Deinitialize() override;
+
+private:
+
+	/**Removes every expired entry, at most once per frame*/
+	void PruneExpiredEntries();
+
+	TMap<FOmniTraceCacheKey, FOmniTraceCacheEntry> Entries;
+
+	uint64 LastPruneFrame = 0;
+
+	int64 CacheHits = 0;
+	int64 CacheMisses = 0;
+};
@@ -0,0 +1,87 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "World/OmniTraceLODPolicy.h"
+#include "OmniTraceLODSubsystem.generated.h"
+
+/**
+ * Runtime state of every UOmniTraceLODPolicy used in this world.
+ * The policies themselves are shared assets, so the views, reference points,
+ * reused results and counters are kept here, per world and per policy.
+ *
+ * The trace library goes through this automatically for queries with a LOD policy.
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniTraceLODSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Measure distances for @Policy from @Location instead of the local player views.
+	 * Only affects this world.*/
+	UFUNCTION(Category = "Omni Trace LOD", BlueprintCallable)
+	void SetReferencePoint(const UOmniTraceLODPolicy* Policy, const FVector& Location);
+
+	/**Go back to measuring distances for @Policy from the local player views*/
+	UFUNCTION(Category = "Omni Trace LOD", BlueprintCallable)
+	void ClearReferencePoint(const UOmniTraceLODPolicy* Policy);
+
+	UFUNCTION(Category = "Omni Trace LOD", BlueprintPure)
+	FOmniTraceLODCounters GetLevelCounters(const UOmniTraceLODPolicy* Policy, int32 Level) const;
+
+	UFUNCTION(Category = "Omni Trace LOD", BlueprintCallable)
+	void ResetCounters(const UOmniTraceLODPolicy* Policy);
+
+	/**Decide which level of @Policy a trace falls into and how it should be downgraded.*/
+	FOmniTraceLODDecision Evaluate(const UOmniTraceLODPolicy& Policy, EOmniTraceShape Shape, const FVector& Start, const FVector& End,
+		const FQuat& Rotation, const FCollisionShape& CollisionShape, EAsyncTraceResultType ResultType, const FOmniTraceQuery& Query);
+
+	/**Copies the results of an earlier trace into @OutHitResults if the
+	 * level's cooldown has not expired yet.*/
+	bool FindReusableResult(const UOmniTraceLODPolicy& Policy, const FOmniTraceLODDecision& Decision, TArray<FHitResult>& OutHitResults);
+
+	/**Remember the results of a trace so they can be reused by the next one*/
+	void StoreResult(const UOmniTraceLODPolicy& Policy, const FOmniTraceLODDecision& Decision, const TArray<FHitResult>& HitResults);
+
+	/**Log the counters of every policy used in this world*/
+	void LogCounters() const;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	struct FReuseEntry
+	{
+		TArray<FHitResult> HitResults;
+		double ExpireTime = 0;
+	};
+
+	struct FPolicyState
+	{
+		TArray<FOmniTraceLODCounters> LevelCounters;
+		TMap<FOmniTraceCacheKey, FReuseEntry> ReuseEntries;
+		uint64 LastPruneFrame = 0;
+
+		FVector ReferencePoint = FVector::ZeroVector;
+		bool bUseReferencePoint = false;
+	};
+
+	/**Gathers the local player views, at most once per frame*/
+	void UpdateViewLocations();
+
+	/**Removes every expired entry of @State, at most once per frame*/
+	void PruneReuseEntries(FPolicyState& State) const;
+
+	static FOmniTraceLODCounters& GetCounters(const UOmniTraceLODPolicy& Policy, FPolicyState& State, int32 Level);
+
+	TMap<TObjectKey<UOmniTraceLODPolicy>, FPolicyState> PolicyStates;
+
+	/**Shared by every policy that doesn't use a reference point*/
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	uint64 ViewFrame = 0;
+};
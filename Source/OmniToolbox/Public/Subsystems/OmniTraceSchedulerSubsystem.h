@@ -0,0 +1,122 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "OmniTraceSchedulerSubsystem.generated.h"
+
+/**A trace that is waiting for the scheduler to have room for it*/
+struct FOmniScheduledTrace
+{
+	FOmniTraceRequest Request;
+	/**Compiled, and shared by every trace that was scheduled with the same query*/
+	TSharedPtr<const FOmniTraceQuery> Query;
+	FAsyncTraceResultDelegate OnTraceCompleted;
+	FTraceDebug DebugOptions;
+
+	int32 Priority = 0;
+
+	/**How many frames this trace is allowed to wait before it is dropped.
+	 * Below 0 means it will wait forever. Dropped traces complete without any hits.*/
+	int32 MaxStaleFrames = INDEX_NONE;
+
+	uint64 SubmitFrame = 0;
+
+	/**Keeps traces with the same priority in the order they were scheduled*/
+	uint64 Sequence = 0;
+};
+
+/**
+ * Spreads bursts of async traces over multiple frames.
+ *
+ * Traces are scheduled with a priority and a maximum amount of frames
+ * they are allowed to wait. Every tick, the highest priority traces are
+ * sent to the UOmniAsyncTraceSubsystem until the per frame budget
+ * is used up, the rest waits for the next frame.
+ * Traces that have waited longer than their maximum are dropped,
+ * their delegate is executed right away without any hits.
+ *
+ * Traces that are scheduled with the same query share a single compiled
+ * copy of it, instead of every trace copying the query and its ignored actors.
+ *
+ * The budget is controlled through OmniToolbox.Trace.SchedulerBudget,
+ * or through SetBudgetOverride. Queue depth, wait frames and dropped
+ * traces are available through "stat OmniTrace".
+ */
+UCLASS()
+class OMNITOOLBOX_API UOmniTraceSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**Schedule an async trace.
+	 * @Priority Higher priorities are issued first.
+	 * @MaxStaleFrames How many frames the trace may wait before it's dropped. Below 0 never drops the trace.
+	 * @OnTraceCompleted is executed once the trace has been issued and completed,
+	 * or without any hits once the trace has been dropped.*/
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintCallable)
+	void ScheduleTrace(const FOmniTraceRequest& Request, const FOmniTraceQuery& Query, FAsyncTraceResultDelegate OnTraceCompleted,
+		int32 Priority = 0, int32 MaxStaleFrames = -1, FTraceDebug DebugOptions = FTraceDebug());
+
+	/**Same as ScheduleTrace, for native callers that already share their query.
+	 * @Query has to be compiled and must not be modified while any of its traces are queued.*/
+	void ScheduleTraceShared(const FOmniTraceRequest& Request, const TSharedRef<const FOmniTraceQuery>& Query,
+		const FAsyncTraceResultDelegate& OnTraceCompleted, int32 Priority = 0, int32 MaxStaleFrames = -1, const FTraceDebug& DebugOptions = FTraceDebug());
+
+	/**Override the amount of traces that can be issued per frame.
+	 * Below 0 goes back to using OmniToolbox.Trace.SchedulerBudget.*/
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintCallable)
+	void SetBudgetOverride(int32 MaxTracesPerFrame) { BudgetOverride = MaxTracesPerFrame; }
+
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintPure)
+	int32 GetBudget() const;
+
+	/**Amount of traces waiting to be issued*/
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintPure)
+	int32 GetQueueDepth() const { return Queue.Num(); }
+
+	/**Average amount of frames a trace has waited before being issued*/
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintPure)
+	float GetAverageWaitFrames() const;
+
+	/**Amount of traces that were dropped because they waited too long*/
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintPure)
+	int64 GetNumDroppedTraces() const { return DroppedTraces; }
+
+	UFUNCTION(Category = "Omni Trace Scheduler", BlueprintPure)
+	int64 GetNumIssuedTraces() const { return IssuedTraces; }
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UOmniTraceSchedulerSubsystem, STATGROUP_Tickables);
+	}
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	/**Remove every trace that has waited longer than it's allowed to, and complete it without any hits*/
+	void DropStaleTraces();
+
+	/**The query the last Blueprint scheduled trace was given, reused for as long as the next ones match it*/
+	TSharedPtr<const FOmniTraceQuery> LastQuery;
+	bool bLastQueryWasCompiled = false;
+
+	/**Reused between frames to avoid reallocating them every tick*/
+	TArray<FAsyncTraceResultDelegate> DroppedDelegates;
+
+	/**Heap ordered by priority, then by the order they were scheduled in*/
+	TArray<FOmniScheduledTrace> Queue;
+
+	int32 BudgetOverride = INDEX_NONE;
+	uint64 NextSequence = 0;
+
+	int64 IssuedTraces = 0;
+	int64 DroppedTraces = 0;
+	uint64 TotalWaitFrames = 0;
+};
@@ -0,0 +1,119 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/HitResult.h"
+#include "CollisionQueryParams.h"
+#include "WorldCollision.h"
+
+class UPrimitiveComponent;
+
+/**A primitive that has been baked into a FOmniStaticBVH.
+ * Only holds what is needed to filter and fill in hit results,
+ * nothing in here is resolved while querying.*/
+struct FOmniBVHPrimitive
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	TWeakObjectPtr<AActor> Actor;
+	uint32 ActorId = 0;
+	ECollisionChannel ObjectType = ECC_WorldStatic;
+	FCollisionResponseContainer Responses;
+};
+
+/**Either a triangle (A, B, C) or an axis aligned box (A is min, B is max).*/
+struct FOmniBVHItem
+{
+	FVector3f A = FVector3f::ZeroVector;
+	FVector3f B = FVector3f::ZeroVector;
+	FVector3f C = FVector3f::ZeroVector;
+	int32 PrimitiveIndex = INDEX_NONE;
+	bool bIsBox = false;
+
+	FBox3f GetBounds() const;
+	FVector3f GetCentroid() const;
+};
+
+/**Node bounds are stored as 4 floats each so they can be loaded
+ * straight into vector registers.
+ * Leaves have a @Count above 0 and own the items @FirstIndex to @FirstIndex + @Count.
+ * Interior nodes have their left child right after them, @FirstIndex is the right child.*/
+struct alignas(16) FOmniBVHNode
+{
+	float Min[4] = {0, 0, 0, 0};
+	float Max[4] = {0, 0, 0, 0};
+	int32 FirstIndex = 0;
+	int32 Count = 0;
+};
+
+/**Filters that are applied to every item during a query*/
+struct FOmniBVHQueryFilter
+{
+	ECollisionChannel Channel = ECC_Visibility;
+	FCollisionResponseContainer Responses;
+	TArray<uint32, TInlineAllocator<8>> IgnoredActorIds;
+
+	FOmniBVHQueryFilter() = default;
+	FOmniBVHQueryFilter(ECollisionChannel InChannel, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams);
+};
+
+/**Data gathered on the game thread, which is turned into a FOmniStaticBVH*/
+struct FOmniStaticBVHBuildInput
+{
+	TArray<FOmniBVHPrimitive> Primitives;
+	TArray<FOmniBVHItem> Items;
+};
+
+/**
+ * Immutable bounding volume hierarchy of static geometry.
+ * Once built it is never modified, which makes it safe to query
+ * from any amount of threads at the same time.
+ */
+class OMNITOOLBOX_API FOmniStaticBVH
+{
+public:
+
+	explicit FOmniStaticBVH(FOmniStaticBVHBuildInput&& Input);
+
+	/**Cast a ray, or a sphere when @Radius is above 0, from @Start to @End.
+	 * Single and test casts only report blocking hits. Multi casts behave like physics,
+	 * they report the closest blocking hit and one touch per overlapping component before it.
+	 * @bStopAtFirstHit Return as soon as anything blocking is hit, used for test traces.
+	 * Hits are appended to @OutHits, which is not sorted.*/
+	void Cast(const FVector& Start, const FVector& End, float Radius, const FOmniBVHQueryFilter& Filter, bool bMultiHit,
+		bool bStopAtFirstHit, TArray<FHitResult>& OutHits) const;
+
+	int32 GetNumItems() const { return Items.Num(); }
+	int32 GetNumNodes() const { return Nodes.Num(); }
+	const FBox& GetBounds() const { return Bounds; }
+
+private:
+
+	int32 BuildRecursive(int32 First, int32 Count);
+
+	/**The response between the item and the query, the lowest of the two sides like physics does*/
+	ECollisionResponse GetResponse(const FOmniBVHItem& Item, const FOmniBVHQueryFilter& Filter) const;
+
+	TArray<FOmniBVHPrimitive> Primitives;
+	TArray<FOmniBVHItem> Items;
+	TArray<FOmniBVHNode> Nodes;
+	FBox Bounds = FBox(ForceInit);
+};
+
+/**Every level's BVH at a certain point in time.
+ * Snapshots are never modified, new geometry creates a new snapshot.*/
+struct OMNITOOLBOX_API FOmniStaticBVHSnapshot
+{
+	TArray<TSharedRef<const FOmniStaticBVH, ESPMode::ThreadSafe>> LevelBVHs;
+
+	/**Same behaviour as the UOmniTraceLibrary trace functions.
+	 * Multi results are sorted by distance and end at the first blocking hit, single results only contain
+	 * the closest hit and test results contain an empty hit result.
+	 * Hits are appended to @OutHits, only the appended hits are sorted and truncated.
+	 * Safe to call from any thread.*/
+	void Trace(const FVector& Start, const FVector& End, float Radius, EAsyncTraceType TraceType, const FOmniBVHQueryFilter& Filter,
+		TArray<FHitResult>& OutHits) const;
+};
+
+typedef TSharedPtr<const FOmniStaticBVHSnapshot, ESPMode::ThreadSafe> FOmniStaticBVHSnapshotPtr;
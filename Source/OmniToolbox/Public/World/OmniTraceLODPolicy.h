@@ -0,0 +1,111 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/OmniTraceCacheSubsystem.h"
+#include "OmniTraceLODPolicy.generated.h"
+
+/**How traces are downgraded once they are at least
+ * @MinDistance away from the closest viewer.*/
+USTRUCT(BlueprintType)
+struct FOmniTraceLODLevel
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, Units = "cm"))
+	float MinDistance = 0;
+
+	/**Complex traces are performed against simple collision instead*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+	bool ForceSimpleCollision = false;
+
+	/**Multi traces only return the first blocking hit*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+	bool DowngradeMultiToSingle = false;
+
+	/**Single traces only report whether something was hit, without a location.
+	 * Also applies to multi traces that were downgraded to single.*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+	bool DowngradeSingleToTest = false;
+
+	/**If the same trace was performed less than this many seconds ago,
+	 * its results are reused instead of tracing again. 0 disables it.*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, Units = "s"))
+	float ReuseCooldown = 0;
+
+	/**How far the start and end of a trace can move while still counting as the same trace*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 1, Units = "cm", EditCondition = "ReuseCooldown > 0"))
+	float ReuseTolerance = 50;
+};
+
+/**How much work a single LOD level has saved*/
+USTRUCT(BlueprintType)
+struct FOmniTraceLODCounters
+{
+	GENERATED_BODY()
+
+	/**Traces that ended up at this level*/
+	UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+	int64 Traces = 0;
+
+	/**Complex traces that were performed against simple collision*/
+	UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+	int64 SimplifiedTraces = 0;
+
+	/**Traces whose result type was downgraded*/
+	UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+	int64 DowngradedResults = 0;
+
+	/**Traces that were skipped entirely and reused an earlier result*/
+	UPROPERTY(Category = "", VisibleAnywhere, BlueprintReadOnly)
+	int64 ReusedResults = 0;
+};
+
+/**What a UOmniTraceLODPolicy decided for a single trace*/
+struct FOmniTraceLODDecision
+{
+	/**INDEX_NONE when the trace is performed at full quality*/
+	int32 Level = INDEX_NONE;
+
+	bool bForceSimpleCollision = false;
+	EAsyncTraceResultType ResultType = SingleResult;
+
+	/**Only valid when the level allows results to be reused*/
+	FOmniTraceCacheKey ReuseKey;
+	bool bCanReuse = false;
+};
+
+/**
+ * Downgrades traces based on how far away they are from the closest
+ * local player's view, or from a reference point that has been set manually
+ * through the UOmniTraceLODSubsystem. The distance is measured to the closest point on the trace.
+ *
+ * Assign it to FOmniTraceQuery::LODPolicy. Only the sync and async
+ * "ByQuery" trace functions on the game thread use it.
+ * The policy only holds settings and can be shared between worlds,
+ * everything that changes at runtime lives in each world's UOmniTraceLODSubsystem.
+ * OmniToolbox.Trace.LOD can be used to disable every policy while debugging,
+ * OmniToolbox.Trace.LODStats logs how much each level has saved.
+ */
+UCLASS(BlueprintType)
+class OMNITOOLBOX_API UOmniTraceLODPolicy : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/**The level with the highest MinDistance that the trace is past is used.
+	 * Traces closer than every level are performed at full quality.*/
+	UPROPERTY(Category = "", EditAnywhere, BlueprintReadWrite)
+	TArray<FOmniTraceLODLevel> Levels;
+
+	/**Controlled through OmniToolbox.Trace.LOD*/
+	static bool IsLODEnabled();
+
+	/**The level a trace @Distance away from the viewer falls into,
+	 * INDEX_NONE if it should be performed at full quality.*/
+	int32 FindLevel(double Distance) const;
+};
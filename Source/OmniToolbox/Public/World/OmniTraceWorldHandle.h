@@ -0,0 +1,67 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "World/OmniStaticBVH.h"
+
+class FPhysScene_Chaos;
+class UWorld;
+
+/**Shared between a world and every handle that points to it.
+ * Traces hold the read lock while they run, the world takes the
+ * write lock once when it is cleaned up.*/
+struct FOmniTraceWorldLifetime
+{
+	FRWLock Lock;
+
+	/**Only read or written while holding @Lock*/
+	bool bIsAlive = true;
+};
+
+/**
+ * A world that has been resolved on the game thread, so it can be traced
+ * from worker threads (UE::Tasks, ParallelFor, animation threads etc.)
+ * through the UOmniTraceLibrary "ThreadSafe" functions.
+ *
+ * The handle keeps track of whether the world is still alive.
+ * Cleaning up the world waits for every trace that is still running on it,
+ * and traces started after that simply return without hitting anything.
+ * The physics scene's own read lock is taken by UWorld's scene queries
+ * themselves, through FScopedSceneReadLock, so ExecuteRead doesn't take it.
+ *
+ * Create the handle on the game thread, then copy it into the task.
+ * The handle also holds on to the static BVH snapshot that was current
+ * when it was created, so queries with UseStaticBVH can use it off the game thread.
+ */
+struct OMNITOOLBOX_API FOmniTraceWorldHandle
+{
+	FOmniTraceWorldHandle() = default;
+
+	/**Has to be called on the game thread*/
+	explicit FOmniTraceWorldHandle(const UObject* WorldContextObject);
+
+	/**Whether the world still existed at the time of calling.
+	 * Use @ExecuteRead to make sure it stays alive while using it.*/
+	bool IsValid() const;
+
+	/**Runs @Callable with the world, while making sure it can't be cleaned up in the meantime.
+	 * Returns false without running @Callable if the world is gone.
+	 * Safe to call from any thread.*/
+	bool ExecuteRead(TFunctionRef<void(const UWorld& World)> Callable) const;
+
+	/**The world this handle was created for. It is not safe to use this
+	 * outside of @ExecuteRead, it is only meant for comparisons.*/
+	const UWorld* GetWorldUnsafe() const { return World; }
+
+	/**Snapshot of the UOmniStaticBVHSubsystem at the time the handle was created.
+	 * Invalid if the subsystem doesn't exist or hasn't built anything yet.*/
+	const FOmniStaticBVHSnapshotPtr& GetStaticBVH() const { return StaticBVH; }
+
+private:
+
+	const UWorld* World = nullptr;
+	FPhysScene_Chaos* PhysicsScene = nullptr;
+	TSharedPtr<FOmniTraceWorldLifetime, ESPMode::ThreadSafe> Lifetime;
+	FOmniStaticBVHSnapshotPtr StaticBVH;
+};
@@ -0,0 +1,126 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Commandlets/OmniTraceReplayCommandlet.h"
+#include "OmniToolbox.h"
+#include "Developer/OmniTraceReplay.h"
+#include "Engine/World.h"
+#include "Subsystems/OmniAsyncTraceSubsystem.h"
+#include "UObject/Package.h"
+
+UOmniTraceReplayCommandlet::UOmniTraceReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UOmniTraceReplayCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	FString RecordingPath;
+	FString Paths = TEXT("Sync+Batched+Async");
+	int32 Iterations = 1;
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Recording="), RecordingPath);
+	FParse::Value(*Params, TEXT("Paths="), Paths);
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+
+	if(MapName.IsEmpty() || RecordingPath.IsEmpty())
+	{
+		UE_LOG(LogOmniToolbox, Error, TEXT("OmniTraceReplay: Usage: -run=OmniTraceReplay -Map=<Map> -Recording=<Path> [-Iterations=<N>] [-Paths=Sync+Batched+Async]"));
+		return 1;
+	}
+
+	FOmniTraceRecording Recording;
+	if(!FOmniTraceRecorder::LoadRecording(RecordingPath, Recording))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceReplay: Loaded %d traces over %d frames using %d unique queries"),
+		Recording.Traces.Num(), Recording.NumFrames, Recording.Queries.Num());
+
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if(!World)
+	{
+		UE_LOG(LogOmniToolbox, Error, TEXT("OmniTraceReplay: Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if(!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues InitializationValues;
+		InitializationValues.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+		World->InitWorld(InitializationValues);
+	}
+	World->UpdateWorldComponents(true, false);
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	/**Commandlets don't run the engine loop, so the world is ticked by hand.
+	 * Ticking the world also ticks its tickable subsystems, which includes
+	 * the async trace subsystem, so it must not be ticked a second time here.*/
+	static constexpr float DeltaSeconds = 1.f / 60.f;
+	auto StepFrame = [World]()
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	};
+
+	//Let any remaining streaming and component registration settle before measuring
+	StepFrame();
+
+	const FOmniTraceReplay Replay(Recording);
+	TArray<FOmniTraceReplayReport> Reports;
+
+	for(int32 Iteration = 0; Iteration < FMath::Max(Iterations, 1); ++Iteration)
+	{
+		if(Paths.Contains(TEXT("Sync")))
+		{
+			Reports.Add(Replay.RunSync(World));
+		}
+
+		if(Paths.Contains(TEXT("Batched")))
+		{
+			Reports.Add(Replay.RunBatched(World));
+		}
+
+		if(Paths.Contains(TEXT("Async")))
+		{
+			if(World->GetSubsystem<UOmniAsyncTraceSubsystem>())
+			{
+				Reports.Add(Replay.RunAsync(World, StepFrame));
+			}
+			else
+			{
+				UE_LOG(LogOmniToolbox, Warning, TEXT("OmniTraceReplay: The async trace subsystem does not exist in this world, skipping the async path"));
+			}
+		}
+	}
+
+	for(const FOmniTraceReplayReport& Report : Reports)
+	{
+		UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceReplay: %s"), *Report.ToString());
+	}
+
+	const FString CsvPath = FOmniTraceReplay::WriteReportsToCsv(Reports);
+	if(!CsvPath.IsEmpty())
+	{
+		UE_LOG(LogOmniToolbox, Display, TEXT("OmniTraceReplay: Wrote replay results to %s"), *CsvPath);
+	}
+
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+
+	return 0;
+}
@@ -0,0 +1,29 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OmniTraceReplayCommandlet.generated.h"
+
+/**
+ * Loads a map headless and replays a trace recording made with
+ * OmniToolbox.Trace.StartRecording through the sync, batched and async
+ * trace paths, reporting the throughput and latency percentiles of each.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=OmniTraceReplay -Map=/Game/Maps/MyMap -Recording=<Path> -nullrhi
+ * Optional:
+ * -Iterations=<N> Replay everything N times, the reports of every iteration are written.
+ * -Paths=Sync+Batched+Async Which paths to replay, all of them by default.
+ */
+UCLASS()
+class OMNITOOLBOXEDITOR_API UOmniTraceReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UOmniTraceReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
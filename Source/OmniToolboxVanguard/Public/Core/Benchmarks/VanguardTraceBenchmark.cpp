@@ -0,0 +1,466 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+
+#include "Core/Benchmarks/VanguardTraceBenchmark.h"
+
+#include "OmniToolboxVanguard.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Developer/OmniTraceReplay.h"
+#include "Developer/SpreadsheetHelpers/OmniSpreadsheetObject.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+#include "Subsystems/OmniAsyncTraceSubsystem.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace VanguardTraceBenchmark
+{
+	static constexpr float DeltaSeconds = 1.f / 60.f;
+
+	/**Async traces can take a couple of frames, anything beyond this is considered lost*/
+	static constexpr int32 MaxAsyncFrames = 60;
+
+	using EPath = EVanguardTraceBenchmarkPath;
+
+	const TCHAR* LexToString(EPath Path)
+	{
+		switch(Path)
+		{
+		case EPath::Async: return TEXT("Async");
+		case EPath::Batched: return TEXT("Batched");
+		default: return TEXT("Sync");
+		}
+	}
+
+	const TCHAR* LexToString(EOmniTraceShape Shape)
+	{
+		switch(Shape)
+		{
+		case EOmniTraceShape::Sphere: return TEXT("Sphere");
+		case EOmniTraceShape::Capsule: return TEXT("Capsule");
+		case EOmniTraceShape::Box: return TEXT("Box");
+		default: return TEXT("Line");
+		}
+	}
+
+	const TCHAR* LexToString(EAsyncTraceResultType ResultType)
+	{
+		switch(ResultType)
+		{
+		case MultiResult: return TEXT("Multi");
+		case TestResult: return TEXT("Test");
+		default: return TEXT("Single");
+		}
+	}
+
+	struct FMeasurement
+	{
+		double Seconds = 0;
+		int32 NumResults = 0;
+		int32 NumLostAsyncTraces = 0;
+	};
+
+	UWorld* CreateScene(const FVanguardTraceBenchmarkSettings& Settings, EComponentMobility::Type Mobility)
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("VanguardTraceBenchmark"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		const FVector GridOrigin(-Settings.GridSize * Settings.Spacing * 0.5, -Settings.GridSize * Settings.Spacing * 0.5, 0);
+		for(int32 X = 0; X < Settings.GridSize; ++X)
+		{
+			for(int32 Y = 0; Y < Settings.GridSize; ++Y)
+			{
+				AActor* Actor = World->SpawnActor<AActor>();
+				const FVector Location = GridOrigin + FVector(X * Settings.Spacing, Y * Settings.Spacing, 0);
+
+				//Alternate between boxes and spheres
+				UShapeComponent* Shape = nullptr;
+				if((X + Y) % 2 == 0)
+				{
+					UBoxComponent* Box = NewObject<UBoxComponent>(Actor);
+					Box->SetBoxExtent(FVector(50));
+					Shape = Box;
+				}
+				else
+				{
+					USphereComponent* Sphere = NewObject<USphereComponent>(Actor);
+					Sphere->SetSphereRadius(50);
+					Shape = Sphere;
+				}
+
+				Shape->SetMobility(Mobility);
+				Shape->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+				Shape->SetWorldLocation(Location);
+				Actor->SetRootComponent(Shape);
+				Shape->RegisterComponent();
+			}
+		}
+
+		return World;
+	}
+
+	void DestroyScene(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	void MakeRequests(const FVanguardTraceBenchmarkSettings& Settings, EOmniTraceShape Shape, EAsyncTraceResultType ResultType,
+		int32 NumQueries, TArray<FOmniTraceRequest>& OutRequests)
+	{
+		//Same seed for every combination, so every path traces the exact same queries
+		FRandomStream RandomStream(Settings.Seed);
+		const float HalfSize = Settings.GridSize * Settings.Spacing * 0.5f;
+
+		OutRequests.Reset(NumQueries);
+		for(int32 Index = 0; Index < NumQueries; ++Index)
+		{
+			FOmniTraceRequest& Request = OutRequests.AddDefaulted_GetRef();
+			Request.Shape = Shape;
+			Request.ResultType = ResultType;
+			Request.Start = FVector(RandomStream.FRandRange(-HalfSize, HalfSize), RandomStream.FRandRange(-HalfSize, HalfSize), 0);
+			Request.End = FVector(RandomStream.FRandRange(-HalfSize, HalfSize), RandomStream.FRandRange(-HalfSize, HalfSize), 0);
+			Request.Rotation = FRotator(0, RandomStream.FRandRange(0, 360), 0);
+			Request.Radius = 25;
+			Request.HalfHeight = 50;
+			Request.Extent = FVector(25);
+		}
+	}
+
+	FMeasurement Measure(UWorld* World, EPath Path, const TArray<FOmniTraceRequest>& Requests, const FOmniTraceQuery& Query,
+		FOmniBatchTraceResult& BatchResults)
+	{
+		FMeasurement Measurement;
+		const FTraceDebug DebugOptions;
+
+		switch(Path)
+		{
+		case EPath::Sync:
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				for(const FOmniTraceRequest& Request : Requests)
+				{
+					Measurement.NumResults += UOmniTraceLibrary::TraceByQuery(World, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+						Request.MakeCollisionShape(), Request.ResultType, Query, DebugOptions).Num();
+				}
+				Measurement.Seconds = FPlatformTime::Seconds() - StartTime;
+				break;
+			}
+		case EPath::Batched:
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				UOmniTraceLibrary::BatchTraceByQuery(World, Requests, Query, BatchResults, DebugOptions);
+				Measurement.Seconds = FPlatformTime::Seconds() - StartTime;
+				Measurement.NumResults = BatchResults.HitResults.Num();
+				break;
+			}
+		case EPath::Async:
+			{
+				if(!World->GetSubsystem<UOmniAsyncTraceSubsystem>())
+				{
+					Measurement.NumLostAsyncTraces = Requests.Num();
+					break;
+				}
+
+				const TStrongObjectPtr<UOmniTraceReplayListener> Listener(NewObject<UOmniTraceReplayListener>());
+				FAsyncTraceResultDelegate OnTraceCompleted;
+				OnTraceCompleted.BindUFunction(Listener.Get(), GET_FUNCTION_NAME_CHECKED(UOmniTraceReplayListener, OnTraceCompleted));
+
+				/**The world is not part of the engine loop, so it is ticked by hand.
+				 * Ticking the world also ticks its tickable subsystems, which submits
+				 * and dispatches the async traces. The time includes those ticks,
+				 * which is the cost of an async trace from the point of view of the game thread.*/
+				const double StartTime = FPlatformTime::Seconds();
+				for(const FOmniTraceRequest& Request : Requests)
+				{
+					UOmniTraceLibrary::AsyncTraceByQuery(World, Request.Shape, Request.Start, Request.End, FQuat(Request.Rotation),
+						Request.MakeCollisionShape(), Request.ResultType, Query, OnTraceCompleted, DebugOptions);
+				}
+				Listener->AddFrame(Requests.Num());
+
+				for(int32 Frame = 0; Frame < MaxAsyncFrames && Listener->HasPendingTraces(); ++Frame)
+				{
+					World->Tick(LEVELTICK_All, DeltaSeconds);
+				}
+				Measurement.Seconds = FPlatformTime::Seconds() - StartTime;
+				Measurement.NumResults = Listener->NumResults;
+				Measurement.NumLostAsyncTraces = Listener->NumPending;
+
+				if(Listener->HasPendingTraces())
+				{
+					UE_LOG(LogVanguard, Warning, TEXT("TraceBenchmark: %d async traces never completed"), Listener->NumPending);
+				}
+				break;
+			}
+		}
+
+		return Measurement;
+	}
+}
+
+FString FVanguardTraceBenchmarkRow::GetKey() const
+{
+	using namespace VanguardTraceBenchmark;
+	return FString::Printf(TEXT("%s/%s/%s/%s/%d"), *Scene, LexToString(Shape), LexToString(ResultType), LexToString(Path), NumQueries);
+}
+
+const FVanguardTraceBenchmarkRow* FVanguardTraceBenchmarkReport::FindRow(const FString& Scene, EOmniTraceShape Shape,
+	EAsyncTraceResultType ResultType, EVanguardTraceBenchmarkPath Path, int32 NumQueries) const
+{
+	return Rows.FindByPredicate([&](const FVanguardTraceBenchmarkRow& Row)
+	{
+		return Row.Scene == Scene && Row.Shape == Shape && Row.ResultType == ResultType && Row.Path == Path && Row.NumQueries == NumQueries;
+	});
+}
+
+FVanguardTraceBenchmarkReport FVanguardTraceBenchmark::Run(const FVanguardTraceBenchmarkSettings& Settings)
+{
+	using namespace VanguardTraceBenchmark;
+	namespace Headers = VanguardSpreadSheet::TraceBenchmarkHeaders;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(FVanguardTraceBenchmark::Run);
+
+	const TStrongObjectPtr<UOmniSpreadsheetObject> Spreadsheet(NewObject<UOmniSpreadsheetObject>());
+	Spreadsheet->Initialize(TArray<FString>
+	{
+		Headers::Scene,
+		Headers::Shape,
+		Headers::ResultType,
+		Headers::Path,
+		Headers::Queries,
+		Headers::TotalMs,
+		Headers::MicrosecondsPerQuery,
+		Headers::QueriesPerSecond,
+		Headers::Results
+	},
+		false,
+		VanguardSpreadSheet::Directory / TEXT("TraceBenchmark"));
+
+	const FOmniTraceQuery Query = UOmniTraceLibrary::MakeTraceQuery(UCollisionProfile::BlockAll_ProfileName, FOmniTraceChannelSettings(), TArray<AActor*>());
+
+	FVanguardTraceBenchmarkReport Report;
+	TArray<FOmniTraceRequest> Requests;
+	FOmniBatchTraceResult BatchResults;
+
+	const EComponentMobility::Type Mobilities[] = { EComponentMobility::Static, EComponentMobility::Movable };
+	const EOmniTraceShape Shapes[] = { EOmniTraceShape::Line, EOmniTraceShape::Sphere, EOmniTraceShape::Capsule, EOmniTraceShape::Box };
+	const EAsyncTraceResultType ResultTypes[] = { MultiResult, SingleResult, TestResult };
+	const EPath Paths[] = { EPath::Sync, EPath::Async, EPath::Batched };
+
+	for(const EComponentMobility::Type Mobility : Mobilities)
+	{
+		const FString SceneName = FString::Printf(TEXT("%dx%d %s"), Settings.GridSize, Settings.GridSize,
+			Mobility == EComponentMobility::Static ? TEXT("Static") : TEXT("Movable"));
+
+		UWorld* World = CreateScene(Settings, Mobility);
+
+		//Let the physics scene settle before measuring anything
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+
+		for(const EOmniTraceShape Shape : Shapes)
+		{
+			for(const EAsyncTraceResultType ResultType : ResultTypes)
+			{
+				for(const int32 NumQueries : Settings.QueryCounts)
+				{
+					MakeRequests(Settings, Shape, ResultType, NumQueries, Requests);
+
+					for(const EPath Path : Paths)
+					{
+						FMeasurement Best;
+						Best.Seconds = TNumericLimits<double>::Max();
+						for(int32 Repetition = 0; Repetition < FMath::Max(Settings.Repetitions, 1); ++Repetition)
+						{
+							const FMeasurement Measurement = Measure(World, Path, Requests, Query, BatchResults);
+							Report.NumLostAsyncTraces += Measurement.NumLostAsyncTraces;
+							if(Measurement.Seconds < Best.Seconds)
+							{
+								Best = Measurement;
+							}
+						}
+
+						FVanguardTraceBenchmarkRow& ReportRow = Report.Rows.AddDefaulted_GetRef();
+						ReportRow.Scene = SceneName;
+						ReportRow.Shape = Shape;
+						ReportRow.ResultType = ResultType;
+						ReportRow.Path = Path;
+						ReportRow.NumQueries = NumQueries;
+						ReportRow.Seconds = Best.Seconds;
+						ReportRow.NumResults = Best.NumResults;
+
+						const int32 Row = Spreadsheet->AddRowByName(SceneName, false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::Shape, LexToString(Shape), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::ResultType, LexToString(ResultType), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::Path, LexToString(Path), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::Queries, FString::FromInt(NumQueries), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::TotalMs, FString::Printf(TEXT("%.4f"), Best.Seconds * 1000.0), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::MicrosecondsPerQuery,
+							FString::Printf(TEXT("%.4f"), ReportRow.GetMicrosecondsPerQuery()), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::QueriesPerSecond,
+							FString::Printf(TEXT("%.0f"), Best.Seconds > 0 ? NumQueries / Best.Seconds : 0.0), false);
+						Spreadsheet->EditCellByColumnName(Row, Headers::Results, FString::FromInt(Best.NumResults), false);
+					}
+				}
+			}
+		}
+
+		DestroyScene(World);
+	}
+
+	if(!Spreadsheet->Save())
+	{
+		UE_LOG(LogVanguard, Warning, TEXT("TraceBenchmark: Failed to write %s"), *Spreadsheet->FilePath);
+		return Report;
+	}
+
+	UE_LOG(LogVanguard, Display, TEXT("TraceBenchmark: Wrote results to %s"), *Spreadsheet->FilePath);
+	Report.SpreadsheetPath = Spreadsheet->FilePath;
+	return Report;
+}
+
+FString FVanguardTraceBenchmark::GetBaselinePath()
+{
+	return FPaths::ProjectSavedDir() / VanguardSpreadSheet::Directory / TEXT("TraceBenchmarkBaseline.txt");
+}
+
+bool FVanguardTraceBenchmark::LoadBaseline(TMap<FString, double>& OutMicrosecondsPerQuery)
+{
+	OutMicrosecondsPerQuery.Reset();
+
+	TArray<FString> Lines;
+	if(!FFileHelper::LoadFileToStringArray(Lines, *GetBaselinePath()))
+	{
+		return false;
+	}
+
+	//Every line is Key=MicrosecondsPerQuery
+	for(const FString& Line : Lines)
+	{
+		FString Key;
+		FString Value;
+		if(Line.Split(TEXT("="), &Key, &Value))
+		{
+			OutMicrosecondsPerQuery.Add(Key, FCString::Atod(*Value));
+		}
+	}
+
+	return OutMicrosecondsPerQuery.Num() > 0;
+}
+
+bool FVanguardTraceBenchmark::SaveBaseline(const FVanguardTraceBenchmarkReport& Report)
+{
+	TArray<FString> Lines;
+	Lines.Reserve(Report.Rows.Num());
+	for(const FVanguardTraceBenchmarkRow& Row : Report.Rows)
+	{
+		Lines.Add(FString::Printf(TEXT("%s=%.4f"), *Row.GetKey(), Row.GetMicrosecondsPerQuery()));
+	}
+
+	if(!FFileHelper::SaveStringArrayToFile(Lines, *GetBaselinePath()))
+	{
+		UE_LOG(LogVanguard, Warning, TEXT("TraceBenchmark: Failed to write the baseline to %s"), *GetBaselinePath());
+		return false;
+	}
+
+	UE_LOG(LogVanguard, Display, TEXT("TraceBenchmark: Wrote the baseline to %s"), *GetBaselinePath());
+	return true;
+}
+
+static FAutoConsoleCommand VanguardTraceBenchmarkCommand(
+	TEXT("OmniToolbox.Vanguard.TraceBenchmark"),
+	TEXT("Benchmark the sync, async and batched trace paths against a synthetic scene and write the results to a spreadsheet. ")
+	TEXT("Optional: GridSize=<N> Queries=<N,N,...> Repetitions=<N> UpdateBaseline"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FVanguardTraceBenchmarkSettings Settings;
+		const FString Params = FString::Join(Args, TEXT(" "));
+		FParse::Value(*Params, TEXT("GridSize="), Settings.GridSize);
+		FParse::Value(*Params, TEXT("Repetitions="), Settings.Repetitions);
+
+		FString QueryCounts;
+		if(FParse::Value(*Params, TEXT("Queries="), QueryCounts, false))
+		{
+			TArray<FString> Counts;
+			QueryCounts.ParseIntoArray(Counts, TEXT(","));
+			Settings.QueryCounts.Reset();
+			for(const FString& Count : Counts)
+			{
+				Settings.QueryCounts.Add(FCString::Atoi(*Count));
+			}
+		}
+
+		Settings.GridSize = FMath::Max(Settings.GridSize, 1);
+		const FVanguardTraceBenchmarkReport Report = FVanguardTraceBenchmark::Run(Settings);
+
+		if(FParse::Param(*Params, TEXT("UpdateBaseline")))
+		{
+			FVanguardTraceBenchmark::SaveBaseline(Report);
+		}
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVanguardTraceBenchmarkTest, "OmniToolbox.Vanguard.TraceBenchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FVanguardTraceBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace VanguardTraceBenchmark;
+
+	const FVanguardTraceBenchmarkSettings Settings;
+	const FVanguardTraceBenchmarkReport Report = FVanguardTraceBenchmark::Run(Settings);
+
+	TestEqual(TEXT("Async traces that did not complete within the frame limit"), Report.NumLostAsyncTraces, 0);
+
+	//Every path traces the exact same queries, so they have to agree with the sync path
+	for(const FVanguardTraceBenchmarkRow& Row : Report.Rows)
+	{
+		/**Async test traces report their outcome through the hit result
+		 * array of the async trace system, which does not follow the sync
+		 * and batched paths, so only their timing is compared.*/
+		if(Row.Path == EPath::Sync || (Row.Path == EPath::Async && Row.ResultType == TestResult))
+		{
+			continue;
+		}
+
+		const FVanguardTraceBenchmarkRow* SyncRow = Report.FindRow(Row.Scene, Row.Shape, Row.ResultType, EPath::Sync, Row.NumQueries);
+		if(TestNotNull(*FString::Printf(TEXT("Sync row of %s"), *Row.GetKey()), SyncRow))
+		{
+			TestEqual(*FString::Printf(TEXT("Results of %s"), *Row.GetKey()), Row.NumResults, SyncRow->NumResults);
+		}
+	}
+
+	TMap<FString, double> Baseline;
+	if(!FVanguardTraceBenchmark::LoadBaseline(Baseline))
+	{
+		//Nothing to compare against on the first run, this run becomes the baseline
+		FVanguardTraceBenchmark::SaveBaseline(Report);
+		AddInfo(FString::Printf(TEXT("No baseline found, wrote one to %s"), *FVanguardTraceBenchmark::GetBaselinePath()));
+		return true;
+	}
+
+	for(const FVanguardTraceBenchmarkRow& Row : Report.Rows)
+	{
+		const double* BaselineMicroseconds = Baseline.Find(Row.GetKey());
+		if(!BaselineMicroseconds)
+		{
+			AddInfo(FString::Printf(TEXT("%s is not part of the baseline"), *Row.GetKey()));
+			continue;
+		}
+
+		const double MaxMicroseconds = *BaselineMicroseconds * (1.0 + Settings.MaxSlowdown);
+		TestTrue(*FString::Printf(TEXT("%s takes %.4fus per query, the baseline is %.4fus"), *Row.GetKey(),
+			Row.GetMicrosecondsPerQuery(), *BaselineMicroseconds), Row.GetMicrosecondsPerQuery() <= MaxMicroseconds);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,109 @@
+﻿// Copyright (C) Varian Daemon 2025. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FunctionLibraries/OmniTraceLibrary.h"
+
+namespace VanguardSpreadSheet
+{
+	namespace TraceBenchmarkHeaders
+	{
+		inline FString Scene = "Scene";
+		inline FString Shape = "Shape";
+		inline FString ResultType = "Result Type";
+		inline FString Path = "Path";
+		inline FString Queries = "Queries";
+		inline FString TotalMs = "Total ms";
+		inline FString MicrosecondsPerQuery = "us per query";
+		inline FString QueriesPerSecond = "Queries per second";
+		inline FString Results = "Results";
+	}
+}
+
+enum class EVanguardTraceBenchmarkPath : uint8
+{
+	Sync,
+	Async,
+	Batched
+};
+
+struct FVanguardTraceBenchmarkSettings
+{
+	/**The scene is a grid of GridSize x GridSize boxes and spheres*/
+	int32 GridSize = 16;
+	float Spacing = 300;
+
+	/**Every combination of shape, result type and path is measured at each of these query counts*/
+	TArray<int32> QueryCounts = { 64, 256, 1024, 4096 };
+
+	/**How many times every measurement is repeated, the fastest run is kept*/
+	int32 Repetitions = 3;
+
+	int32 Seed = 1337;
+
+	/**The automation test fails a measurement that is this much slower than
+	 * the baseline, 0.5 being 50% slower. Timings are noisy, so keep it generous.*/
+	float MaxSlowdown = 0.5f;
+};
+
+/**The fastest run of a single combination of scene, shape, result type, path and query count*/
+struct FVanguardTraceBenchmarkRow
+{
+	FString Scene;
+	EOmniTraceShape Shape = EOmniTraceShape::Line;
+	EAsyncTraceResultType ResultType = SingleResult;
+	EVanguardTraceBenchmarkPath Path = EVanguardTraceBenchmarkPath::Sync;
+	int32 NumQueries = 0;
+
+	double Seconds = 0;
+	int32 NumResults = 0;
+
+	double GetMicrosecondsPerQuery() const { return NumQueries > 0 ? Seconds * 1000000.0 / NumQueries : 0.0; }
+
+	/**Identifies the row in the baseline*/
+	FString GetKey() const;
+};
+
+struct FVanguardTraceBenchmarkReport
+{
+	TArray<FVanguardTraceBenchmarkRow> Rows;
+
+	/**Async traces that did not complete within the frame limit, across every measurement*/
+	int32 NumLostAsyncTraces = 0;
+
+	/**Empty if the spreadsheet could not be written*/
+	FString SpreadsheetPath;
+
+	const FVanguardTraceBenchmarkRow* FindRow(const FString& Scene, EOmniTraceShape Shape, EAsyncTraceResultType ResultType,
+		EVanguardTraceBenchmarkPath Path, int32 NumQueries) const;
+};
+
+/**
+ * Measures the throughput of the UOmniTraceLibrary trace paths (sync, async and batched)
+ * for every shape and result type, against a synthetic scene inside of its own world.
+ * The scene is built twice, once with static and once with movable primitives.
+ *
+ * The world is created and ticked by the benchmark itself, so it does not need
+ * a map or a renderer and works under -nullrhi. It runs as the OmniToolbox.Vanguard.TraceBenchmark
+ * automation test, which fails if async traces are lost, if the paths disagree on
+ * the amount of results or if a measurement is slower than the stored baseline:
+ * UnrealEditor-Cmd.exe <Project> -nullrhi -ExecCmds="Automation RunTests OmniToolbox.Vanguard.TraceBenchmark;Quit"
+ *
+ * The console command of the same name only writes the spreadsheet, or replaces the baseline with UpdateBaseline.
+ * The results are written through a UOmniSpreadsheetObject into Saved/Automation/Vanguard/TraceBenchmark.
+ */
+class OMNITOOLBOXVANGUARD_API FVanguardTraceBenchmark
+{
+public:
+
+	static FVanguardTraceBenchmarkReport Run(const FVanguardTraceBenchmarkSettings& Settings);
+
+	/**The baseline is machine specific, so it lives in the saved directory instead of the plugin*/
+	static FString GetBaselinePath();
+
+	/**Microseconds per query of every row, by their key. Returns false if there is no baseline yet.*/
+	static bool LoadBaseline(TMap<FString, double>& OutMicrosecondsPerQuery);
+
+	static bool SaveBaseline(const FVanguardTraceBenchmarkReport& Report);
+};